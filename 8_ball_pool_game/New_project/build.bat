@@ -3,9 +3,12 @@ echo Building 8-Ball Pool...
 
 set RAYLIB=C:\raylib\raylib\src
 
-gcc -std=c99 -O2 src/main.c src/game.c src/graphics.c src/physics.c src/utils.c ^
+gcc -std=c11 -O2 src/main.c src/game.c src/graphics.c src/physics.c src/utils.c src/telemetry.c ^
+    src/jobs.c src/solver.c src/kernels.c src/kernels_x86.c src/stream.c src/input.c src/pipeline.c ^
+    src/sim.c src/mapfile.c src/atlas.c src/potlut.c src/autosave.c src/latency.c src/runahead.c src/policy.c src/layouts.c src/table.c src/cache.c src/ai.c src/odds.c src/rewind.c ^
+    src/script.c src/procmem.c src/placement.c src/governor.c ^
     -I./include -I%RAYLIB% ^
-    -L%RAYLIB% -lraylib -lopengl32 -lgdi32 -lwinmm ^
+    -L%RAYLIB% -lraylib -lopengl32 -lgdi32 -lwinmm -lpthread ^
     -o 8ball_pool.exe
 
 if %ERRORLEVEL% == 0 (
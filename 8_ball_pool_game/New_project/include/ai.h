@@ -0,0 +1,40 @@
+#ifndef AI_H
+#define AI_H
+
+#include "sim.h"
+
+// Computer shot selection: every shot on a SEARCH_ANGLE_STEPS x
+// SEARCH_POWER_STEPS grid is simulated headlessly across the job pool and
+// scored for the player to move. Results go through the shot cache, so
+// positions and shots seen before cost a lookup instead of a simulation.
+// SearchPotShots tries only the aims the pot table offers, for callers that
+// can settle for a clean pot when there is one; SearchShotPolicy only the
+// short list a trained policy proposes; SearchShotLayouts only the shots of
+// the nearest solved layouts. SearchShotScreened runs the whole grid at
+// screening fidelity and only its top shots exactly.
+
+typedef struct {
+    float angle;
+    float speed;
+    float score;
+    ShotOutcome outcome;
+} ShotChoice;
+
+typedef struct {
+    int simulated;      // shots actually run
+    int cached;         // shots answered by the cache
+    int screened;       // shots run only at screening fidelity
+    double seconds;
+} SearchStats;
+
+float ScoreOutcome(const Game *game, const ShotOutcome *outcome);
+bool  SearchShot(const Game *game, ShotChoice *best, SearchStats *stats);
+bool  SearchShotCoarse(const Game *game, unsigned long long stateHash, int angleStride, int powerStride,
+                       ShotChoice *best);
+bool  SearchShotScreened(const Game *game, int confirm, ShotChoice *best, SearchStats *stats);
+bool  SearchShotPolicy(const Game *game, ShotChoice *best, SearchStats *stats);
+bool  SearchShotLayouts(const Game *game, ShotChoice *best, SearchStats *stats);
+bool  SearchPotShots(const Game *game, unsigned long long stateHash, ShotChoice *best, SearchStats *stats);
+bool  ChooseCuePlacement(const Game *game, Vector2 *position, SearchStats *stats);
+
+#endif // AI_H
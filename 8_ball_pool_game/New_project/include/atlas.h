@@ -0,0 +1,60 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "common.h"
+#include "mapfile.h"
+
+// Precomputed break outcomes. The rack from ResetBalls never changes, so a
+// break depends only on cue position, angle and power; pool_break_atlas
+// simulates a grid of those offline and the game maps the result file.
+//
+// Grid axes: 0 = cue x, 1 = cue y, 2 = angle (radians, wraps when the range
+// is a full turn), 3 = power as a fraction of MAX_SHOT_SPEED.
+
+#define BREAK_ATLAS_VERSION 1
+#define BREAK_LAYOUT_QUANT 4        // final positions in 1/4 pixel
+
+#define BREAK_SCRATCH 1
+#define BREAK_EIGHT   2
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash() of the generating build
+    int dims[4];
+    float minValue[4];
+    float maxValue[4];
+    unsigned int recordSize;
+    unsigned int recordCount;
+} BreakAtlasHeader;
+
+typedef struct {
+    unsigned short pocketed;        // mask of balls pocketed on the break
+    unsigned char flags;
+    unsigned char ballsPocketed;
+    unsigned short x[MAX_BALLS];
+    unsigned short y[MAX_BALLS];
+} BreakRecord;
+
+typedef struct {
+    MappedFile file;
+    const BreakAtlasHeader *header;
+    const BreakRecord *records;
+} BreakAtlas;
+
+void  BreakAtlasInitHeader(BreakAtlasHeader *h, const int dims[4], const float minValue[4], const float maxValue[4]);
+float BreakAtlasAxisValue(const BreakAtlasHeader *h, int axis, int i);
+int   BreakAtlasIndex(const BreakAtlasHeader *h, const int cell[4]);
+
+bool BreakAtlasOpen(BreakAtlas *atlas, const char *path);
+void BreakAtlasClose(BreakAtlas *atlas);
+const BreakRecord *BreakAtlasNearest(const BreakAtlas *atlas, Vector2 cue, float angle, float power);
+bool BreakAtlasEstimate(const BreakAtlas *atlas, Vector2 cue, float angle, float power,
+                        float *expectedPocketed, float *scratchChance);
+void BreakRecordApply(const BreakRecord *r, Game *game);
+
+// Atlas shared by the game, loaded once at startup
+bool BreakAtlasLoadDefault(const char *path);
+const BreakAtlas *GetBreakAtlas(void);
+
+#endif // ATLAS_H
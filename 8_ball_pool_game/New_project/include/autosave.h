@@ -0,0 +1,42 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include "common.h"
+
+// Crash recovery. The table is snapshotted whenever a shot comes to rest:
+// the simulation thread copies the Game into whichever of two buffers the
+// writer thread is not reading and returns, and the writer puts the newest
+// snapshot on disk beside the save and swaps it in with FileReplace. A
+// snapshot taken while the writer is busy replaces any still waiting, so the
+// file always ends up holding the latest shot boundary.
+
+#define AUTOSAVE_VERSION 1
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash(): a save only resumes on the same rules and physics
+    unsigned int gameSize;          // sizeof(Game)
+    unsigned int sequence;          // snapshots taken this session
+    unsigned int checksum;          // FNV-1a of the Game bytes
+} AutosaveHeader;
+
+typedef struct {
+    int snapshots;                  // taken on the simulation thread
+    int written;
+    int coalesced;                  // replaced by a newer one before they were written
+    int failed;
+    double snapshotMicrosLast, snapshotMicrosMax, snapshotMicrosSum;
+    double writeMillisLast, writeMillisMax;
+} AutosaveReport;
+
+bool AutosaveStart(const char *path);
+void AutosaveShot(const Game *game);             // at a shot boundary; a copy and a signal
+void AutosaveStop(void);                         // writes any snapshot still waiting
+
+// A saved match worth resuming: intact, from this build, and not over
+bool AutosaveLoad(const char *path, Game *game);
+
+void AutosavePrintReport(FILE *out);
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,35 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "sim.h"
+
+// Shared transposition cache for shot simulations: (state hash, quantized
+// shot) -> ShotOutcome. Fixed size and lock-free, so any number of search
+// threads can probe and fill it at once. Shots are quantized to
+// SHOT_ANGLE_QUANT / SHOT_SPEED_QUANT buckets; callers that need exact
+// answers should simulate the bucket's canonical shot (ShotCacheCanonical).
+// Until ShotCacheInit is called every lookup misses and stores are dropped.
+
+typedef struct {
+    long long lookups;
+    long long hits;
+    long long stores;
+    long long overwrites;      // stores that evicted a different key
+    int slots;
+    int used;
+    size_t bytes;
+} ShotCacheReport;
+
+bool ShotCacheInit(int slotsLog2);
+void ShotCacheShutdown(void);
+void ShotCacheClear(void);
+
+unsigned long long ShotCacheKey(unsigned long long stateHash, float angle, float speed);
+void ShotCacheCanonical(float *angle, float *speed);
+bool ShotCacheLookup(unsigned long long key, ShotOutcome *out);
+void ShotCacheStore(unsigned long long key, const ShotOutcome *outcome);
+
+void ShotCacheGetReport(ShotCacheReport *report);
+void ShotCachePrintReport(FILE *f);
+
+#endif // CACHE_H
@@ -50,6 +50,54 @@ typedef struct {
     char name[20];
 } Player;
 
+// Per-shot counters, reset when a shot is taken and filled in by the physics step
+typedef struct {
+    int player;
+    int ballContacts;
+    int railHits;
+    int speedClamps;
+    int pocketEvents;
+    int framesToRest;
+    float peakSpeed;
+    float peakCueSpeed;
+    float shotAngle;
+    float shotSpeed;
+} ShotStats;
+
+// What the physics step reports to rules, telemetry and audio
+typedef enum {
+    EVENT_CONTACT,      // a, b: balls; value: impulse along the contact normal
+    EVENT_RAIL,         // a: ball; b: bounces this step; value: speed after
+    EVENT_POCKET,       // a: ball; b: pocket index
+    EVENT_REST          // a: ball that just stopped
+} EventType;
+
+typedef struct {
+    unsigned char type;
+    unsigned char a;
+    unsigned char b;
+    float value;
+    Vector2 position;
+} PhysicsEvent;
+
+// Fixed ring the physics step writes into and the consumers drain after the
+// step. Stored inline so a Game stays a plain value that copies freely.
+typedef struct {
+    PhysicsEvent items[EVENT_RING_SIZE];
+    unsigned int head;      // next event to consume
+    unsigned int tail;      // next free slot
+    int dropped;            // events lost to a full ring
+} EventRing;
+
+// Balls bucketed by cell for ball-in-hand checks (placement.h)
+#define BALL_GRID_COLS (TABLE_WIDTH / BALL_GRID_CELL + 1)
+#define BALL_GRID_ROWS (TABLE_HEIGHT / BALL_GRID_CELL + 1)
+
+typedef struct {
+    signed char head[BALL_GRID_ROWS][BALL_GRID_COLS];   // first ball in the cell, -1 if empty
+    signed char next[MAX_BALLS];
+} BallGrid;
+
 typedef struct {
     Ball balls[MAX_BALLS];
     Player players[2];
@@ -68,6 +116,27 @@ typedef struct {
     float stickLength;
     bool stickRecoil;
     float recoilTimer;
+
+    int shotNumber;
+    bool shotPending;
+    ShotStats shotStats;
+
+    int playbackSpeed;      // simulation steps per frame
+    bool skipToRest;
+
+    Vector2 mousePos;       // last sampled mouse position, for drawing the stick
+    bool headless;          // simulation copy: no telemetry or other side effects
+    int physicsStride;      // simulation copy: steps one coarse physics step may stand for; 0 or 1 is exact
+
+    bool scrubbing;         // paused on a rewound frame
+    int scrubFrame;
+    int scrubFrames;
+
+    bool placementHelp;     // heatmap of where to put the cue ball on ball in hand
+    bool cueGridReady;      // cueGrid holds the object balls of this ball in hand
+    BallGrid cueGrid;
+
+    EventRing events;       // filled by UpdatePhysics, drained by StepSimulation
 } Game;
 
 // Shared pocket positions (used by graphics and game logic)
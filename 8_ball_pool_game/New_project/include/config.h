@@ -10,6 +10,15 @@
 #define TABLE_HEIGHT 400
 #define RAIL_WIDTH 40
 
+// Pocket mouths and jaws
+#define CORNER_MOUTH 30.0f          // corner to the end of each cushion
+#define SIDE_MOUTH 24.0f            // half-width of a side pocket mouth
+#define JAW_LENGTH 24.0f
+#define JAW_NOSE_RADIUS 2.0f
+#define POCKET_DROP_RADIUS 20.0f    // ball centre this close to a pocket point drops
+#define TABLE_MAX_CUSHIONS 32
+#define TABLE_MAX_BOUNCES 4
+
 // Balls
 #define MAX_BALLS 16
 #define BALL_RADIUS 15
@@ -19,6 +28,17 @@
 #define FRICTION 0.985f
 #define MIN_VELOCITY 0.06f
 #define MAX_BALL_SPEED 26.0f
+#define RAIL_RESTITUTION 0.86f
+#define MAX_PLAYBACK_SPEED 8
+#define FAST_FORWARD_MAX_STEPS 20000
+#define EVENT_RING_SIZE 128        // physics events per step; a power of two
+
+// Contact solver
+#define SOLVER_MAX_COLORS 32
+#define SOLVER_SWEEP_MIN 64        // ball count above which pairs are found by sort and sweep
+#define SOLVER_PARALLEL_MIN 256    // batch size above which a batch is split across the job pool
+#define SOLVER_CHUNK 64
+#define JOBS_MAX_THREADS 64
 
 // Shot power
 #define MAX_POWER_PIXELS 160.0f
@@ -28,4 +48,103 @@
 #define STICK_LENGTH 120.0f
 #define STICK_RECOIL_TIME 0.12f
 
+// Shot search
+#define SEARCH_ANGLE_STEPS 180
+#define SEARCH_POWER_STEPS 6
+#define STATE_QUANT 0.25f          // px grid ball positions snap to in the state hash
+#define SHOT_ANGLE_QUANT 8192      // angle buckets per turn in shot cache keys
+#define SHOT_SPEED_QUANT 256       // speed buckets up to MAX_SHOT_SPEED
+#define SHOT_CACHE_SLOTS_LOG2 18   // 16 bytes per slot
+
+// Learned shot policy
+#define POLICY_SHORTLIST 8         // grid shots the policy proposes and the search verifies
+#define POLICY_HIDDEN 128          // width of the hidden layers pool_policy trains
+
+// Multi-fidelity rollouts
+#define COARSE_STRIDE 4            // physics steps a screening step may stand for
+#define COARSE_MAX_TRAVEL 12.0f    // pixels a ball may cover in one screening step; under a radius, so no contact is skipped
+#define SCREEN_CONFIRM_TOP 32      // screened favourites re-simulated at full fidelity
+
+// Solved-layout library
+#define LAYOUT_NEIGHBOURS 4        // nearest solved layouts whose shots are tried on the live table
+#define LAYOUT_MAX_VISITS 2048     // tree nodes a query may compare before settling
+
+// Physics kernels
+#define KERNELS_ENV "POOL_KERNELS"     // scalar, sse4.2 or avx2 forces that backend
+#define KERNELS_BENCH_TABLES 64        // synthetic tables the startup self-benchmark steps
+#define KERNELS_BENCH_REPEATS 20       // passes over them per timed round
+#define KERNELS_BENCH_ROUNDS 5         // the best round counts
+
+// Shot odds while aiming
+#define ODDS_ANGLE_NOISE 0.8f      // degrees, standard deviation of the player's aim
+#define ODDS_POWER_NOISE 0.06f     // standard deviation as a fraction of shot speed
+#define ODDS_BATCH 32              // samples simulated per refinement step
+#define ODDS_MAX_SAMPLES 512
+
+// Precomputed data
+#define BREAK_ATLAS_PATH "break_atlas.bin"
+#define POT_LUT_PATH "pot_lut.bin"
+#define POLICY_PATH "policy.bin"
+#define LAYOUT_INDEX_PATH "layouts.bin"
+
+// Pot-angle table
+#define POT_LUT_CELL 10.0f             // px between object-ball positions
+#define POT_LUT_PROBE_SPEED 8.0f       // object-ball speed the windows are solved at
+#define POT_LUT_SCAN_RANGE 12.0f       // degrees either side of the line to the pocket
+#define POT_LUT_SCAN_STEP 1.0f         // degrees between coarse probes; at most 64 per side
+#define POT_LUT_REFINE_STEPS 5         // bisections per window edge
+#define POT_LUT_MAX_CUT 80.0f          // degrees; thinner cuts are not offered as candidates
+#define POT_SEARCH_POWER_STEPS 3       // speeds tried per candidate; divides SEARCH_POWER_STEPS
+
+// Threading
+#define INPUT_QUEUE_SIZE 64
+
+// Rewind (practice undo and scrubbing)
+#define REWIND_BUDGET_MB 8             // default; --rewind-mb overrides
+#define REWIND_BLOCK_SIZE 4096
+#define REWIND_MAX_SHOTS 128
+#define REWIND_KEYFRAME_INTERVAL 32    // frames between full states inside a shot
+#define REWIND_MAX_KEYS 32
+
+// Ball in hand
+#define BALL_GRID_CELL 33              // px; no less than the widest clearance asked of the grid
+#define PLACEMENT_COLS 24              // spots scored for the placement heatmap
+#define PLACEMENT_ROWS 10
+#define PLACEMENT_ANGLE_STEPS 36       // divides SEARCH_ANGLE_STEPS, so searches share cache buckets
+#define PLACEMENT_POWER_STEPS 3        // divides SEARCH_POWER_STEPS
+#define PLACEMENT_BATCH 8              // spots scored per step
+
+// Frame-budget governor (shares of the frame budget)
+#define GOVERNOR_HIGH 0.85f            // update + draw above this is over budget
+#define GOVERNOR_LOW 0.50f             // and below this leaves headroom
+#define GOVERNOR_MISS 1.25f            // a whole frame this long is over budget whatever the work
+#define GOVERNOR_SHED_FRAMES 4         // frames over budget in a row before shedding the next item
+#define GOVERNOR_RESTORE_FRAMES 90     // frames with headroom in a row before restoring one
+#define GOVERNOR_HISTORY 120           // frames kept for the profiler graph
+#define GOVERNOR_DECISIONS 8           // recent decisions kept for the profiler
+#define AIM_PREVIEW_LENGTH 420.0f
+#define AIM_PREVIEW_SHED_LENGTH 140.0f
+#define HUD_SHED_REFRESH_FRAMES 15
+
+// Crash recovery
+#define AUTOSAVE_PATH "autosave.bin"
+
+// Input-to-photon latency
+#define LATENCY_HISTORY 256            // recent shots kept for the overlay and export
+#define LATENCY_OVERLAY_MAX_MS 100     // the overlay histogram spans 0 to this
+#define LATENCY_OVERLAY_BINS 25
+
+// Speculative run-ahead while dragging
+#define RUNAHEAD_FRAMES 2              // frames a speculated shot is simulated ahead
+#define RUNAHEAD_ANGLE_TOLERANCE 0.25f // degrees between the speculated aim and the release
+#define RUNAHEAD_SPEED_TOLERANCE 0.02f // of MAX_SHOT_SPEED
+
+// Telemetry
+#define TELEMETRY_PATH "telemetry.ndjson"
+#define TELEMETRY_QUEUE_SIZE 64
+
+// Spectator stream
+#define STREAM_QUANT 8                  // positions in 1/8 pixel
+#define STREAM_HEARTBEAT_FRAMES 60      // idle frames per heartbeat record
+
 #endif // CONFIG_H
@@ -0,0 +1,95 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include "common.h"
+#include "mapfile.h"
+
+// Replay corpus: recorded games as one row per shot, stored column by column
+// so a query that reads three fields maps and touches only those three. Rows
+// of a game are contiguous and in play order; game g owns rows
+// gameFirst[g] .. gameFirst[g + 1] - 1. A row holds the shot as struck plus
+// its result, which is enough to answer most questions from the columns
+// alone, and enough to rebuild any table by replaying its game from the rack
+// through SimulateShot (CorpusReplayShot) when a question needs ball positions.
+
+#define CORPUS_VERSION 1
+
+#define CORPUS_SCRATCH 1
+#define CORPUS_EIGHT   2
+
+typedef enum {
+    CORPUS_PLAYER,          // unsigned char
+    CORPUS_ANGLE,           // float, radians
+    CORPUS_SPEED,           // float
+    CORPUS_CUE_X,           // float, cue ball when struck (ball in hand: where it was placed)
+    CORPUS_CUE_Y,           // float
+    CORPUS_POCKETED,        // unsigned short, mask of balls down on the shot
+    CORPUS_FLAGS,           // unsigned char, CORPUS_SCRATCH | CORPUS_EIGHT
+    CORPUS_STATE,           // unsigned char, GameState after the shot
+    CORPUS_GAME_FIRST,      // unsigned int per game, plus one past the last row
+    CORPUS_COLUMNS
+} CorpusColumn;
+
+typedef struct {
+    unsigned long long offset;      // from the start of the file, CORPUS_ALIGN aligned
+    unsigned int elementSize;
+    unsigned int count;
+} CorpusColumnInfo;
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash() of the recording build
+    unsigned int shotCount;
+    unsigned int gameCount;
+    CorpusColumnInfo columns[CORPUS_COLUMNS];
+} CorpusHeader;
+
+typedef struct {
+    unsigned char player;
+    float angle;
+    float speed;
+    Vector2 cue;
+    unsigned short pocketed;
+    unsigned char flags;
+    unsigned char stateAfter;
+} CorpusShot;
+
+// --- Writing ---
+
+typedef struct {
+    CorpusShot *shots;
+    unsigned int shotCount, shotCapacity;
+    unsigned int *gameFirst;
+    unsigned int gameCount, gameCapacity;
+} CorpusWriter;
+
+void CorpusWriterInit(CorpusWriter *w);
+bool CorpusAddGame(CorpusWriter *w, const CorpusShot *shots, int count);
+bool CorpusWriterSave(const CorpusWriter *w, const char *path);
+void CorpusWriterFree(CorpusWriter *w);
+void CorpusShotStrike(CorpusShot *row, int player, Vector2 cue, float angle, float speed);
+void CorpusShotResult(CorpusShot *row, unsigned short pocketed, GameState stateAfter);
+
+// --- Reading ---
+
+typedef struct {
+    MappedFile file;
+    unsigned int shotCount, gameCount;
+    const unsigned char *player;
+    const float *angle, *speed, *cueX, *cueY;
+    const unsigned short *pocketed;
+    const unsigned char *flags, *state;
+    const unsigned int *gameFirst;
+} Corpus;
+
+bool CorpusOpen(Corpus *c, const char *path);
+void CorpusClose(Corpus *c);
+
+// Plays one row on a table rebuilt by replaying the rows before it, starting
+// from InitGame, and reports what the physics pocketed. False if the game is
+// over or the recorded ball-in-hand spot is not legal on the rebuilt table,
+// i.e. the corpus and this build's physics disagree.
+bool CorpusReplayShot(const Corpus *c, unsigned int row, Game *table, unsigned short *pocketed);
+
+#endif // CORPUS_H
@@ -0,0 +1,36 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "common.h"
+
+// Physics event ring helpers. The producer only ever appends; consumers walk
+// the pending range with EventRingCount/EventRingAt and the owner clears it
+// once every consumer has seen the batch.
+
+static inline void EventRingPush(EventRing *ring, EventType type, int a, int b, float value, Vector2 position) {
+    if (ring->tail - ring->head >= EVENT_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    PhysicsEvent *e = &ring->items[ring->tail & (EVENT_RING_SIZE - 1)];
+    e->type = (unsigned char)type;
+    e->a = (unsigned char)a;
+    e->b = (unsigned char)b;
+    e->value = value;
+    e->position = position;
+    ring->tail++;
+}
+
+static inline int EventRingCount(const EventRing *ring) {
+    return (int)(ring->tail - ring->head);
+}
+
+static inline const PhysicsEvent *EventRingAt(const EventRing *ring, int k) {
+    return &ring->items[(ring->head + (unsigned int)k) & (EVENT_RING_SIZE - 1)];
+}
+
+static inline void EventRingClear(EventRing *ring) {
+    ring->head = ring->tail;
+}
+
+#endif // EVENTS_H
@@ -2,15 +2,23 @@
 #define GAME_H
 
 #include "common.h"
+#include "input.h"
 
 void InitGame(Game *game);
 void ResetBalls(Game *game);
-void UpdateGame(Game *game);
-void HandleInput(Game *game);
+void UpdateGame(Game *game, const InputFrame *input);
+void TickGame(Game *game);
+void StepSimulation(Game *game);
+int  FastForwardShot(Game *game, int maxSteps);
+void HandleInput(Game *game, const InputFrame *input);
 void CheckPockets(Game *game);
 void CheckWinCondition(Game *game);
 void NextTurn(Game *game);
 void ApplyScratch(Game *game);
+bool PlaceCueBall(Game *game, Vector2 position);
+bool GetAim(const Game *game, float *angle, float *shotSpeed);
+void TakeShot(Game *game, float angle, float shotSpeed);
+void ReleaseShot(Game *game, float angle, float shotSpeed);
 int  playerIndexForType(Game *game, BallType btype);
 
 #endif // GAME_H
@@ -0,0 +1,64 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "common.h"
+#include "utils.h"
+
+// Frame-budget governor. The window thread marks the end of each phase of a
+// frame; the time spent on update and draw is weighed against the budget
+// (1 / TARGET_FPS unless --budget-ms says otherwise). After
+// GOVERNOR_SHED_FRAMES frames over budget the next optional item is shed,
+// in the order below; after GOVERNOR_RESTORE_FRAMES frames with headroom
+// the last one shed comes back. Present is timed too but not weighed: it
+// includes the frame limiter's wait, so only a frame that overruns the
+// budget as a whole counts against it.
+
+typedef enum {
+    SHED_AIM_PREVIEW,       // aiming line cut to AIM_PREVIEW_SHED_LENGTH, no break preview
+    SHED_HUD_REFRESH,       // HUD text rebuilt every HUD_SHED_REFRESH_FRAMES frames
+    SHED_OVERLAY_ALPHA,     // overlays draw on an opaque band instead of dimming the screen
+    SHED_BACKGROUND_AI,     // shot odds and placement help stop sampling
+    SHED_COUNT
+} OptionalWork;
+
+typedef enum {
+    PHASE_UPDATE,
+    PHASE_DRAW,
+    PHASE_PRESENT,
+    PHASE_COUNT
+} FramePhase;
+
+typedef struct {
+    long frame;
+    OptionalWork work;
+    bool shed;              // false: restored
+    float workMs;           // update + draw of the frame that tipped it
+} GovernorDecision;
+
+typedef struct {
+    double budget;
+    long frames;
+    int level;                              // items currently shed, from the front of the order
+    long framesAtLevel[SHED_COUNT + 1];
+    long overFrames;                        // frames that counted as over budget
+    int sheds, restores;
+    FrameStats phases[PHASE_COUNT];
+
+    // Recent frames for the profiler, oldest first from historyNext
+    float historyMs[GOVERNOR_HISTORY][PHASE_COUNT];
+    unsigned char historyLevel[GOVERNOR_HISTORY];
+    int historyNext;
+    GovernorDecision decisions[GOVERNOR_DECISIONS];     // newest last
+    int decisionCount;
+} GovernorReport;
+
+void GovernorInit(double budgetSeconds);        // 0 leaves everything on, still profiling
+void GovernorBeginFrame(void);
+void GovernorMark(FramePhase phase);            // end of the phase
+void GovernorEndFrame(void);                    // after present; decides for the next frame
+bool GovernorSheds(OptionalWork work);
+const char *GovernorWorkName(OptionalWork work);
+const GovernorReport *GovernorGetReport(void);
+void GovernorPrintReport(FILE *out);
+
+#endif // GOVERNOR_H
@@ -5,10 +5,14 @@
 
 void DrawGame(Game *game);
 void DrawTable(void);
+void DrawPockets(void);
 void DrawBalls(Game *game);
 void DrawCueStick(Game *game);
 void DrawPowerBar(Game *game);
 void DrawHUD(Game *game);
 void DrawOverlays(Game *game);
+void DrawResumePrompt(Game *saved);
+void SetProfilerVisible(bool visible);
+void SetLatencyVisible(bool visible);
 
 #endif // GRAPHICS_H
@@ -0,0 +1,35 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "common.h"
+
+// Everything the game reads from the keyboard and mouse in one frame. It is
+// sampled on the window thread and handed to the game logic as plain data,
+// so the logic can run on another thread.
+typedef struct {
+    Vector2 mouse;
+    bool mousePressed;
+    bool mouseDown;
+    bool mouseReleased;
+    bool keyReset;
+    bool keyPlaybackSpeed;
+    bool keySkipToRest;
+    bool keyUndo;
+    bool keyResume;
+    bool keyPlacementHelp;
+    int scrubFrames;        // frames to step through a rewound shot, signed
+    double time;            // NowSeconds() when sampled
+} InputFrame;
+
+// Where the frames come from. The window reads raylib; soak runs and tools
+// replay a script (script.h), so the game loop can run with no window at all.
+typedef struct InputProvider {
+    bool (*poll)(struct InputProvider *self, InputFrame *input);   // false once the source has ended
+    void (*close)(struct InputProvider *self);
+    void *state;
+} InputProvider;
+
+void PollInput(InputFrame *input);
+void RaylibInputOpen(InputProvider *provider);
+
+#endif // INPUT_H
@@ -0,0 +1,17 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+
+// Small fixed worker pool for data-parallel loops. Each call to
+// JobsParallelFor runs fn(index, ctx) once for every index in [0, count) and
+// returns when all of them are done; the calling thread takes part too.
+typedef void (*JobFn)(int index, void *ctx);
+
+void JobsInit(int threads);          // 0 = one per CPU core
+void JobsShutdown(void);
+int  JobsThreadCount(void);          // including the calling thread
+int  JobsCoreCount(void);
+void JobsParallelFor(int count, JobFn fn, void *ctx);
+
+#endif // JOBS_H
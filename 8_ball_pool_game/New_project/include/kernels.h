@@ -0,0 +1,63 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "common.h"
+#include "solver.h"
+#include "table.h"
+
+// The inner loops of a physics step, compiled once per instruction set and
+// picked at startup from what the CPU supports. Every backend gives the same
+// bits as the scalar one: the same float operations in the same order, only
+// several balls at a time, so replays, golden files and the shot cache do not
+// care which one ran. POOL_KERNELS=scalar|sse4.2|avx2 in the environment
+// forces one, for testing and comparisons.
+
+// x86-64 only: 32-bit builds may keep scalar floats in x87 registers, wider
+// than the vector lanes
+#if defined(__GNUC__) && defined(__x86_64__)
+#define KERNELS_X86 1
+#endif
+
+#define KERNELS_MAX 3
+
+typedef struct {
+    const char *name;
+    // GatherContacts for count <= SOLVER_SWEEP_MIN balls: every overlapping
+    // pair, (a, b) order, returning the full count
+    int  (*gatherPairs)(const Ball *balls, int count, Contact *out, int capacity);
+    // PocketAt for each ball, -1 for a ball already pocketed
+    void (*pocketScan)(const TableGeometry *table, const Ball *balls, int count, int *pockets);
+    // Friction and the slow-ball stop for every ball on the table
+    void (*damp)(Ball *balls, int count, float friction);
+    // int8 dot product for the learned policy; n a multiple of 32
+    int  (*dotS8)(const signed char *a, const signed char *b, unsigned int n);
+} PhysicsKernels;
+
+typedef struct {
+    const PhysicsKernels *kernels;
+    double micros;          // one synthetic step's worth of kernel calls
+    bool matches;           // outputs identical to scalar
+} KernelTiming;
+
+// Picks the backend once: POOL_KERNELS if set and supported, otherwise the
+// widest the CPU runs, or with benchmark the fastest of a quick self-test.
+// Later calls return the first choice. GetKernels does the same on first use.
+const PhysicsKernels *KernelsInit(bool benchmark);
+const PhysicsKernels *GetKernels(void);
+
+// Backends this CPU runs, scalar first
+int KernelsSupported(const PhysicsKernels **list, int max);
+const PhysicsKernels *KernelsFind(const char *name);    // NULL if unknown or unsupported
+// Swaps the active backend; only while no physics is running
+void KernelsUse(const PhysicsKernels *kernels);
+// Times every supported backend on synthetic tables and checks it against scalar
+int KernelsBenchmark(KernelTiming *timings, int max);
+// One line: the active backend, what the CPU offers and how it was chosen
+void KernelsDescribe(char *text, int size);
+
+#ifdef KERNELS_X86
+extern const PhysicsKernels kernelsSse42;
+extern const PhysicsKernels kernelsAvx2;
+#endif
+
+#endif // KERNELS_H
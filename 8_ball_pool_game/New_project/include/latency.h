@@ -0,0 +1,50 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "common.h"
+#include "utils.h"
+
+// Input-to-photon latency of each shot, in four stamps:
+//   sampled    the mouse release was read on the window thread (InputFrame.time)
+//   handled    HandleInput took the shot from it
+//   moved      the first physics step that moved the cue ball
+//   presented  the first EndDrawing of a frame showing the cue ball moved
+// The game and window sides may be different threads; a shot in flight
+// moves through the stages with an atomic, so the per-frame checks cost a
+// load when nothing is pending.
+
+typedef enum {
+    LATENCY_QUEUE,          // sampled -> handled
+    LATENCY_SIMULATE,       // handled -> moved
+    LATENCY_PRESENT,        // moved -> presented
+    LATENCY_TOTAL,          // sampled -> presented
+    LATENCY_SEGMENTS
+} LatencySegment;
+
+typedef struct {
+    int shot;
+    int ahead;              // frames run-ahead had already simulated, 0 without it
+    double sampled, handled, moved, presented;
+} LatencySample;
+
+typedef struct {
+    FrameStats segments[LATENCY_SEGMENTS];
+    LatencySample recent[LATENCY_HISTORY];     // ring, oldest overwritten
+    int recentCount, recentNext;
+    long unpresented;       // shots that never reached the screen (the next began first)
+} LatencyReport;
+
+void LatencyInit(void);
+void LatencyShotTaken(int shot, Vector2 cueFrom, double sampled, int ahead);   // HandleInput, on the release
+void LatencyStep(const Game *game);                         // after each UpdatePhysics
+void LatencyPresented(const Game *drawn);                   // after EndDrawing
+
+// The window thread's view; samples land under a lock the overlay also takes
+const LatencyReport *LatencyLockReport(void);
+void LatencyUnlockReport(void);
+
+const char *LatencySegmentName(LatencySegment segment);
+void LatencyPrintReport(FILE *out);
+bool LatencyExport(const char *path);   // the samples still in the ring, as CSV
+
+#endif // LATENCY_H
@@ -0,0 +1,81 @@
+#ifndef LAYOUTS_H
+#define LAYOUTS_H
+
+#include "common.h"
+#include "mapfile.h"
+
+// Library of solved mid-game layouts: ball coordinates in Game.balls order
+// with the best shot the full search found, searchable by nearest layout.
+// Layouts are mirrored across the table's centre lines until the cue ball
+// sits in the top-left quarter, so one solved layout answers all four of its
+// reflections; shots are mirrored back on the way out. Records are stored in
+// k-d tree order (each range's median is its node), one tree per shooter
+// PlayerType, so a query never mixes groups. pool_layouts solves and writes
+// the file.
+
+#define LAYOUT_VERSION 1
+#define LAYOUT_DIMS (MAX_BALLS * 2)
+#define LAYOUT_QUANT 64             // coordinates in 1/64 pixel; 0 is a pocketed ball
+#define LAYOUT_TYPES 3              // PLAYER_NONE, PLAYER_SOLIDS, PLAYER_STRIPES
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash() of the solving build
+    unsigned int recordSize;
+    unsigned int recordCount;
+    unsigned int typeStart[LAYOUT_TYPES + 1];  // each PlayerType's tree is records[typeStart[t], typeStart[t + 1])
+} LayoutHeader;
+
+typedef struct {
+    unsigned short key[LAYOUT_DIMS];    // x, y per ball in the mirrored frame
+    float angle, speed;             // best shot, mirrored frame
+    float score;                    // what the search scored it
+    unsigned char split;            // k-d split dimension of this node
+    unsigned char type;             // shooter's PlayerType
+    unsigned char pad[2];
+} LayoutRecord;
+
+typedef struct {
+    MappedFile file;                // empty for an index built in memory
+    const LayoutHeader *header;
+    const LayoutRecord *records;
+    void *owned;                    // header and records of an index built in memory
+} LayoutIndex;
+
+typedef struct {
+    const LayoutRecord *record;
+    float distance;                 // pixels, root of the summed squares over all coordinates
+    float angle, speed;             // the record's shot in the live table's frame
+} LayoutMatch;
+
+typedef struct {
+    long visited;                   // nodes whose distance was computed
+} LayoutQueryStats;
+
+// Canonical key of a live table; flipX/flipY say which mirrorings made it
+void LayoutKey(const Game *game, unsigned short key[LAYOUT_DIMS], bool *flipX, bool *flipY);
+float LayoutMirrorAngle(float angle, bool flipX, bool flipY);
+
+// Takes ownership of records (malloc'd), reorders them into trees
+bool LayoutIndexBuild(LayoutIndex *index, LayoutRecord *records, int count);
+bool LayoutIndexWrite(const LayoutIndex *index, const char *path);
+bool LayoutIndexOpen(LayoutIndex *index, const char *path);
+void LayoutIndexClose(LayoutIndex *index);
+size_t LayoutIndexBytes(const LayoutIndex *index);
+
+// The count solved layouts closest to the live table, nearest first. With
+// 32 coordinates a tree cannot prune much once layouts get sparse, so the
+// search stops exploring after LAYOUT_MAX_VISITS nodes and keeps the best
+// found; the first descent always reaches a leaf.
+int LayoutIndexNearest(const LayoutIndex *index, const Game *game, LayoutMatch *matches, int count,
+                       LayoutQueryStats *stats);
+// The same over a key already in the mirrored frame, with an explicit
+// budget (0: exact); matches come back in the mirrored frame
+int LayoutIndexNearestKey(const LayoutIndex *index, const unsigned short key[LAYOUT_DIMS], int type,
+                          LayoutMatch *matches, int count, int maxVisits, LayoutQueryStats *stats);
+
+bool LayoutIndexLoadDefault(const char *path);
+const LayoutIndex *GetLayoutIndex(void);
+
+#endif // LAYOUTS_H
@@ -0,0 +1,24 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Read-only memory-mapped file
+typedef struct {
+    const void *data;
+    size_t size;
+    void *handle;       // platform mapping handle
+} MappedFile;
+
+bool MapFileOpen(MappedFile *m, const char *path);
+void MapFileClose(MappedFile *m);
+
+// Durable replacement: FileCommit pushes a written file to the disk, and
+// FileReplace then swaps it in for the target in one step, so a reader (or a
+// restart after a crash) finds the old contents or the new, never a mix
+bool FileCommit(FILE *f);
+bool FileReplace(const char *from, const char *to);
+
+#endif // MAPFILE_H
@@ -0,0 +1,19 @@
+#ifndef ODDS_H
+#define ODDS_H
+
+#include "common.h"
+
+// Chance that the shot being aimed succeeds when the player's execution is
+// off by ODDS_ANGLE_NOISE / ODDS_POWER_NOISE. A background thread samples the
+// current aim in batches of ODDS_BATCH across the job pool and accumulates
+// until ODDS_MAX_SAMPLES, so the estimate sharpens over a few frames without
+// the window thread ever waiting on a simulation. A sample succeeds when it
+// pots one of the shooter's balls without a foul (ScoreOutcome > 0). Sampling
+// stops while the frame-budget governor has shed background AI.
+
+bool ShotOddsStart(void);
+void ShotOddsStop(void);
+void ShotOddsAim(const Game *game);         // every frame, with the game being drawn
+bool ShotOddsGet(float *chance, float *margin, int *samples);
+
+#endif // ODDS_H
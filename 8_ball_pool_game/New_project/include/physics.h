@@ -3,9 +3,17 @@
 
 #include "common.h"
 
+// One physics step. Nothing here touches the rules: contacts, cushion hits,
+// pocketed balls and balls coming to rest are appended to game->events for
+// StepSimulation to hand to its consumers.
 void UpdatePhysics(Game *game);
+// Screening variant: one step stands for up to maxStride steps, as many as
+// keeps every ball within COARSE_MAX_TRAVEL of where it started, with the
+// friction of that many steps. The cushion sweep is continuous, so only
+// contacts and drops see the larger step; fast balls still step singly.
+void UpdatePhysicsCoarse(Game *game, int maxStride);
 void CheckCollisions(Game *game);
 void ResolveElasticCollision(Ball *a, Ball *b);
-void CheckPockets(Game *game);
+void PocketBalls(Game *game);
 
 #endif // PHYSICS_H
@@ -0,0 +1,40 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdatomic.h>
+#include "common.h"
+#include "input.h"
+
+// Runs the game logic on its own thread at TARGET_FPS. The window thread
+// pushes sampled input through a single-producer/single-consumer queue and
+// draws the latest published snapshot from a lock-free triple buffer, so a
+// slow draw never holds up the simulation and vice versa.
+
+typedef struct {
+    Game slots[3];
+    atomic_int middle;      // slot index, plus TRIPLE_BUFFER_FRESH when unread
+    int back;               // owned by the writer
+    int front;              // owned by the reader
+} TripleBuffer;
+
+typedef struct {
+    InputFrame items[INPUT_QUEUE_SIZE];
+    atomic_int head;        // next slot to read, advanced by the consumer
+    atomic_int tail;        // next slot to write, advanced by the producer
+} InputQueue;
+
+void  TripleBufferInit(TripleBuffer *tb, const Game *initial);
+Game *TripleBufferBack(TripleBuffer *tb);
+void  TripleBufferPublish(TripleBuffer *tb);
+Game *TripleBufferAcquire(TripleBuffer *tb);
+
+void InputQueueInit(InputQueue *q);
+bool InputQueuePush(InputQueue *q, const InputFrame *input);
+bool InputQueuePop(InputQueue *q, InputFrame *input);
+
+bool  PipelineStart(const Game *initial);
+void  PipelineSubmitInput(const InputFrame *input);
+Game *PipelineLatest(void);
+void  PipelineStop(Game *final);
+
+#endif // PIPELINE_H
@@ -0,0 +1,48 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "common.h"
+
+// Ball in hand. A BallGrid (common.h) buckets the balls on the table into
+// cells at least BALL_GRID_CELL wide, each ball in the cell holding its
+// centre, so whether a spot is clear only depends on the 3x3 cells around
+// it: O(1) whatever the number of balls. The object balls cannot move while
+// the cue ball is in hand, so the grid is built into Game.cueGrid once they
+// come to rest after a scratch, and every spot checked after that only
+// queries it.
+
+// Buckets every ball on the table except the cue ball, which is the one being placed
+void BallGridBuild(BallGrid *grid, const Game *game);
+// clearance is the closest a ball centre may be, at most BALL_GRID_CELL
+bool BallGridIsFree(const BallGrid *grid, const Game *game, Vector2 spot, float clearance);
+// Inside the rails and clear of every ball; builds a grid of its own for a
+// table without Game.cueGrid
+bool CueSpotIsValid(const Game *game, Vector2 spot);
+
+// Placement help: while a human has ball in hand, a background thread scores
+// a PLACEMENT_COLS x PLACEMENT_ROWS grid of spots by the best shot from each
+// (a PLACEMENT_ANGLE_STEPS x PLACEMENT_POWER_STEPS search through the shot
+// cache), a few spots at a time across the job pool. Spots fill in spread
+// over the table, so a partial heatmap is already useful. Like shot odds, it
+// stops while the frame-budget governor has shed background AI.
+
+typedef enum {
+    SPOT_PENDING,
+    SPOT_BLOCKED,       // outside the rails or on a ball
+    SPOT_SCORED
+} SpotState;
+
+typedef struct {
+    unsigned char state[PLACEMENT_ROWS][PLACEMENT_COLS];
+    float score[PLACEMENT_ROWS][PLACEMENT_COLS];
+    int scored;
+    int bestRow, bestCol;   // -1 until a spot is scored
+} PlacementHeatmap;
+
+Vector2 PlacementSpot(int row, int col);
+bool PlacementHelpStart(void);
+void PlacementHelpStop(void);
+void PlacementHelpUpdate(const Game *game);        // every frame, with the game being drawn
+bool PlacementHelpGet(PlacementHeatmap *heatmap);
+
+#endif // PLACEMENT_H
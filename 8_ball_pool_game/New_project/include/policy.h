@@ -0,0 +1,74 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "common.h"
+#include "mapfile.h"
+
+// Learned shot policy: a small multilayer perceptron over a fixed encoding
+// of the table, scoring every shot of the search grid (SEARCH_ANGLE_STEPS x
+// SEARCH_POWER_STEPS, the same indexing and cache buckets as SearchShot) so
+// the computer player can check a short list instead of the whole grid.
+// Weights are int8 with a float scale per output row, activations int8 with
+// one scale per layer; the dot products run on the physics kernel backend
+// (kernels.h), or NEON on ARM builds. pool_policy trains, quantizes and
+// writes the file.
+
+#define POLICY_VERSION 1
+#define POLICY_MAX_LAYERS 4
+#define POLICY_ALIGN 32             // vector widths and file offsets
+#define POLICY_MAX_WIDTH 1088       // widest layer, inputs or outputs
+
+// Input encoding: x, y and pocketed per ball, then the shooter's PlayerType
+#define POLICY_FEATURES (MAX_BALLS * 3 + 3)
+#define POLICY_INPUTS 64            // POLICY_FEATURES padded to POLICY_ALIGN
+#define POLICY_OUTPUTS (SEARCH_ANGLE_STEPS * SEARCH_POWER_STEPS)
+
+typedef struct {
+    unsigned int inputs;            // padded to POLICY_ALIGN
+    unsigned int outputs;
+    unsigned int relu;
+    float inputScale;               // one int8 step of this layer's input
+    unsigned long long offset;      // scales[outputs], bias[outputs], weights[outputs][inputs]
+} PolicyLayerInfo;
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash() of the tables it was trained on
+    unsigned int layerCount;
+    unsigned int samples;           // training positions, for the record
+    PolicyLayerInfo layers[POLICY_MAX_LAYERS];
+} PolicyHeader;
+
+typedef struct {
+    const float *scales;            // per output row: weight step times input step
+    const float *bias;
+    const signed char *weights;
+} PolicyLayer;
+
+typedef struct {
+    MappedFile file;
+    const PolicyHeader *header;
+    PolicyLayer layers[POLICY_MAX_LAYERS];
+    unsigned int maxWidth;
+} PolicyModel;
+
+typedef struct {
+    int index;                      // grid shot: angle step + SEARCH_ANGLE_STEPS * (power step)
+    float logit;
+} PolicyShot;
+
+void PolicyEncode(const Game *game, float features[POLICY_INPUTS]);
+bool PolicyOpen(PolicyModel *model, const char *path);
+void PolicyClose(PolicyModel *model);
+
+// The count highest-scoring grid shots, best first
+int PolicyShortlist(const PolicyModel *model, const Game *game, PolicyShot *shots, int count);
+// Raw logits for every grid shot, for training checks
+void PolicyForward(const PolicyModel *model, const float features[POLICY_INPUTS], float logits[POLICY_OUTPUTS]);
+const char *PolicyKernelName(void);
+
+bool PolicyLoadDefault(const char *path);
+const PolicyModel *GetPolicy(void);
+
+#endif // POLICY_H
@@ -0,0 +1,62 @@
+#ifndef POTLUT_H
+#define POTLUT_H
+
+#include "common.h"
+#include "mapfile.h"
+
+// Pot-angle lookup table. For an object ball anywhere on a POT_LUT_CELL grid
+// over the playing area it holds, per pocket of GetPocketPositions, the
+// direction the ball must leave in to drop cleanly (no cushion or jaw
+// contact on the way) and the margin either side of it. Directions are
+// stored as an offset from the straight line to the pocket point, so a
+// lookup stays exact between cell centres. The table depends only on the
+// table spec; it is built once through the physics, saved, and mapped on
+// later runs.
+
+#define POT_LUT_VERSION 1
+
+typedef struct {
+    float offset;           // radians from the line to the pocket point
+    float margin;           // half-width of the window that pots, 0 if none does
+} PotWindow;
+
+typedef struct {
+    PotWindow pockets[6];
+} PotCell;
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int specHash;          // TableSpecHash() of the generating build
+    int cols, rows;
+    float originX, originY;         // centre of cell (0, 0)
+    float cell;
+    unsigned int recordSize;
+} PotLutHeader;
+
+typedef struct {
+    MappedFile file;
+    const PotLutHeader *header;
+    const PotCell *cells;
+} PotLut;
+
+// A way to pot one object ball from where the cue ball is
+typedef struct {
+    int pocket;
+    float objectAngle;      // direction the object ball must leave in
+    float margin;           // of objectAngle
+    float cueAngle;         // shot angle that sends the cue ball through the ghost ball
+    float cut;              // angle between cueAngle and objectAngle, radians
+} PotCandidate;
+
+bool PotLutBuild(const char *path);
+bool PotLutOpen(PotLut *lut, const char *path);
+void PotLutClose(PotLut *lut);
+bool PotLutWindow(const PotLut *lut, Vector2 object, int pocket, float *angle, float *margin);
+int  PotLutCandidates(const PotLut *lut, Vector2 cue, Vector2 object, PotCandidate candidates[6]);
+
+// Table shared by the game: mapped at startup, built first if missing or stale
+bool PotLutLoadDefault(const char *path);
+const PotLut *GetPotLut(void);
+
+#endif // POTLUT_H
@@ -0,0 +1,10 @@
+#ifndef PROCMEM_H
+#define PROCMEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Resident memory of this process and its high-water mark, in bytes
+bool ProcessMemory(size_t *resident, size_t *peak);
+
+#endif // PROCMEM_H
@@ -0,0 +1,33 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "common.h"
+
+// CPU rasterizer for rendering without a GPU or a window. It fills shapes
+// the way raylib's rasterizer does: a pixel is covered when its center is
+// inside, blending is source-over. The RasterDraw* passes reproduce their
+// graphics.c counterparts, so offline frames look like the game.
+
+typedef struct {
+    int width;
+    int height;
+    Color *pixels;      // RGBA8, row-major, top row first
+} Canvas;
+
+bool CanvasInit(Canvas *canvas, int width, int height);
+void CanvasFree(Canvas *canvas);
+
+void RasterClear(Canvas *canvas, Color color);
+void RasterRectangle(Canvas *canvas, float x, float y, float width, float height, Color color);
+void RasterCircle(Canvas *canvas, Vector2 center, float radius, Color color);
+void RasterLine(Canvas *canvas, Vector2 a, Vector2 b, float thick, Color color);
+void RasterNumber(Canvas *canvas, const char *digits, int x, int y, int fontSize, Color color);
+int  RasterMeasureNumber(const char *digits, int fontSize);
+
+void RasterDrawTable(Canvas *canvas);
+void RasterDrawPockets(Canvas *canvas);
+void RasterDrawBalls(Canvas *canvas, const Game *game);
+void RasterDrawCueStick(Canvas *canvas, const Game *game);
+void RasterDrawFrame(Canvas *canvas, const Game *game);    // all of the above on a cleared canvas
+
+#endif // RASTER_H
@@ -0,0 +1,35 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "common.h"
+
+// Practice-mode rewind. Every shot is kept as a full checkpoint of the table
+// before it was struck, followed by one record per frame: a lossless XOR
+// delta against the previous frame, with a full state every
+// REWIND_KEYFRAME_INTERVAL frames so any frame restores by decoding a short
+// run. Records live in fixed-size blocks carved out of one allocation of the
+// budget; when it is full the oldest shots are dropped, so memory never grows
+// past what RewindInit was given.
+
+typedef struct {
+    size_t budget;
+    size_t bytesUsed;           // blocks in use
+    int shots;
+    long long frames;           // frames currently held
+    long long rawBytes;         // what those frames would take as full copies
+    long long evictedShots;
+    double lastRestoreMicros;
+} RewindReport;
+
+bool RewindInit(size_t budgetBytes);
+void RewindShutdown(void);
+
+void RewindRecord(const Game *game);            // once per tick, after the simulation
+bool RewindUndo(Game *game);                    // back to the start of the last shot
+bool RewindScrub(Game *game, int frames);       // step through the latest shot, pausing play
+bool RewindResume(Game *game);                  // continue from the frame on screen
+
+void RewindGetReport(RewindReport *report);
+void RewindPrintReport(FILE *f);
+
+#endif // REWIND_H
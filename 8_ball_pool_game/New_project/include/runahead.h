@@ -0,0 +1,32 @@
+#ifndef RUNAHEAD_H
+#define RUNAHEAD_H
+
+#include "common.h"
+
+// Speculative run-ahead. While the stick is drawn back, the shot the current
+// drag would release is struck on a copy of the table and simulated
+// RUNAHEAD_FRAMES frames ahead. If the release comes with the same table and
+// an aim within RUNAHEAD_ANGLE_TOLERANCE / RUNAHEAD_SPEED_TOLERANCE of the
+// speculation, the copy takes over and the shot is on screen that many
+// frames further along; otherwise it is thrown away and the shot is struck
+// as usual. Off unless enabled: an adopted shot keeps the speculated aim, so
+// replays of recorded input need the same setting.
+
+typedef struct {
+    long speculations;      // copies struck and simulated ahead
+    long steps;             // physics steps spent on them
+    double seconds;         // time spent on them, on the simulation thread
+    long releases;
+    long hits;              // adopted with the exact aim
+    long nearHits;          // adopted within tolerance
+    long misses;            // the aim had moved past tolerance
+    long stale;             // no speculation, or the table changed under it
+    long framesSaved;
+} RunAheadReport;
+
+void RunAheadEnable(bool enabled);
+void RunAheadSpeculate(const Game *game);                      // HandleInput, while dragging
+int  RunAheadTake(Game *game, float angle, float shotSpeed);   // on release: frames handed over, 0 = strike as usual
+void RunAheadPrintReport(FILE *out);
+
+#endif // RUNAHEAD_H
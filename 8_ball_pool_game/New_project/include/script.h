@@ -0,0 +1,33 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include "common.h"
+#include "input.h"
+
+// Input scripts: timed input traces that drive the game without a window.
+// One event per line, "<frame> <event> [args]", frames counted from 0 at one
+// InputFrame per frame; '#' starts a comment.
+//
+//   move <x> <y>      mouse position from this frame on
+//   press | release   left button edge (held in between)
+//   key <name>        reset | speed | skip | undo | resume | help
+//   scrub <frames>    step through a rewound shot, signed
+//   end               last frame of the script (default: the last event)
+//
+// Recordings start with "key reset", so a looped script replays the same
+// games on every pass.
+
+bool ScriptInputOpen(InputProvider *provider, const char *path, bool loop);
+
+typedef struct {
+    FILE *file;
+    long frame;
+    Vector2 mouse;
+    bool haveMouse;
+} ScriptRecorder;
+
+bool ScriptRecorderOpen(ScriptRecorder *recorder, const char *path);
+void ScriptRecorderAdd(ScriptRecorder *recorder, const InputFrame *input);
+void ScriptRecorderClose(ScriptRecorder *recorder);
+
+#endif // SCRIPT_H
@@ -0,0 +1,50 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "common.h"
+
+// Headless shot simulation for tools and shot search. The start state is
+// never modified; the shot runs on a copy through the same TakeShot and
+// StepSimulation path as live play.
+
+typedef struct {
+    unsigned short pocketed;    // mask of balls pocketed by this shot
+    bool scratch;
+    bool eightPocketed;
+    GameState stateAfter;
+    int nextPlayer;
+    int steps;
+} ShotOutcome;
+
+void SimulateShot(const Game *start, float angle, float speed, Game *end, ShotOutcome *out);
+// The same shot at screening fidelity (UpdatePhysicsCoarse, up to stride
+// steps at a time): cheaper, and not exact, so never cached with exact shots
+void SimulateShotCoarse(const Game *start, float angle, float speed, int stride, Game *end, ShotOutcome *out);
+unsigned short PocketedMask(const Game *game);
+unsigned int TableSpecHash(void);
+
+// 64-bit hash of a table at rest: ball positions snapped to STATE_QUANT, the
+// pocketed set and the rule fields. It is the XOR of one term per ball and
+// one for the rules, so moving a single ball updates it with two XORs:
+//   hash ^= StateHashBall(i, &before) ^ StateHashBall(i, &after);
+unsigned long long StateHash(const Game *game);
+unsigned long long StateHashBall(int index, const Ball *ball);
+unsigned long long StateHashRules(const Game *game);
+
+// Self-play positions for the tools that learn from them (pool_policy,
+// pool_layouts): the caller picks a shot on each position, and play goes on
+// with it or, now and then, with a random one, so the positions
+// also cover the tables a miss leaves. Ball in hand goes anywhere the rules
+// allow and a finished game starts over.
+typedef struct {
+    Game game;
+    unsigned long long rng;
+    float greedy;                   // share of shots played as chosen
+} SelfPlay;
+
+void SelfPlayInit(SelfPlay *play, unsigned long long seed, float greedy);
+const Game *SelfPlayPosition(SelfPlay *play);      // ready for a shot, GAME_START or GAME_PLAYING
+void SelfPlayShot(SelfPlay *play, float angle, float speed);
+void SelfPlayRestart(SelfPlay *play);
+
+#endif // SIM_H
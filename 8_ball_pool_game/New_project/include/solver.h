@@ -0,0 +1,49 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "common.h"
+#include "events.h"
+
+// Ball-ball contact solver. Overlapping pairs are gathered up front, then
+// split by greedy graph coloring into batches in which no ball appears twice.
+// Batches are resolved one after another; the contacts inside a batch touch
+// disjoint balls, so large batches are spread across the job pool with the
+// same result for any thread count.
+
+typedef struct {
+    int a;
+    int b;
+    int result;     // SOLVER_* flags, written when the contact is resolved
+    float impulse;  // written when resolved
+} Contact;
+
+#define SOLVER_RESOLVED  1
+#define SOLVER_CLAMPED_A 2
+#define SOLVER_CLAMPED_B 4
+
+// Touching but not coincident; the vector kernels repeat this test lane by lane
+static inline bool BallsOverlap(const Ball *a, const Ball *b) {
+    float dx = b->position.x - a->position.x;
+    float dy = b->position.y - a->position.y;
+    float minDist = BALL_RADIUS * 2.0f;
+    float d2 = dx*dx + dy*dy;
+    return d2 < minDist * minDist && d2 > 0.0001f * 0.0001f;
+}
+
+// Counters are added to, so one struct can collect a whole shot
+typedef struct {
+    int contacts;       // pairs that were still overlapping when resolved
+    int speedClamps;
+    int batches;
+    int dropped;        // pairs left for the next step when there was no memory for them
+} SolverStats;
+
+int  GatherContacts(const Ball *balls, int count, Contact *out, int capacity);
+int  ColorContacts(Contact *contacts, int n, int ballCount, int *batchStart);
+void ResolveContactBatches(Ball *balls, Contact *contacts, const int *batchStart, int batches);
+void SolveContacts(Ball *balls, int count, SolverStats *stats, EventRing *events);   // events may be NULL
+
+// For testing the out-of-memory paths: every heap allocation above fails
+void SolverFailAllocations(bool fail);
+
+#endif // SOLVER_H
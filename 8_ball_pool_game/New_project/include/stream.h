@@ -0,0 +1,43 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "common.h"
+
+// Spectator stream: a compact binary log of the live table for watchers.
+// Each frame is either a delta carrying quantized positions for the balls
+// that moved, a keyframe with the full state (written at every shot), or a
+// run of idle frames. Pocket, turn, state and status events are written
+// ahead of the frame they happened in.
+
+typedef enum {
+    STREAM_KEYFRAME = 1,
+    STREAM_DELTA    = 2,
+    STREAM_IDLE     = 3,
+    STREAM_POCKET   = 4,
+    STREAM_TURN     = 5,
+    STREAM_STATE    = 6,
+    STREAM_STATUS   = 7
+} StreamRecord;
+
+// Writer. target is a file or FIFO path, "-" for stdout, or "|command" to
+// pipe into another process (e.g. "|nc host port" for a socket).
+bool StreamOpen(const char *target);
+void StreamFrame(const Game *game);
+void StreamClose(void);
+long StreamBytesWritten(void);
+
+// Reader: rebuilds a Game from the records
+typedef struct {
+    FILE *file;
+    bool isPipe;
+    Game game;
+    int frame;
+    int lastPocketedBall;
+    int lastPocket;
+} StreamReader;
+
+bool StreamReaderOpen(StreamReader *r, const char *source);
+int  StreamReadRecord(StreamReader *r, StreamRecord *type);   // frames advanced, -1 at end
+void StreamReaderClose(StreamReader *r);
+
+#endif // STREAM_H
@@ -0,0 +1,49 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "common.h"
+
+// Table boundary as real geometry: cushion noses along the rails and angled
+// jaws into each pocket, all stored as capsules (a segment with a rounding
+// radius) in a static bounding-volume hierarchy built once per table.
+
+typedef struct {
+    Vector2 a;
+    Vector2 b;
+    float radius;
+} Cushion;
+
+typedef struct {
+    float minX, minY, maxX, maxY;
+    int right;          // inner node: index of the right child; the left child follows the node
+    int first;          // leaf: first cushion
+    int count;          // leaf: number of cushions, 0 for inner nodes
+} BvhNode;
+
+// Straight stretch of one cushion run, away from the jaws at either end. A move
+// that only reaches this stretch bounces off a plain line without the BVH.
+typedef struct {
+    int side;           // 0 top, 1 bottom, 2 left, 3 right
+    float lo, hi;       // extent along the rail that keeps clear of the jaw noses
+} RailRun;
+
+typedef struct {
+    Cushion cushions[TABLE_MAX_CUSHIONS];
+    int cushionCount;
+    BvhNode nodes[2 * TABLE_MAX_CUSHIONS];
+    int nodeCount;
+
+    RailRun runs[6];
+
+    Vector2 pockets[6];
+    float fieldMinX, fieldMinY, fieldMaxX, fieldMaxY;   // cushion lines
+    float safeMinX, safeMinY, safeMaxX, safeMaxY;       // ball centres inside touch nothing
+} TableGeometry;
+
+const TableGeometry *GetTableGeometry(void);
+void BuildTableGeometry(TableGeometry *table);
+
+int SweepBall(const TableGeometry *table, Ball *ball, float restitution);
+int PocketAt(const TableGeometry *table, Vector2 position);
+
+#endif // TABLE_H
@@ -0,0 +1,19 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "common.h"
+
+// One line of the telemetry log, written when a shot comes to rest
+typedef struct {
+    int shotNumber;
+    GameState stateAfter;
+    int ballsRemaining[2];
+    ShotStats stats;
+} ShotRecord;
+
+bool TelemetryInit(const char *path);
+void TelemetryCountEvents(ShotStats *stats, const EventRing *events);
+void TelemetryRecordShot(const Game *game);
+void TelemetryShutdown(void);
+
+#endif // TELEMETRY_H
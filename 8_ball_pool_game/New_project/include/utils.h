@@ -3,8 +3,30 @@
 
 #include "common.h"
 
+// Frame time accumulator: mean, variance and a 0.1 ms histogram for percentiles
+#define FRAME_STATS_BUCKETS 1000
+
+typedef struct {
+    long count;
+    double sum;
+    double sumSq;
+    double max;
+    int histogram[FRAME_STATS_BUCKETS];
+} FrameStats;
+
 float Distance(Vector2 a, Vector2 b);
-void ClampBallSpeed(Ball *b, float maxSpeed);
+bool ClampBallSpeed(Ball *b, float maxSpeed);
 bool AreBallsMoving(Game *game);
+double NowSeconds(void);
+void SleepSeconds(double seconds);
+
+// xorshift64 for tools: reproducible from the seed in *state, which must not be 0
+unsigned int RandomNext(unsigned long long *state);
+float RandomFloat(unsigned long long *state);     // [0, 1)
+
+void FrameStatsReset(FrameStats *stats);
+void FrameStatsAdd(FrameStats *stats, double seconds);
+double FrameStatsPercentile(const FrameStats *stats, double p);
+void FrameStatsPrint(const FrameStats *stats, const char *label);
 
 #endif // UTILS_H
@@ -0,0 +1,357 @@
+#include "ai.h"
+#include "cache.h"
+#include "jobs.h"
+#include "placement.h"
+#include "policy.h"
+#include "layouts.h"
+#include "potlut.h"
+#include "utils.h"
+
+#define SEARCH_SHOTS (SEARCH_ANGLE_STEPS * SEARCH_POWER_STEPS)
+
+// Positive for balls the shooter wants down, large either way for the 8-ball.
+// Among otherwise equal shots the softer one wins, which leaves the table calmer.
+float ScoreOutcome(const Game *game, const ShotOutcome *outcome) {
+    if (outcome->eightPocketed) return outcome->stateAfter == GAME_WON ? 100.0f : -100.0f;
+
+    const Player *me = &game->players[game->currentPlayer];
+    float score = outcome->scratch ? -3.0f : 0.0f;
+    for (int i = 1; i < MAX_BALLS; i++) {
+        if (!(outcome->pocketed & (1u << i))) continue;
+        BallType type = game->balls[i].type;
+        bool mine = !game->assignedTypes ||
+                    (me->type == PLAYER_SOLIDS && type == BALL_SOLID) ||
+                    (me->type == PLAYER_STRIPES && type == BALL_STRIPE);
+        score += mine ? 1.0f : -1.0f;
+    }
+    return score;
+}
+
+typedef struct {
+    const Game *game;
+    unsigned long long stateHash;
+    ShotChoice *choices;
+    _Atomic int simulated;
+} SearchJob;
+
+// Shot index of the SEARCH_ANGLE_STEPS x SEARCH_POWER_STEPS grid
+static void EvaluateShot(SearchJob *job, int index, ShotChoice *c) {
+    // Search the cache bucket's own shot so a cached answer is exact
+    c->angle = (float)(index % SEARCH_ANGLE_STEPS) * (2.0f * PI / SEARCH_ANGLE_STEPS);
+    c->speed = MAX_SHOT_SPEED * (float)(index / SEARCH_ANGLE_STEPS + 1) / SEARCH_POWER_STEPS;
+    ShotCacheCanonical(&c->angle, &c->speed);
+
+    unsigned long long key = ShotCacheKey(job->stateHash, c->angle, c->speed);
+    if (!ShotCacheLookup(key, &c->outcome)) {
+        SimulateShot(job->game, c->angle, c->speed, NULL, &c->outcome);
+        ShotCacheStore(key, &c->outcome);
+        job->simulated++;
+    }
+    c->score = ScoreOutcome(job->game, &c->outcome) - 0.05f * c->speed / MAX_SHOT_SPEED;
+}
+
+static void SearchOne(int index, void *ctx) {
+    SearchJob *job = ctx;
+    EvaluateShot(job, index, &job->choices[index]);
+}
+
+static bool SearchFromHash(const Game *game, unsigned long long stateHash, ShotChoice *best, SearchStats *stats) {
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+
+    ShotChoice *choices = malloc(sizeof(ShotChoice) * SEARCH_SHOTS);
+    if (!choices) return false;
+
+    double start = NowSeconds();
+    SearchJob job = { game, stateHash, choices, 0 };
+    JobsParallelFor(SEARCH_SHOTS, SearchOne, &job);
+
+    // Lowest index wins ties, so the choice does not depend on thread timing
+    int bestIndex = 0;
+    for (int i = 1; i < SEARCH_SHOTS; i++) {
+        if (choices[i].score > choices[bestIndex].score) bestIndex = i;
+    }
+    *best = choices[bestIndex];
+    free(choices);
+
+    if (stats) {
+        stats->simulated += job.simulated;
+        stats->cached += SEARCH_SHOTS - job.simulated;
+        stats->seconds += NowSeconds() - start;
+    }
+    return true;
+}
+
+bool SearchShot(const Game *game, ShotChoice *best, SearchStats *stats) {
+    return SearchFromHash(game, StateHash(game), best, stats);
+}
+
+// Every angleStride-th angle and powerStride-th power of SearchShot's grid,
+// ending at full power, on the calling thread: for callers that already
+// spread their own work across the job pool. Being a subset of the same grid,
+// it shares cache entries with SearchShot.
+bool SearchShotCoarse(const Game *game, unsigned long long stateHash, int angleStride, int powerStride,
+                      ShotChoice *best) {
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+
+    SearchJob job = { game, stateHash, NULL, 0 };
+    bool found = false;
+    for (int p = powerStride - 1; p < SEARCH_POWER_STEPS; p += powerStride) {
+        for (int a = 0; a < SEARCH_ANGLE_STEPS; a += angleStride) {
+            ShotChoice c;
+            EvaluateShot(&job, p * SEARCH_ANGLE_STEPS + a, &c);
+            if (!found || c.score > best->score) *best = c;
+            found = true;
+        }
+    }
+    return found;
+}
+
+typedef struct {
+    SearchJob *search;
+    ShotChoice *choices;
+    const int *indices;
+} ConfirmJob;
+
+// Screening fidelity: never cached, since the cache only holds exact answers
+static void ScreenOne(int index, void *ctx) {
+    SearchJob *job = ctx;
+    ShotChoice *c = &job->choices[index];
+    c->angle = (float)(index % SEARCH_ANGLE_STEPS) * (2.0f * PI / SEARCH_ANGLE_STEPS);
+    c->speed = MAX_SHOT_SPEED * (float)(index / SEARCH_ANGLE_STEPS + 1) / SEARCH_POWER_STEPS;
+    ShotCacheCanonical(&c->angle, &c->speed);
+    SimulateShotCoarse(job->game, c->angle, c->speed, COARSE_STRIDE, NULL, &c->outcome);
+    c->score = ScoreOutcome(job->game, &c->outcome) - 0.05f * c->speed / MAX_SHOT_SPEED;
+}
+
+static void ConfirmOne(int index, void *ctx) {
+    ConfirmJob *job = ctx;
+    EvaluateShot(job->search, job->indices[index], &job->choices[index]);
+}
+
+// The top confirm shots of the screening pass, best first, ties to the lower index
+static int ScreenedFavourites(const ShotChoice *choices, int *indices, int confirm) {
+    int n = 0;
+    for (int i = 0; i < SEARCH_SHOTS; i++) {
+        if (n == confirm && choices[i].score <= choices[indices[n - 1]].score) continue;
+        int k = n < confirm ? n++ : n - 1;
+        while (k > 0 && choices[indices[k - 1]].score < choices[i].score) {
+            indices[k] = indices[k - 1];
+            k--;
+        }
+        indices[k] = i;
+    }
+    return n;
+}
+
+// Two passes over SearchShot's grid: every shot at screening fidelity, then
+// the confirm best of those exactly (through the cache), the pick made on
+// exact scores only
+bool SearchShotScreened(const Game *game, int confirm, ShotChoice *best, SearchStats *stats) {
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+    if (confirm < 1) confirm = 1;
+    if (confirm > SEARCH_SHOTS) confirm = SEARCH_SHOTS;
+
+    ShotChoice *choices = malloc(sizeof(ShotChoice) * SEARCH_SHOTS);
+    int *indices = malloc(sizeof(int) * (size_t)confirm);
+    ShotChoice *confirmed = malloc(sizeof(ShotChoice) * (size_t)confirm);
+    if (!choices || !indices || !confirmed) {
+        free(choices);
+        free(indices);
+        free(confirmed);
+        return false;
+    }
+
+    double start = NowSeconds();
+    SearchJob job = { game, StateHash(game), choices, 0 };
+    JobsParallelFor(SEARCH_SHOTS, ScreenOne, &job);
+    int count = ScreenedFavourites(choices, indices, confirm);
+
+    ConfirmJob exact = { &job, confirmed, indices };
+    JobsParallelFor(count, ConfirmOne, &exact);
+    int bestIndex = 0;
+    for (int k = 1; k < count; k++) {
+        if (confirmed[k].score > confirmed[bestIndex].score) bestIndex = k;
+    }
+    *best = confirmed[bestIndex];
+
+    if (stats) {
+        stats->screened += SEARCH_SHOTS;
+        stats->simulated += job.simulated;
+        stats->cached += count - job.simulated;
+        stats->seconds += NowSeconds() - start;
+    }
+    free(choices);
+    free(indices);
+    free(confirmed);
+    return true;
+}
+
+// Shots from the learned policy: its POLICY_SHORTLIST favourites on the
+// search grid are simulated (or found in the cache) and scored as
+// SearchShot would. False without a policy. The best of the short list can
+// still be a foul or a miss, so a caller should run the full search when
+// its score is not above zero.
+bool SearchShotPolicy(const Game *game, ShotChoice *best, SearchStats *stats) {
+    const PolicyModel *model = GetPolicy();
+    if (!model) return false;
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+
+    double start = NowSeconds();
+    PolicyShot shots[POLICY_SHORTLIST];
+    int count = PolicyShortlist(model, game, shots, POLICY_SHORTLIST);
+    SearchJob job = { game, StateHash(game), NULL, 0 };
+    for (int i = 0; i < count; i++) {
+        ShotChoice c;
+        EvaluateShot(&job, shots[i].index, &c);
+        if (i == 0 || c.score > best->score) *best = c;
+    }
+
+    if (stats) {
+        stats->simulated += job.simulated;
+        stats->cached += count - job.simulated;
+        stats->seconds += NowSeconds() - start;
+    }
+    return count > 0;
+}
+
+// Shots borrowed from the LAYOUT_NEIGHBOURS nearest solved layouts, mirrored
+// into the live table's frame and simulated (or cached) here, since a near
+// layout can still hide a blocker. False without a library or a match.
+bool SearchShotLayouts(const Game *game, ShotChoice *best, SearchStats *stats) {
+    const LayoutIndex *index = GetLayoutIndex();
+    if (!index) return false;
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+
+    double start = NowSeconds();
+    LayoutMatch matches[LAYOUT_NEIGHBOURS];
+    int count = LayoutIndexNearest(index, game, matches, LAYOUT_NEIGHBOURS, NULL);
+    unsigned long long stateHash = StateHash(game);
+    int simulated = 0;
+    for (int k = 0; k < count; k++) {
+        ShotChoice c;
+        c.angle = matches[k].angle;
+        c.speed = matches[k].speed;
+        ShotCacheCanonical(&c.angle, &c.speed);
+        unsigned long long key = ShotCacheKey(stateHash, c.angle, c.speed);
+        if (!ShotCacheLookup(key, &c.outcome)) {
+            SimulateShot(game, c.angle, c.speed, NULL, &c.outcome);
+            ShotCacheStore(key, &c.outcome);
+            simulated++;
+        }
+        c.score = ScoreOutcome(game, &c.outcome) - 0.05f * c.speed / MAX_SHOT_SPEED;
+        if (k == 0 || c.score > best->score) *best = c;
+    }
+
+    if (stats) {
+        stats->simulated += simulated;
+        stats->cached += count - simulated;
+        stats->seconds += NowSeconds() - start;
+    }
+    return count > 0;
+}
+
+// Balls the shooter can gain from potting: their own group, any but the
+// 8-ball while the groups are open, and the 8-ball once their group is down
+static bool WantsBall(const Game *game, int i) {
+    const Ball *b = &game->balls[i];
+    if (b->pocketed) return false;
+    if (!game->assignedTypes) return b->type != BALL_EIGHT;
+    BallType mine = game->players[game->currentPlayer].type == PLAYER_SOLIDS ? BALL_SOLID : BALL_STRIPE;
+    if (b->type == mine) return true;
+    if (b->type != BALL_EIGHT) return false;
+    for (int k = 1; k < MAX_BALLS; k++) {
+        if (!game->balls[k].pocketed && game->balls[k].type == mine) return false;
+    }
+    return true;
+}
+
+// Shots read off the pot table instead of the search grid: for each wanted
+// ball and each pocket it can be potted in cleanly, the ghost-ball aim at
+// POT_SEARCH_POWER_STEPS speeds, simulated (or cached) to catch blockers and
+// scratches. Far fewer shots than the grid, on the calling thread. False if
+// there is no table or no candidate; the caller falls back to the grid.
+bool SearchPotShots(const Game *game, unsigned long long stateHash, ShotChoice *best, SearchStats *stats) {
+    const PotLut *lut = GetPotLut();
+    if (!lut) return false;
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return false;
+    if (game->ballsMoving || game->shotPending || game->balls[0].pocketed) return false;
+
+    double start = NowSeconds();
+    int tried = 0, simulated = 0;
+    for (int i = 1; i < MAX_BALLS; i++) {
+        if (!WantsBall(game, i)) continue;
+        PotCandidate candidates[6];
+        int count = PotLutCandidates(lut, game->balls[0].position, game->balls[i].position, candidates);
+        for (int k = 0; k < count; k++) {
+            for (int p = 1; p <= POT_SEARCH_POWER_STEPS; p++) {
+                ShotChoice c;
+                c.angle = candidates[k].cueAngle;
+                c.speed = MAX_SHOT_SPEED * p / POT_SEARCH_POWER_STEPS;
+                ShotCacheCanonical(&c.angle, &c.speed);
+                unsigned long long key = ShotCacheKey(stateHash, c.angle, c.speed);
+                if (!ShotCacheLookup(key, &c.outcome)) {
+                    SimulateShot(game, c.angle, c.speed, NULL, &c.outcome);
+                    ShotCacheStore(key, &c.outcome);
+                    simulated++;
+                }
+                c.score = ScoreOutcome(game, &c.outcome) - 0.05f * c.speed / MAX_SHOT_SPEED;
+                if (tried == 0 || c.score > best->score) *best = c;
+                tried++;
+            }
+        }
+    }
+
+    if (stats) {
+        stats->simulated += simulated;
+        stats->cached += tried - simulated;
+        stats->seconds += NowSeconds() - start;
+    }
+    return tried > 0;
+}
+
+// Ball in hand: tries the default spot and a coarse grid of others, scoring
+// each by the best shot available from it. Only the cue ball moves between
+// candidates, so the state hash is updated rather than recomputed.
+bool ChooseCuePlacement(const Game *game, Vector2 *position, SearchStats *stats) {
+    Game trial = *game;
+    trial.state = GAME_PLAYING;
+    trial.balls[0].pocketed = false;
+    trial.balls[0].velocity = (Vector2){ 0, 0 };
+    unsigned long long baseHash = StateHash(&trial) ^ StateHashBall(0, &trial.balls[0]);
+
+    Vector2 spots[7] = { game->cueBallPos };
+    int count = 1;
+    for (int gy = 1; gy <= 2; gy++) {
+        for (int gx = 1; gx <= 3; gx++) {
+            spots[count++] = (Vector2){ RAIL_WIDTH + (TABLE_WIDTH - 2 * RAIL_WIDTH) * gx / 4.0f,
+                                        RAIL_WIDTH + (TABLE_HEIGHT - 2 * RAIL_WIDTH) * gy / 3.0f };
+        }
+    }
+
+    BallGrid grid;
+    BallGridBuild(&grid, game);
+
+    bool found = false;
+    float bestScore = -1e9f;
+    for (int s = 0; s < count; s++) {
+        if (!BallGridIsFree(&grid, game, spots[s], BALL_RADIUS * 2.2f)) continue;
+        trial.balls[0].position = spots[s];
+
+        // A spot with a clean pot on offer is scored from the pot table alone
+        ShotChoice choice;
+        unsigned long long hash = baseHash ^ StateHashBall(0, &trial.balls[0]);
+        bool potted = SearchPotShots(&trial, hash, &choice, stats) && choice.score > 0.0f;
+        if (!potted && !SearchFromHash(&trial, hash, &choice, stats)) continue;
+        if (choice.score > bestScore) {
+            bestScore = choice.score;
+            *position = spots[s];
+            found = true;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,164 @@
+#include "atlas.h"
+#include "sim.h"
+#include <limits.h>
+
+static const char atlasMagic[8] = { 'P', 'O', 'O', 'L', 'A', 'T', 'L', 'S' };
+
+static BreakAtlas defaultAtlas;
+static bool defaultLoaded;
+
+static bool Periodic(const BreakAtlasHeader *h, int axis) {
+    return axis == 2 && fabsf(h->maxValue[2] - h->minValue[2] - 2.0f * PI) < 0.001f;
+}
+
+void BreakAtlasInitHeader(BreakAtlasHeader *h, const int dims[4], const float minValue[4], const float maxValue[4]) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, atlasMagic, sizeof(atlasMagic));
+    h->version = BREAK_ATLAS_VERSION;
+    h->specHash = TableSpecHash();
+    h->recordSize = sizeof(BreakRecord);
+    h->recordCount = 1;
+    for (int a = 0; a < 4; a++) {
+        h->dims[a] = dims[a];
+        h->minValue[a] = minValue[a];
+        h->maxValue[a] = maxValue[a];
+        h->recordCount *= (unsigned int)dims[a];
+    }
+}
+
+float BreakAtlasAxisValue(const BreakAtlasHeader *h, int axis, int i) {
+    int n = h->dims[axis];
+    float span = h->maxValue[axis] - h->minValue[axis];
+    if (Periodic(h, axis)) return h->minValue[axis] + span * i / n;
+    if (n <= 1) return h->minValue[axis];
+    return h->minValue[axis] + span * i / (n - 1);
+}
+
+int BreakAtlasIndex(const BreakAtlasHeader *h, const int cell[4]) {
+    return ((cell[0] * h->dims[1] + cell[1]) * h->dims[2] + cell[2]) * h->dims[3] + cell[3];
+}
+
+bool BreakAtlasOpen(BreakAtlas *atlas, const char *path) {
+    atlas->header = NULL;
+    atlas->records = NULL;
+    if (!MapFileOpen(&atlas->file, path)) return false;
+
+    const BreakAtlasHeader *h = atlas->file.data;
+    bool ok = atlas->file.size >= sizeof(BreakAtlasHeader) &&
+              memcmp(h->magic, atlasMagic, sizeof(atlasMagic)) == 0 &&
+              h->version == BREAK_ATLAS_VERSION &&
+              h->recordSize == sizeof(BreakRecord) &&
+              atlas->file.size >= sizeof(BreakAtlasHeader) + (size_t)h->recordCount * sizeof(BreakRecord);
+    // Cell indices come from the grid, so it has to cover the records exactly;
+    // bounds that are not finite would turn lookups into NaN cells
+    unsigned long long cells = 1;
+    for (int axis = 0; ok && axis < 4; axis++) {
+        ok = h->dims[axis] > 0 && isfinite(h->minValue[axis]) && isfinite(h->maxValue[axis]);
+        if (ok) cells *= (unsigned long long)h->dims[axis];
+        if (cells > INT_MAX) ok = false;
+    }
+    if (ok && cells != h->recordCount) ok = false;
+    if (ok && h->specHash != TableSpecHash()) {
+        fprintf(stderr, "atlas: %s was built for a different table or physics\n", path);
+        ok = false;
+    }
+    if (!ok) {
+        MapFileClose(&atlas->file);
+        return false;
+    }
+
+    atlas->header = h;
+    atlas->records = (const BreakRecord *)((const char *)atlas->file.data + sizeof(BreakAtlasHeader));
+    return true;
+}
+
+void BreakAtlasClose(BreakAtlas *atlas) {
+    MapFileClose(&atlas->file);
+    atlas->header = NULL;
+    atlas->records = NULL;
+}
+
+// Continuous grid coordinate of value along axis (clamped, or wrapped for angle)
+static float GridCoord(const BreakAtlasHeader *h, int axis, float value) {
+    int n = h->dims[axis];
+    float span = h->maxValue[axis] - h->minValue[axis];
+    if (Periodic(h, axis)) {
+        float t = fmodf(value - h->minValue[axis], span);
+        if (t < 0.0f) t += span;
+        return t / span * n;
+    }
+    if (n <= 1 || span <= 0.0f) return 0.0f;
+    float t = (value - h->minValue[axis]) / span * (n - 1);
+    if (t < 0.0f) t = 0.0f;
+    if (t > n - 1) t = (float)(n - 1);
+    return t;
+}
+
+static int WrapCell(const BreakAtlasHeader *h, int axis, int i) {
+    int n = h->dims[axis];
+    if (Periodic(h, axis)) return ((i % n) + n) % n;
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+const BreakRecord *BreakAtlasNearest(const BreakAtlas *atlas, Vector2 cue, float angle, float power) {
+    if (!atlas || !atlas->header) return NULL;
+    const BreakAtlasHeader *h = atlas->header;
+    float value[4] = { cue.x, cue.y, angle, power };
+    int cell[4];
+    for (int a = 0; a < 4; a++) cell[a] = WrapCell(h, a, (int)floorf(GridCoord(h, a, value[a]) + 0.5f));
+    return &atlas->records[BreakAtlasIndex(h, cell)];
+}
+
+// Multilinear interpolation over the 16 surrounding grid points
+bool BreakAtlasEstimate(const BreakAtlas *atlas, Vector2 cue, float angle, float power,
+                        float *expectedPocketed, float *scratchChance) {
+    if (!atlas || !atlas->header) return false;
+    const BreakAtlasHeader *h = atlas->header;
+    float value[4] = { cue.x, cue.y, angle, power };
+    int base[4];
+    float frac[4];
+    for (int a = 0; a < 4; a++) {
+        float g = GridCoord(h, a, value[a]);
+        base[a] = (int)floorf(g);
+        frac[a] = g - base[a];
+    }
+
+    float pocketed = 0.0f;
+    float scratch = 0.0f;
+    for (int corner = 0; corner < 16; corner++) {
+        float w = 1.0f;
+        int cell[4];
+        for (int a = 0; a < 4; a++) {
+            int up = (corner >> a) & 1;
+            w *= up ? frac[a] : 1.0f - frac[a];
+            cell[a] = WrapCell(h, a, base[a] + up);
+        }
+        if (w == 0.0f) continue;
+        const BreakRecord *r = &atlas->records[BreakAtlasIndex(h, cell)];
+        pocketed += w * r->ballsPocketed;
+        if (r->flags & BREAK_SCRATCH) scratch += w;
+    }
+
+    if (expectedPocketed) *expectedPocketed = pocketed;
+    if (scratchChance) *scratchChance = scratch;
+    return true;
+}
+
+void BreakRecordApply(const BreakRecord *r, Game *game) {
+    for (int i = 0; i < MAX_BALLS; i++) {
+        game->balls[i].pocketed = (r->pocketed >> i) & 1;
+        game->balls[i].position = (Vector2){ (float)r->x[i] / BREAK_LAYOUT_QUANT,
+                                             (float)r->y[i] / BREAK_LAYOUT_QUANT };
+        game->balls[i].velocity = (Vector2){ 0, 0 };
+    }
+}
+
+bool BreakAtlasLoadDefault(const char *path) {
+    if (defaultLoaded) return true;
+    defaultLoaded = BreakAtlasOpen(&defaultAtlas, path);
+    return defaultLoaded;
+}
+
+const BreakAtlas *GetBreakAtlas(void) {
+    return defaultLoaded ? &defaultAtlas : NULL;
+}
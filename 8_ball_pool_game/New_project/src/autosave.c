@@ -0,0 +1,156 @@
+#include "autosave.h"
+#include "mapfile.h"
+#include "sim.h"
+#include "utils.h"
+#include <pthread.h>
+
+static const char autosaveMagic[8] = { 'P', 'O', 'O', 'L', 'S', 'A', 'V', 'E' };
+
+// slots[pending] waits for the writer and slots[writing] is being written;
+// the two are never the same buffer, so neither side copies under the lock
+static struct {
+    char path[512];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    Game slots[2];
+    int pending;                // -1 when nothing waits
+    int writing;                // -1 when the writer is idle
+    unsigned int sequence[2];
+    bool running;
+    AutosaveReport report;
+} autosave = { .pending = -1, .writing = -1 };
+
+static unsigned int Checksum(const void *data, size_t size) {
+    const unsigned char *p = data;
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static bool WriteSnapshot(const Game *game, unsigned int sequence) {
+    AutosaveHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, autosaveMagic, sizeof(autosaveMagic));
+    h.version = AUTOSAVE_VERSION;
+    h.specHash = TableSpecHash();
+    h.gameSize = sizeof(Game);
+    h.sequence = sequence;
+    h.checksum = Checksum(game, sizeof(Game));
+
+    char temp[520];
+    snprintf(temp, sizeof(temp), "%s.tmp", autosave.path);
+    FILE *f = fopen(temp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(game, sizeof(Game), 1, f) == 1 && FileCommit(f);
+    if (fclose(f) != 0) ok = false;
+    ok = ok && FileReplace(temp, autosave.path);
+    if (!ok) remove(temp);
+    return ok;
+}
+
+static void *WriterThread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&autosave.lock);
+    for (;;) {
+        while (autosave.running && autosave.pending < 0) pthread_cond_wait(&autosave.wake, &autosave.lock);
+        if (autosave.pending < 0) break;
+
+        int slot = autosave.writing = autosave.pending;
+        autosave.pending = -1;
+        unsigned int sequence = autosave.sequence[slot];
+        pthread_mutex_unlock(&autosave.lock);
+
+        double start = NowSeconds();
+        bool ok = WriteSnapshot(&autosave.slots[slot], sequence);
+        double ms = (NowSeconds() - start) * 1000.0;
+
+        pthread_mutex_lock(&autosave.lock);
+        autosave.writing = -1;
+        AutosaveReport *r = &autosave.report;
+        if (ok) r->written++;
+        else r->failed++;
+        r->writeMillisLast = ms;
+        if (ms > r->writeMillisMax) r->writeMillisMax = ms;
+    }
+    pthread_mutex_unlock(&autosave.lock);
+    return NULL;
+}
+
+bool AutosaveStart(const char *path) {
+    if (autosave.running) return true;
+    snprintf(autosave.path, sizeof(autosave.path), "%s", path);
+    pthread_mutex_init(&autosave.lock, NULL);
+    pthread_cond_init(&autosave.wake, NULL);
+    autosave.pending = autosave.writing = -1;
+    memset(&autosave.report, 0, sizeof(autosave.report));
+    autosave.running = true;
+    if (pthread_create(&autosave.thread, NULL, WriterThread, NULL) != 0) {
+        autosave.running = false;
+        return false;
+    }
+    return true;
+}
+
+void AutosaveShot(const Game *game) {
+    if (!autosave.running) return;
+    double start = NowSeconds();
+
+    // Reclaim a snapshot the writer has not started on, else take the free buffer
+    pthread_mutex_lock(&autosave.lock);
+    int slot = autosave.pending >= 0 ? autosave.pending : autosave.writing == 0 ? 1 : 0;
+    if (autosave.pending >= 0) autosave.report.coalesced++;
+    autosave.pending = -1;
+    pthread_mutex_unlock(&autosave.lock);
+
+    autosave.slots[slot] = *game;
+
+    pthread_mutex_lock(&autosave.lock);
+    AutosaveReport *r = &autosave.report;
+    autosave.sequence[slot] = (unsigned int)++r->snapshots;
+    autosave.pending = slot;
+    pthread_cond_signal(&autosave.wake);
+    double us = (NowSeconds() - start) * 1e6;
+    r->snapshotMicrosLast = us;
+    r->snapshotMicrosSum += us;
+    if (us > r->snapshotMicrosMax) r->snapshotMicrosMax = us;
+    pthread_mutex_unlock(&autosave.lock);
+}
+
+void AutosaveStop(void) {
+    if (!autosave.running) return;
+    pthread_mutex_lock(&autosave.lock);
+    autosave.running = false;
+    pthread_cond_signal(&autosave.wake);
+    pthread_mutex_unlock(&autosave.lock);
+    pthread_join(autosave.thread, NULL);
+    pthread_cond_destroy(&autosave.wake);
+    pthread_mutex_destroy(&autosave.lock);
+}
+
+bool AutosaveLoad(const char *path, Game *game) {
+    MappedFile file;
+    if (!MapFileOpen(&file, path)) return false;
+
+    const AutosaveHeader *h = file.data;
+    const Game *saved = (const Game *)((const char *)file.data + sizeof(AutosaveHeader));
+    bool ok = file.size >= sizeof(AutosaveHeader) + sizeof(Game) &&
+              memcmp(h->magic, autosaveMagic, sizeof(autosaveMagic)) == 0 &&
+              h->version == AUTOSAVE_VERSION && h->gameSize == sizeof(Game) &&
+              h->specHash == TableSpecHash() &&
+              h->checksum == Checksum(saved, sizeof(Game));
+    if (ok) ok = saved->state != GAME_WON && saved->state != GAME_LOST;
+    if (ok) *game = *saved;
+    MapFileClose(&file);
+    return ok;
+}
+
+void AutosavePrintReport(FILE *out) {
+    const AutosaveReport *r = &autosave.report;
+    if (r->snapshots == 0) return;
+    fprintf(out, "autosave: %d snapshots, %d written, %d coalesced, %d failed; "
+                 "snapshot mean %.1f us, max %.1f us; write last %.2f ms, max %.2f ms\n",
+            r->snapshots, r->written, r->coalesced, r->failed,
+            r->snapshotMicrosSum / r->snapshots, r->snapshotMicrosMax,
+            r->writeMillisLast, r->writeMillisMax);
+}
@@ -0,0 +1,157 @@
+#include "cache.h"
+#include <stdatomic.h>
+
+// Each slot holds a packed outcome and (key XOR outcome). A reader accepts a
+// slot only if the two words XOR back to its key, so a slot torn by a racing
+// writer simply reads as a miss; no locks or sequence counters are needed.
+// Slots are grouped in pairs: a store replaces its own key, then an empty
+// slot, then one of the pair picked by the key.
+
+typedef struct {
+    _Atomic unsigned long long check;
+    _Atomic unsigned long long data;
+} CacheSlot;
+
+static struct {
+    CacheSlot *slots;
+    unsigned long long mask;
+    int slotCount;
+    atomic_llong lookups;
+    atomic_llong hits;
+    atomic_llong stores;
+    atomic_llong overwrites;
+} cache;
+
+static unsigned long long PackOutcome(const ShotOutcome *o) {
+    unsigned long long d = o->pocketed;
+    d |= (unsigned long long)(o->scratch ? 1 : 0) << 16;
+    d |= (unsigned long long)(o->eightPocketed ? 1 : 0) << 17;
+    d |= (unsigned long long)(o->stateAfter & 7) << 18;
+    d |= (unsigned long long)(o->nextPlayer & 1) << 21;
+    d |= (unsigned long long)(unsigned)o->steps << 32;
+    return d;
+}
+
+static void UnpackOutcome(unsigned long long d, ShotOutcome *o) {
+    o->pocketed = (unsigned short)(d & 0xffff);
+    o->scratch = (d >> 16) & 1;
+    o->eightPocketed = (d >> 17) & 1;
+    o->stateAfter = (GameState)((d >> 18) & 7);
+    o->nextPlayer = (int)((d >> 21) & 1);
+    o->steps = (int)(d >> 32);
+}
+
+bool ShotCacheInit(int slotsLog2) {
+    ShotCacheShutdown();
+    if (slotsLog2 < 1) slotsLog2 = 1;
+    int count = 1 << slotsLog2;
+    cache.slots = malloc(sizeof(CacheSlot) * (size_t)count);
+    if (!cache.slots) return false;
+    cache.slotCount = count;
+    cache.mask = (unsigned long long)(count - 1);
+    ShotCacheClear();
+    return true;
+}
+
+void ShotCacheShutdown(void) {
+    free(cache.slots);
+    cache.slots = NULL;
+    cache.slotCount = 0;
+}
+
+void ShotCacheClear(void) {
+    for (int i = 0; i < cache.slotCount; i++) {
+        atomic_store_explicit(&cache.slots[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&cache.slots[i].data, 0, memory_order_relaxed);
+    }
+    atomic_store(&cache.lookups, 0);
+    atomic_store(&cache.hits, 0);
+    atomic_store(&cache.stores, 0);
+    atomic_store(&cache.overwrites, 0);
+}
+
+static void QuantizeShot(float angle, float speed, long *qa, long *qs) {
+    float turn = angle / (2.0f * PI);
+    turn -= floorf(turn);
+    *qa = lroundf(turn * SHOT_ANGLE_QUANT) % SHOT_ANGLE_QUANT;
+    *qs = lroundf(speed / MAX_SHOT_SPEED * SHOT_SPEED_QUANT);
+}
+
+void ShotCacheCanonical(float *angle, float *speed) {
+    long qa, qs;
+    QuantizeShot(*angle, *speed, &qa, &qs);
+    *angle = (float)qa * (2.0f * PI / SHOT_ANGLE_QUANT);
+    *speed = (float)qs * (MAX_SHOT_SPEED / SHOT_SPEED_QUANT);
+}
+
+unsigned long long ShotCacheKey(unsigned long long stateHash, float angle, float speed) {
+    long qa, qs;
+    QuantizeShot(angle, speed, &qa, &qs);
+    unsigned long long shot = ((unsigned long long)qa << 16) | (unsigned long long)(qs & 0xffff);
+    unsigned long long key = stateHash ^ (shot * 0x9e3779b97f4a7c15ull);
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 32;
+    return key ? key : 1;   // 0 marks an empty slot
+}
+
+bool ShotCacheLookup(unsigned long long key, ShotOutcome *out) {
+    if (!cache.slots) return false;
+    atomic_fetch_add_explicit(&cache.lookups, 1, memory_order_relaxed);
+
+    CacheSlot *pair = &cache.slots[key & cache.mask & ~1ull];
+    for (int i = 0; i < 2; i++) {
+        unsigned long long data = atomic_load_explicit(&pair[i].data, memory_order_relaxed);
+        unsigned long long check = atomic_load_explicit(&pair[i].check, memory_order_relaxed);
+        if ((check ^ data) == key) {
+            UnpackOutcome(data, out);
+            atomic_fetch_add_explicit(&cache.hits, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShotCacheStore(unsigned long long key, const ShotOutcome *outcome) {
+    if (!cache.slots) return;
+    atomic_fetch_add_explicit(&cache.stores, 1, memory_order_relaxed);
+
+    CacheSlot *pair = &cache.slots[key & cache.mask & ~1ull];
+    CacheSlot *target = NULL;
+    for (int i = 0; i < 2 && !target; i++) {
+        unsigned long long data = atomic_load_explicit(&pair[i].data, memory_order_relaxed);
+        unsigned long long check = atomic_load_explicit(&pair[i].check, memory_order_relaxed);
+        if ((check ^ data) == key || (check == 0 && data == 0)) target = &pair[i];
+    }
+    if (!target) {
+        target = &pair[(key >> 40) & 1];
+        atomic_fetch_add_explicit(&cache.overwrites, 1, memory_order_relaxed);
+    }
+
+    unsigned long long data = PackOutcome(outcome);
+    atomic_store_explicit(&target->data, data, memory_order_relaxed);
+    atomic_store_explicit(&target->check, key ^ data, memory_order_relaxed);
+}
+
+void ShotCacheGetReport(ShotCacheReport *report) {
+    memset(report, 0, sizeof(*report));
+    report->lookups = atomic_load(&cache.lookups);
+    report->hits = atomic_load(&cache.hits);
+    report->stores = atomic_load(&cache.stores);
+    report->overwrites = atomic_load(&cache.overwrites);
+    report->slots = cache.slotCount;
+    report->bytes = sizeof(CacheSlot) * (size_t)cache.slotCount;
+    for (int i = 0; i < cache.slotCount; i++) {
+        if (atomic_load_explicit(&cache.slots[i].check, memory_order_relaxed) != 0) report->used++;
+    }
+}
+
+void ShotCachePrintReport(FILE *f) {
+    ShotCacheReport r;
+    ShotCacheGetReport(&r);
+    double hitRate = r.lookups > 0 ? 100.0 * (double)r.hits / (double)r.lookups : 0.0;
+    double fill = r.slots > 0 ? 100.0 * r.used / r.slots : 0.0;
+    fprintf(f, "shot cache: %lld lookups, %.1f%% hits, %lld stores (%lld evictions), "
+               "%d/%d slots used (%.1f%%), %.1f KiB\n",
+            r.lookups, hitRate, r.stores, r.overwrites, r.used, r.slots, fill, r.bytes / 1024.0);
+}
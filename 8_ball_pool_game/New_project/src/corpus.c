@@ -0,0 +1,188 @@
+#include "corpus.h"
+#include "game.h"
+#include "placement.h"
+#include "sim.h"
+#include <limits.h>
+
+#define CORPUS_ALIGN 64             // columns start on cache lines
+
+static const char corpusMagic[8] = { 'P', 'O', 'O', 'L', 'C', 'R', 'P', 'S' };
+
+// --- Writing ---
+
+void CorpusWriterInit(CorpusWriter *w) {
+    memset(w, 0, sizeof(*w));
+}
+
+void CorpusWriterFree(CorpusWriter *w) {
+    free(w->shots);
+    free(w->gameFirst);
+    memset(w, 0, sizeof(*w));
+}
+
+bool CorpusAddGame(CorpusWriter *w, const CorpusShot *shots, int count) {
+    if (count <= 0) return true;
+    if (w->shotCount + (unsigned int)count > w->shotCapacity) {
+        unsigned int capacity = w->shotCapacity ? w->shotCapacity : 4096;
+        while (capacity < w->shotCount + (unsigned int)count) capacity *= 2;
+        CorpusShot *grown = realloc(w->shots, sizeof(CorpusShot) * capacity);
+        if (!grown) return false;
+        w->shots = grown;
+        w->shotCapacity = capacity;
+    }
+    if (w->gameCount == w->gameCapacity) {
+        unsigned int capacity = w->gameCapacity ? w->gameCapacity * 2 : 256;
+        unsigned int *grown = realloc(w->gameFirst, sizeof(unsigned int) * capacity);
+        if (!grown) return false;
+        w->gameFirst = grown;
+        w->gameCapacity = capacity;
+    }
+    w->gameFirst[w->gameCount++] = w->shotCount;
+    memcpy(&w->shots[w->shotCount], shots, sizeof(CorpusShot) * (size_t)count);
+    w->shotCount += (unsigned int)count;
+    return true;
+}
+
+void CorpusShotStrike(CorpusShot *row, int player, Vector2 cue, float angle, float speed) {
+    memset(row, 0, sizeof(*row));
+    row->player = (unsigned char)player;
+    row->angle = angle;
+    row->speed = speed;
+    row->cue = cue;
+}
+
+void CorpusShotResult(CorpusShot *row, unsigned short pocketed, GameState stateAfter) {
+    row->pocketed = pocketed;
+    row->flags = ((pocketed & 1u) ? CORPUS_SCRATCH : 0) | ((pocketed & (1u << 8)) ? CORPUS_EIGHT : 0);
+    row->stateAfter = (unsigned char)stateAfter;
+}
+
+// One column gathered out of the rows, written at the next aligned offset
+static bool WriteColumn(FILE *f, CorpusColumnInfo *info, const CorpusWriter *w, CorpusColumn column) {
+    static const unsigned char zeros[CORPUS_ALIGN];
+    long at = ftell(f);
+    long pad = (CORPUS_ALIGN - at % CORPUS_ALIGN) % CORPUS_ALIGN;
+    if (pad && fwrite(zeros, 1, (size_t)pad, f) != (size_t)pad) return false;
+    info->offset = (unsigned long long)(at + pad);
+
+    if (column == CORPUS_GAME_FIRST) {
+        info->elementSize = sizeof(unsigned int);
+        info->count = w->gameCount + 1;
+        return fwrite(w->gameFirst, sizeof(unsigned int), w->gameCount, f) == w->gameCount &&
+               fwrite(&w->shotCount, sizeof(unsigned int), 1, f) == 1;
+    }
+
+    static const unsigned int sizes[CORPUS_COLUMNS] = {
+        sizeof(unsigned char), sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+        sizeof(unsigned short), sizeof(unsigned char), sizeof(unsigned char)
+    };
+    info->elementSize = sizes[column];
+    info->count = w->shotCount;
+
+    unsigned char buffer[4096];
+    unsigned int perBuffer = sizeof(buffer) / info->elementSize;
+    for (unsigned int first = 0; first < w->shotCount; first += perBuffer) {
+        unsigned int n = w->shotCount - first < perBuffer ? w->shotCount - first : perBuffer;
+        for (unsigned int i = 0; i < n; i++) {
+            const CorpusShot *s = &w->shots[first + i];
+            void *dst = buffer + (size_t)i * info->elementSize;
+            switch (column) {
+                case CORPUS_PLAYER:   memcpy(dst, &s->player, 1); break;
+                case CORPUS_ANGLE:    memcpy(dst, &s->angle, 4); break;
+                case CORPUS_SPEED:    memcpy(dst, &s->speed, 4); break;
+                case CORPUS_CUE_X:    memcpy(dst, &s->cue.x, 4); break;
+                case CORPUS_CUE_Y:    memcpy(dst, &s->cue.y, 4); break;
+                case CORPUS_POCKETED: memcpy(dst, &s->pocketed, 2); break;
+                case CORPUS_FLAGS:    memcpy(dst, &s->flags, 1); break;
+                case CORPUS_STATE:    memcpy(dst, &s->stateAfter, 1); break;
+                default: break;
+            }
+        }
+        if (fwrite(buffer, info->elementSize, n, f) != n) return false;
+    }
+    return true;
+}
+
+// The header goes last, once the column offsets are known
+bool CorpusWriterSave(const CorpusWriter *w, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+
+    CorpusHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, corpusMagic, sizeof(corpusMagic));
+    h.version = CORPUS_VERSION;
+    h.specHash = TableSpecHash();
+    h.shotCount = w->shotCount;
+    h.gameCount = w->gameCount;
+
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (int col = 0; ok && col < CORPUS_COLUMNS; col++) ok = WriteColumn(f, &h.columns[col], w, (CorpusColumn)col);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+// --- Reading ---
+
+static const void *ColumnData(const Corpus *c, const CorpusHeader *h, CorpusColumn column,
+                              unsigned int elementSize, unsigned int count) {
+    const CorpusColumnInfo *info = &h->columns[column];
+    if (info->elementSize != elementSize || info->count != count || info->offset % CORPUS_ALIGN != 0) return NULL;
+    unsigned long long size = c->file.size;
+    if (info->offset > size || (unsigned long long)elementSize * count > size - info->offset) return NULL;
+    return (const char *)c->file.data + info->offset;
+}
+
+bool CorpusOpen(Corpus *c, const char *path) {
+    memset(c, 0, sizeof(*c));
+    if (!MapFileOpen(&c->file, path)) return false;
+
+    const CorpusHeader *h = c->file.data;
+    bool ok = c->file.size >= sizeof(CorpusHeader) &&
+              memcmp(h->magic, corpusMagic, sizeof(corpusMagic)) == 0 &&
+              h->version == CORPUS_VERSION;
+    if (ok) {
+        if (h->specHash != TableSpecHash()) {
+            fprintf(stderr, "corpus: %s was recorded with a different table or physics; replays will differ\n", path);
+        }
+        unsigned int n = c->shotCount = h->shotCount;
+        c->gameCount = h->gameCount;
+        c->player   = ColumnData(c, h, CORPUS_PLAYER, 1, n);
+        c->angle    = ColumnData(c, h, CORPUS_ANGLE, 4, n);
+        c->speed    = ColumnData(c, h, CORPUS_SPEED, 4, n);
+        c->cueX     = ColumnData(c, h, CORPUS_CUE_X, 4, n);
+        c->cueY     = ColumnData(c, h, CORPUS_CUE_Y, 4, n);
+        c->pocketed = ColumnData(c, h, CORPUS_POCKETED, 2, n);
+        c->flags    = ColumnData(c, h, CORPUS_FLAGS, 1, n);
+        c->state    = ColumnData(c, h, CORPUS_STATE, 1, n);
+        c->gameFirst = h->gameCount < UINT_MAX ? ColumnData(c, h, CORPUS_GAME_FIRST, 4, h->gameCount + 1) : NULL;
+        ok = c->player && c->angle && c->speed && c->cueX && c->cueY && c->pocketed &&
+             c->flags && c->state && c->gameFirst && c->gameFirst[0] == 0 && c->gameFirst[c->gameCount] == n;
+    }
+    // Readers slice the columns by game with no checks of their own
+    for (unsigned int g = 0; ok && g < c->gameCount; g++) {
+        ok = c->gameFirst[g] <= c->gameFirst[g + 1] && c->gameFirst[g + 1] <= c->shotCount;
+    }
+    if (!ok) {
+        MapFileClose(&c->file);
+        return false;
+    }
+    return true;
+}
+
+void CorpusClose(Corpus *c) {
+    MapFileClose(&c->file);
+    memset(c, 0, sizeof(*c));
+}
+
+bool CorpusReplayShot(const Corpus *c, unsigned int row, Game *table, unsigned short *pocketed) {
+    if (table->state == GAME_WON || table->state == GAME_LOST) return false;
+    if (table->state == GAME_SCRATCH && !PlaceCueBall(table, (Vector2){ c->cueX[row], c->cueY[row] })) return false;
+
+    Game before = *table;
+    ShotOutcome outcome;
+    SimulateShot(&before, c->angle[row], c->speed[row], table, &outcome);
+    if (pocketed) *pocketed = outcome.pocketed;
+    return true;
+}
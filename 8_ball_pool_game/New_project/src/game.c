@@ -1,6 +1,18 @@
 #include "game.h"
 #include "physics.h"
 #include "utils.h"
+#include "telemetry.h"
+#include "events.h"
+#include "rewind.h"
+#include "placement.h"
+#include "autosave.h"
+#include "latency.h"
+#include "runahead.h"
+
+static void FinishShot(Game *game) {
+    game->shotPending = false;
+    if (!game->headless) TelemetryRecordShot(game);
+}
 
 void InitGame(Game *game) {
     strcpy(game->players[0].name, "Player 1");
@@ -25,6 +37,21 @@ void InitGame(Game *game) {
     game->stickRecoil = false;
     game->recoilTimer = 0.0f;
 
+    game->shotNumber = 0;
+    game->shotPending = false;
+    game->playbackSpeed = 1;
+    game->skipToRest = false;
+    game->mousePos = (Vector2){ 0, 0 };
+    game->headless = false;
+    game->physicsStride = 0;
+    memset(&game->shotStats, 0, sizeof(game->shotStats));
+    game->scrubbing = false;
+    game->scrubFrame = 0;
+    game->scrubFrames = 0;
+    game->placementHelp = false;
+    game->cueGridReady = false;
+    memset(&game->events, 0, sizeof(game->events));
+
     ResetBalls(game);
 }
 
@@ -76,8 +103,17 @@ void ResetBalls(Game *game) {
     game->cueBallPos = game->balls[0].position;
 }
 
-void UpdateGame(Game *game) {
-    HandleInput(game);
+// One frame of game logic. input may be NULL when nothing was sampled.
+void UpdateGame(Game *game, const InputFrame *input) {
+    if (input) HandleInput(game, input);
+    TickGame(game);
+}
+
+// Everything in a frame that does not depend on input: stick recoil and the
+// physics steps for the current playback speed
+void TickGame(Game *game) {
+    // Paused on a rewound frame until the player resumes
+    if (game->scrubbing) return;
 
     // Stick recoil animation
     if (game->stickRecoil) {
@@ -92,47 +128,108 @@ void UpdateGame(Game *game) {
         }
     }
 
-    if (game->state == GAME_PLAYING || game->state == GAME_SCRATCH) {
-        UpdatePhysics(game);
+    if (game->skipToRest) {
+        game->skipToRest = false;
+        FastForwardShot(game, FAST_FORWARD_MAX_STEPS);
+    } else {
+        for (int step = 0; step < game->playbackSpeed; step++) StepSimulation(game);
+    }
+
+    RewindRecord(game);
+}
 
-        if (!game->ballsMoving && AreBallsMoving(game)) game->ballsMoving = true;
+// One physics step plus the rule checks that run when the balls come to rest.
+// Does nothing outside of play, so it is safe to call in a loop.
+void StepSimulation(Game *game) {
+    if (game->state != GAME_PLAYING && game->state != GAME_SCRATCH) return;
 
-        if (game->ballsMoving && !AreBallsMoving(game)) {
-            game->ballsMoving = false;
-            if (game->state == GAME_PLAYING) {
-                CheckWinCondition(game);
-                if (game->state != GAME_WON && game->state != GAME_LOST) {
-                    NextTurn(game);
-                }
+    if (game->physicsStride > 1) UpdatePhysicsCoarse(game, game->physicsStride);
+    else UpdatePhysics(game);
+    LatencyStep(game);
+
+    // Hand the step's events to each consumer in turn, then drop the batch
+    TelemetryCountEvents(&game->shotStats, &game->events);
+    CheckPockets(game);
+    EventRingClear(&game->events);
+
+    if (game->shotPending) game->shotStats.framesToRest++;
+
+    if (!game->ballsMoving && AreBallsMoving(game)) game->ballsMoving = true;
+
+    bool boundary = false;
+    if (game->ballsMoving && !AreBallsMoving(game)) {
+        game->ballsMoving = false;
+        if (game->shotPending) FinishShot(game);
+        // Ball in hand: the object balls stay put until the cue ball is down
+        if (game->state == GAME_SCRATCH) {
+            BallGridBuild(&game->cueGrid, game);
+            game->cueGridReady = true;
+        }
+        if (game->state == GAME_PLAYING) {
+            CheckWinCondition(game);
+            if (game->state != GAME_WON && game->state != GAME_LOST) {
+                NextTurn(game);
             }
         }
+        boundary = true;
+    }
+
+    // The rules stop the physics on a won/lost game, so the shot never comes to rest
+    if (game->shotPending && (game->state == GAME_WON || game->state == GAME_LOST)) {
+        FinishShot(game);
+        boundary = true;
+    }
+
+    // Turn and rules settled: the table as a restart would resume it
+    if (boundary && !game->headless) AutosaveShot(game);
+}
+
+// Simulates the rest of the current shot without drawing, applying the same
+// pocket and turn rules as normal play. Returns the number of steps taken.
+int FastForwardShot(Game *game, int maxSteps) {
+    int steps = 0;
+    while ((game->shotPending || game->ballsMoving) && steps < maxSteps &&
+           (game->state == GAME_PLAYING || game->state == GAME_SCRATCH)) {
+        StepSimulation(game);
+        steps++;
     }
+    return steps;
 }
 
-void HandleInput(Game *game) {
-    if (IsKeyPressed(KEY_R)) {
+void HandleInput(Game *game, const InputFrame *input) {
+    game->mousePos = input->mouse;
+
+    if (input->keyReset) {
         InitGame(game);
+        game->mousePos = input->mouse;
         return;
     }
 
-    Vector2 mousePos = GetMousePosition();
+    // Playback speed and skip-to-rest for a shot in progress
+    if (input->keyPlaybackSpeed) {
+        game->playbackSpeed = game->playbackSpeed >= MAX_PLAYBACK_SPEED ? 1 : game->playbackSpeed * 2;
+    }
+    if (input->keySkipToRest && (game->ballsMoving || game->shotPending)) {
+        game->skipToRest = true;
+    }
+
+    // Practice rewind: undo the last shot, or pause and step through it
+    if (!game->headless) {
+        if (input->keyUndo) RewindUndo(game);
+        if (input->scrubFrames != 0) RewindScrub(game, input->scrubFrames);
+        if (input->keyResume) RewindResume(game);
+    }
+    if (game->scrubbing) return;
+
+    Vector2 mousePos = input->mouse;
+
+    // Heatmap for the next ball in hand, or the current one
+    if (input->keyPlacementHelp) game->placementHelp = !game->placementHelp;
 
     // Scratch: place cue ball
     if (game->state == GAME_SCRATCH) {
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            if (mousePos.x > RAIL_WIDTH + BALL_RADIUS &&
-                mousePos.x < TABLE_WIDTH  - RAIL_WIDTH - BALL_RADIUS &&
-                mousePos.y > RAIL_WIDTH + BALL_RADIUS &&
-                mousePos.y < TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS) {
-                game->cueBallPos = mousePos;
-                game->balls[0].position = game->cueBallPos;
-                game->balls[0].pocketed = false;
-                game->balls[0].velocity = (Vector2){0, 0};
-                game->state = GAME_PLAYING;
-                sprintf(game->statusMessage, "Cue placed. %s's turn", game->players[game->currentPlayer].name);
-            } else {
-                strcpy(game->statusMessage, "Invalid position! Place inside rails");
-            }
+        if (input->mousePressed && !PlaceCueBall(game, mousePos)) {
+            strcpy(game->statusMessage, "Invalid position! Place inside rails, clear of the balls");
         }
         return;
     }
@@ -142,7 +239,7 @@ void HandleInput(Game *game) {
     Vector2 cueBallPos = game->balls[0].pocketed ? game->cueBallPos : game->balls[0].position;
 
     // Start drag
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    if (input->mousePressed) {
         if (Distance(mousePos, cueBallPos) <= BALL_RADIUS * 1.6f) {
             game->aiming = true;
             game->dragStart = mousePos;
@@ -152,37 +249,72 @@ void HandleInput(Game *game) {
     }
 
     // Dragging back
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && game->aiming) {
+    if (input->mouseDown && game->aiming) {
         game->stickPullPixels = Distance(mousePos, cueBallPos);
         game->power = game->stickPullPixels / MAX_POWER_PIXELS;
     }
 
     // Release — shoot
-    if (game->aiming && IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+    if (game->aiming && input->mouseReleased) {
         game->aiming = false;
 
-        Vector2 dir = { mousePos.x - cueBallPos.x, mousePos.y - cueBallPos.y };
-        float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
-        if (len < 0.001f) {
+        float angle, shotSpeed;
+        if (!GetAim(game, &angle, &shotSpeed)) {
             game->stickPullPixels = 0.0f;
             game->power = 0.0f;
             return;
         }
-        dir.x /= len;
-        dir.y /= len;
 
-        float shotSpeed = (game->stickPullPixels / MAX_POWER_PIXELS) * MAX_SHOT_SPEED;
-        if (shotSpeed > MAX_SHOT_SPEED) shotSpeed = MAX_SHOT_SPEED;
+        // Run-ahead may hand over this shot already some frames in
+        Vector2 cueFrom = game->balls[0].position;
+        int ahead = RunAheadTake(game, angle, shotSpeed);
+        if (ahead == 0) ReleaseShot(game, angle, shotSpeed);
+        if (!game->headless) LatencyShotTaken(game->shotNumber, cueFrom, input->time, ahead);
+        return;
+    }
 
-        game->balls[0].velocity.x = dir.x * shotSpeed;
-        game->balls[0].velocity.y = dir.y * shotSpeed;
+    // Still drawn back: simulate ahead the shot a release would take now
+    if (game->aiming && input->mouseDown) RunAheadSpeculate(game);
+}
 
-        game->state = GAME_PLAYING;
-        game->firstShot = false;
-        game->stickRecoil = true;
-        game->recoilTimer = STICK_RECOIL_TIME;
-        game->power = 0.0f;
-    }
+// The shot as the mouse releases it, with the stick's recoil
+void ReleaseShot(Game *game, float angle, float shotSpeed) {
+    game->aiming = false;
+    TakeShot(game, angle, shotSpeed);
+    game->stickRecoil = true;
+    game->recoilTimer = STICK_RECOIL_TIME;
+    game->power = 0.0f;
+}
+
+// The shot a release would take right now: towards the mouse, with speed
+// from the stick pull. False when the mouse is on the cue ball.
+bool GetAim(const Game *game, float *angle, float *shotSpeed) {
+    Vector2 cueBallPos = game->balls[0].pocketed ? game->cueBallPos : game->balls[0].position;
+    Vector2 dir = { game->mousePos.x - cueBallPos.x, game->mousePos.y - cueBallPos.y };
+    float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
+    if (len < 0.001f) return false;
+
+    *angle = atan2f(dir.y, dir.x);
+    *shotSpeed = (game->stickPullPixels / MAX_POWER_PIXELS) * MAX_SHOT_SPEED;
+    if (*shotSpeed > MAX_SHOT_SPEED) *shotSpeed = MAX_SHOT_SPEED;
+    return true;
+}
+
+// Strikes the cue ball and starts the per-shot bookkeeping. Shared by mouse
+// input and the headless simulations, so both produce identical shots.
+void TakeShot(Game *game, float angle, float shotSpeed) {
+    game->balls[0].velocity.x = cosf(angle) * shotSpeed;
+    game->balls[0].velocity.y = sinf(angle) * shotSpeed;
+
+    memset(&game->shotStats, 0, sizeof(game->shotStats));
+    game->shotStats.player = game->currentPlayer;
+    game->shotStats.shotAngle = angle;
+    game->shotStats.shotSpeed = shotSpeed;
+    game->shotNumber++;
+    game->shotPending = true;
+
+    game->state = GAME_PLAYING;
+    game->firstShot = false;
 }
 
 int playerIndexForType(Game *game, BallType btype) {
@@ -196,62 +328,56 @@ int playerIndexForType(Game *game, BallType btype) {
     return -1;
 }
 
+// The rules half of pocketing: reads this step's pocket events, assigns
+// groups, counts down the balls remaining and decides the game on the 8-ball.
 void CheckPockets(Game *game) {
-    Vector2 pockets[6];
-    GetPocketPositions(pockets);
-
     bool cueBallPocketed = false;
     bool anyPocketed = false;
 
-    for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed) continue;
+    int count = EventRingCount(&game->events);
+    for (int k = 0; k < count; k++) {
+        const PhysicsEvent *e = EventRingAt(&game->events, k);
+        if (e->type != EVENT_POCKET) continue;
+        int i = e->a;
+        anyPocketed = true;
 
-        for (int p = 0; p < 6; p++) {
-            if (Distance(game->balls[i].position, pockets[p]) < POCKET_RADIUS) {
-                game->balls[i].pocketed = true;
-                game->balls[i].velocity = (Vector2){0, 0};
-                anyPocketed = true;
+        if (i == 0) {
+            cueBallPocketed = true;
+            game->cueBallPos = (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
+        } else {
+            // Assign ball types on first pocket
+            if (!game->assignedTypes) {
+                if (game->balls[i].type == BALL_SOLID) {
+                    game->players[game->currentPlayer].type     = PLAYER_SOLIDS;
+                    game->players[1 - game->currentPlayer].type = PLAYER_STRIPES;
+                    game->assignedTypes = true;
+                    sprintf(game->statusMessage, "%s = Solids, %s = Stripes",
+                            game->players[game->currentPlayer].name,
+                            game->players[1 - game->currentPlayer].name);
+                } else if (game->balls[i].type == BALL_STRIPE) {
+                    game->players[game->currentPlayer].type     = PLAYER_STRIPES;
+                    game->players[1 - game->currentPlayer].type = PLAYER_SOLIDS;
+                    game->assignedTypes = true;
+                    sprintf(game->statusMessage, "%s = Stripes, %s = Solids",
+                            game->players[game->currentPlayer].name,
+                            game->players[1 - game->currentPlayer].name);
+                }
+            }
 
-                if (i == 0) {
-                    cueBallPocketed = true;
-                    game->cueBallPos = (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
+            // 8-ball pocketed
+            if (game->balls[i].type == BALL_EIGHT) {
+                int myIdx = game->currentPlayer;
+                if (game->players[myIdx].ballsRemaining == 0) {
+                    game->state = GAME_WON;
                 } else {
-                    // Assign ball types on first pocket
-                    if (!game->assignedTypes) {
-                        if (game->balls[i].type == BALL_SOLID) {
-                            game->players[game->currentPlayer].type     = PLAYER_SOLIDS;
-                            game->players[1 - game->currentPlayer].type = PLAYER_STRIPES;
-                            game->assignedTypes = true;
-                            sprintf(game->statusMessage, "%s = Solids, %s = Stripes",
-                                    game->players[game->currentPlayer].name,
-                                    game->players[1 - game->currentPlayer].name);
-                        } else if (game->balls[i].type == BALL_STRIPE) {
-                            game->players[game->currentPlayer].type     = PLAYER_STRIPES;
-                            game->players[1 - game->currentPlayer].type = PLAYER_SOLIDS;
-                            game->assignedTypes = true;
-                            sprintf(game->statusMessage, "%s = Stripes, %s = Solids",
-                                    game->players[game->currentPlayer].name,
-                                    game->players[1 - game->currentPlayer].name);
-                        }
-                    }
-
-                    // 8-ball pocketed
-                    if (game->balls[i].type == BALL_EIGHT) {
-                        int myIdx = game->currentPlayer;
-                        if (game->players[myIdx].ballsRemaining == 0) {
-                            game->state = GAME_WON;
-                        } else {
-                            game->state = GAME_LOST;
-                        }
-                        return;
-                    } else {
-                        int ownerIdx = playerIndexForType(game, game->balls[i].type);
-                        if (ownerIdx >= 0 && game->players[ownerIdx].ballsRemaining > 0) {
-                            game->players[ownerIdx].ballsRemaining--;
-                        }
-                    }
+                    game->state = GAME_LOST;
+                }
+                return;
+            } else {
+                int ownerIdx = playerIndexForType(game, game->balls[i].type);
+                if (ownerIdx >= 0 && game->players[ownerIdx].ballsRemaining > 0) {
+                    game->players[ownerIdx].ballsRemaining--;
                 }
-                break;
             }
         }
     }
@@ -262,8 +388,23 @@ void CheckPockets(Game *game) {
     }
 }
 
+// Ball in hand: puts the cue ball at position if it is inside the rails and
+// resumes play. Shared by the mouse and the computer player.
+bool PlaceCueBall(Game *game, Vector2 position) {
+    if (!CueSpotIsValid(game, position)) return false;
+    game->cueBallPos = position;
+    game->balls[0].position = game->cueBallPos;
+    game->balls[0].pocketed = false;
+    game->balls[0].velocity = (Vector2){0, 0};
+    game->state = GAME_PLAYING;
+    game->cueGridReady = false;
+    sprintf(game->statusMessage, "Cue placed. %s's turn", game->players[game->currentPlayer].name);
+    return true;
+}
+
 void ApplyScratch(Game *game) {
     game->state = GAME_SCRATCH;
+    game->cueGridReady = false;     // built once the other balls stop
     strcpy(game->statusMessage, "Scratch! Place cue ball");
     game->currentPlayer = 1 - game->currentPlayer;
 }
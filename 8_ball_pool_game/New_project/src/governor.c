@@ -0,0 +1,113 @@
+#include "governor.h"
+
+static const char *workNames[SHED_COUNT] = { "aim preview", "HUD refresh", "overlay alpha", "background AI" };
+static const char *phaseNames[PHASE_COUNT] = { "update", "draw", "present" };
+
+static struct {
+    bool initialized;
+    double frameStart;
+    double phaseStart;
+    double phaseSeconds[PHASE_COUNT];
+    int overRun;            // consecutive frames over budget
+    int headroomRun;        // consecutive frames with headroom
+    GovernorReport report;
+} governor;
+
+void GovernorInit(double budgetSeconds) {
+    memset(&governor, 0, sizeof(governor));
+    governor.report.budget = budgetSeconds;
+    for (int p = 0; p < PHASE_COUNT; p++) FrameStatsReset(&governor.report.phases[p]);
+    governor.initialized = true;
+}
+
+void GovernorBeginFrame(void) {
+    if (!governor.initialized) return;
+    governor.frameStart = governor.phaseStart = NowSeconds();
+    memset(governor.phaseSeconds, 0, sizeof(governor.phaseSeconds));
+}
+
+void GovernorMark(FramePhase phase) {
+    if (!governor.initialized) return;
+    double now = NowSeconds();
+    governor.phaseSeconds[phase] += now - governor.phaseStart;
+    governor.phaseStart = now;
+}
+
+static void Decide(GovernorReport *r, bool shed, float workMs) {
+    if (shed) r->sheds++;
+    else r->restores++;
+    OptionalWork work = (OptionalWork)(shed ? r->level : r->level - 1);
+    r->level += shed ? 1 : -1;
+
+    if (r->decisionCount == GOVERNOR_DECISIONS) {
+        memmove(&r->decisions[0], &r->decisions[1], sizeof(r->decisions[0]) * (GOVERNOR_DECISIONS - 1));
+        r->decisionCount--;
+    }
+    r->decisions[r->decisionCount++] = (GovernorDecision){ r->frames, work, shed, workMs };
+    governor.overRun = governor.headroomRun = 0;
+}
+
+void GovernorEndFrame(void) {
+    if (!governor.initialized) return;
+    GovernorMark(PHASE_PRESENT);
+    GovernorReport *r = &governor.report;
+
+    double work = governor.phaseSeconds[PHASE_UPDATE] + governor.phaseSeconds[PHASE_DRAW];
+    double total = governor.phaseStart - governor.frameStart;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        FrameStatsAdd(&r->phases[p], governor.phaseSeconds[p]);
+        r->historyMs[r->historyNext][p] = (float)(governor.phaseSeconds[p] * 1000.0);
+    }
+    r->historyLevel[r->historyNext] = (unsigned char)r->level;
+    r->historyNext = (r->historyNext + 1) % GOVERNOR_HISTORY;
+    r->framesAtLevel[r->level]++;
+    r->frames++;
+
+    if (r->budget <= 0.0) return;
+    bool over = work > r->budget * GOVERNOR_HIGH || total > r->budget * GOVERNOR_MISS;
+    bool headroom = !over && work < r->budget * GOVERNOR_LOW;
+    if (over) r->overFrames++;
+    governor.overRun = over ? governor.overRun + 1 : 0;
+    governor.headroomRun = headroom ? governor.headroomRun + 1 : 0;
+
+    if (governor.overRun >= GOVERNOR_SHED_FRAMES && r->level < SHED_COUNT) {
+        Decide(r, true, (float)(work * 1000.0));
+    } else if (governor.headroomRun >= GOVERNOR_RESTORE_FRAMES && r->level > 0) {
+        Decide(r, false, (float)(work * 1000.0));
+    }
+}
+
+bool GovernorSheds(OptionalWork work) {
+    return (int)work < governor.report.level;
+}
+
+const char *GovernorWorkName(OptionalWork work) {
+    return workNames[work];
+}
+
+const GovernorReport *GovernorGetReport(void) {
+    return governor.initialized ? &governor.report : NULL;
+}
+
+void GovernorPrintReport(FILE *out) {
+    const GovernorReport *r = &governor.report;
+    if (!governor.initialized || r->frames == 0) return;
+
+    fprintf(out, "governor: budget %.1f ms, %ld frames, %ld over budget, %d sheds, %d restores, %d shed at exit\n",
+            r->budget * 1000.0, r->frames, r->overFrames, r->sheds, r->restores, r->level);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const FrameStats *s = &r->phases[p];
+        fprintf(out, "  %-8s mean %.3f ms, p99 %.1f ms, max %.3f ms\n", phaseNames[p],
+                s->sum / s->count * 1000.0, FrameStatsPercentile(s, 0.99) * 1000.0, s->max * 1000.0);
+    }
+    for (int w = 0; w < SHED_COUNT; w++) {
+        long shed = 0;
+        for (int level = w + 1; level <= SHED_COUNT; level++) shed += r->framesAtLevel[level];
+        fprintf(out, "  %-14s shed %ld frames (%.1f%%)\n", workNames[w], shed, 100.0 * shed / r->frames);
+    }
+    for (int i = 0; i < r->decisionCount; i++) {
+        const GovernorDecision *d = &r->decisions[i];
+        fprintf(out, "  frame %ld: %s %s (work %.2f ms)\n", d->frame, d->shed ? "shed" : "restored",
+                workNames[d->work], d->workMs);
+    }
+}
@@ -1,4 +1,14 @@
 #include "graphics.h"
+#include "atlas.h"
+#include "potlut.h"
+#include "table.h"
+#include "odds.h"
+#include "placement.h"
+#include "governor.h"
+#include "latency.h"
+
+static bool profilerVisible;
+static bool latencyVisible;
 
 void DrawTable(void) {
     // Felt surface
@@ -12,6 +22,19 @@ void DrawTable(void) {
     DrawRectangle(TABLE_WIDTH - RAIL_WIDTH, 0, RAIL_WIDTH, TABLE_HEIGHT, BROWN);
 }
 
+void DrawPockets(void) {
+    Vector2 pockets[6];
+    GetPocketPositions(pockets);
+    for (int i = 0; i < 6; i++) DrawCircleV(pockets[i], POCKET_RADIUS, BLACK);
+
+    // Cushion noses and jaws, as the physics sees them
+    const TableGeometry *table = GetTableGeometry();
+    for (int i = 0; i < table->cushionCount; i++) {
+        const Cushion *c = &table->cushions[i];
+        DrawLineEx(c->a, c->b, 2.0f + 2.0f * c->radius, DARKGREEN);
+    }
+}
+
 void DrawBalls(Game *game) {
     for (int i = 0; i < MAX_BALLS; i++) {
         if (game->balls[i].pocketed) continue;
@@ -41,12 +64,51 @@ void DrawBalls(Game *game) {
     }
 }
 
+// Aim assist from the pot table: the first ball the aim meets, the line it
+// leaves along, and the pocket it drops in if that line is inside a window
+static void DrawPotAssist(const Game *game, Vector2 cue, Vector2 dir) {
+    int hit = -1;
+    float nearest = 1e9f;
+    for (int i = 1; i < MAX_BALLS; i++) {
+        const Ball *b = &game->balls[i];
+        if (b->pocketed) continue;
+        Vector2 to = { b->position.x - cue.x, b->position.y - cue.y };
+        float along = to.x * dir.x + to.y * dir.y;
+        float miss2 = to.x * to.x + to.y * to.y - along * along;
+        float reach2 = 4.0f * BALL_RADIUS * BALL_RADIUS;
+        if (along <= 0.0f || miss2 >= reach2) continue;
+        float t = along - sqrtf(reach2 - miss2);
+        if (t < nearest) {
+            nearest = t;
+            hit = i;
+        }
+    }
+    if (hit < 0) return;
+
+    Vector2 ghost = { cue.x + dir.x * nearest, cue.y + dir.y * nearest };
+    Vector2 object = game->balls[hit].position;
+    float leave = atan2f(object.y - ghost.y, object.x - ghost.x);
+    DrawCircleLines((int)ghost.x, (int)ghost.y, BALL_RADIUS, Fade(WHITE, 0.35f));
+
+    for (int k = 0; k < 6; k++) {
+        float angle, margin;
+        if (!PotLutWindow(GetPotLut(), object, k, &angle, &margin)) continue;
+        if (fabsf(remainderf(leave - angle, 2.0f * PI)) > margin) continue;
+        Vector2 pocket = GetTableGeometry()->pockets[k];
+        DrawLineEx(object, pocket, 1.5f, Fade(GOLD, 0.5f));
+        DrawCircleLines((int)pocket.x, (int)pocket.y, POCKET_RADIUS, GOLD);
+        return;
+    }
+    Vector2 end = { object.x + cosf(leave) * 60.0f, object.y + sinf(leave) * 60.0f };
+    DrawLineEx(object, end, 1.5f, Fade(WHITE, 0.22f));
+}
+
 void DrawCueStick(Game *game) {
     if (game->ballsMoving) return;
     if (game->state != GAME_START && game->state != GAME_PLAYING) return;
 
     Vector2 cueBallPos = game->balls[0].pocketed ? game->cueBallPos : game->balls[0].position;
-    Vector2 mousePos   = GetMousePosition();
+    Vector2 mousePos   = game->mousePos;
 
     Vector2 dir = { mousePos.x - cueBallPos.x, mousePos.y - cueBallPos.y };
     float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
@@ -65,8 +127,10 @@ void DrawCueStick(Game *game) {
 
     // Aiming line
     if (game->aiming) {
-        Vector2 lineEnd = { cueBallPos.x + dir.x * 420, cueBallPos.y + dir.y * 420 };
+        float reach = GovernorSheds(SHED_AIM_PREVIEW) ? AIM_PREVIEW_SHED_LENGTH : AIM_PREVIEW_LENGTH;
+        Vector2 lineEnd = { cueBallPos.x + dir.x * reach, cueBallPos.y + dir.y * reach };
         DrawLineEx(cueBallPos, lineEnd, 1.5f, Fade(WHITE, 0.22f));
+        if (GetPotLut() && !GovernorSheds(SHED_AIM_PREVIEW)) DrawPotAssist(game, cueBallPos, dir);
     }
 }
 
@@ -88,36 +152,129 @@ void DrawPowerBar(Game *game) {
     char pstr[32];
     sprintf(pstr, "%d%%", (int)((game->stickPullPixels / MAX_POWER_PIXELS) * 100.0f));
     DrawText(pstr, x + 80 + width + 8, y - 2, 16, WHITE);
+
+    // Success odds under execution noise; gold once the sampler has finished refining
+    float chance, margin;
+    int samples;
+    if (game->aiming && ShotOddsGet(&chance, &margin, &samples)) {
+        char ostr[48];
+        sprintf(ostr, "Pot %d%% +/-%d", (int)(chance * 100.0f + 0.5f), (int)(margin * 100.0f + 0.5f));
+        DrawText(ostr, x + 80 + width + 56, y - 2, 16, samples >= ODDS_MAX_SAMPLES ? GOLD : LIGHTGRAY);
+    }
+
+    // Break preview from the precomputed atlas, if one was loaded
+    if (game->state == GAME_START && game->aiming && GetBreakAtlas() && !GovernorSheds(SHED_AIM_PREVIEW)) {
+        Vector2 cue = game->balls[0].position;
+        float angle = atan2f(game->mousePos.y - cue.y, game->mousePos.x - cue.x);
+        float pull = game->stickPullPixels / MAX_POWER_PIXELS;
+        if (pull > 1.0f) pull = 1.0f;
+
+        float pocketed, scratch;
+        if (BreakAtlasEstimate(GetBreakAtlas(), cue, angle, pull, &pocketed, &scratch)) {
+            char btext[64];
+            sprintf(btext, "Break: %.1f balls, %d%% scratch", pocketed, (int)(scratch * 100.0f));
+            DrawText(btext, TABLE_WIDTH - 270, y - 2, 16, LIGHTGRAY);
+        }
+    }
+}
+
+// HUD text, rebuilt every frame unless the governor has shed the refresh
+static struct {
+    char scoreText[2][128];
+    char playerText[80];
+    char statusMessage[100];
+    char speedText[32];
+    long frame;
+} hud;
+
+static void RefreshHUD(const Game *game) {
+    for (int p = 0; p < 2; p++) {
+        sprintf(hud.scoreText[p], "%s: %d balls remaining", game->players[p].name, game->players[p].ballsRemaining);
+    }
+
+    PlayerType pt = game->players[game->currentPlayer].type;
+    if      (pt == PLAYER_SOLIDS)  sprintf(hud.playerText, "Current: %s (Solids)",     game->players[game->currentPlayer].name);
+    else if (pt == PLAYER_STRIPES) sprintf(hud.playerText, "Current: %s (Stripes)",    game->players[game->currentPlayer].name);
+    else                           sprintf(hud.playerText, "Current: %s (Unassigned)", game->players[game->currentPlayer].name);
+
+    strcpy(hud.statusMessage, game->statusMessage);
+    if (game->playbackSpeed > 1) sprintf(hud.speedText, "Speed x%d (Tab)", game->playbackSpeed);
+    else hud.speedText[0] = '\0';
 }
 
 void DrawHUD(Game *game) {
     DrawRectangle(0, TABLE_HEIGHT, TABLE_WIDTH, 100, (Color){30, 18, 10, 255});
 
-    char scoreText[128];
-    sprintf(scoreText, "%s: %d balls remaining", game->players[0].name, game->players[0].ballsRemaining);
-    DrawText(scoreText, 18, TABLE_HEIGHT + 12, 18, WHITE);
-    sprintf(scoreText, "%s: %d balls remaining", game->players[1].name, game->players[1].ballsRemaining);
-    DrawText(scoreText, 18, TABLE_HEIGHT + 40, 18, WHITE);
+    if (!GovernorSheds(SHED_HUD_REFRESH) || hud.frame % HUD_SHED_REFRESH_FRAMES == 0) RefreshHUD(game);
+    hud.frame++;
 
-    char playerText[80];
-    PlayerType pt = game->players[game->currentPlayer].type;
-    if      (pt == PLAYER_SOLIDS)  sprintf(playerText, "Current: %s (Solids)",     game->players[game->currentPlayer].name);
-    else if (pt == PLAYER_STRIPES) sprintf(playerText, "Current: %s (Stripes)",    game->players[game->currentPlayer].name);
-    else                           sprintf(playerText, "Current: %s (Unassigned)", game->players[game->currentPlayer].name);
+    DrawText(hud.scoreText[0], 18, TABLE_HEIGHT + 12, 18, WHITE);
+    DrawText(hud.scoreText[1], 18, TABLE_HEIGHT + 40, 18, WHITE);
+    DrawText(hud.playerText, TABLE_WIDTH - 360, TABLE_HEIGHT + 12, 18, WHITE);
+    DrawText(hud.statusMessage, TABLE_WIDTH - 360, TABLE_HEIGHT + 40, 16, YELLOW);
+    if (hud.speedText[0]) DrawText(hud.speedText, TABLE_WIDTH - 360, TABLE_HEIGHT + 70, 16, LIGHTGRAY);
+}
 
-    DrawText(playerText, TABLE_WIDTH - 360, TABLE_HEIGHT + 12, 18, WHITE);
-    DrawText(game->statusMessage, TABLE_WIDTH - 360, TABLE_HEIGHT + 40, 16, YELLOW);
+// Placement help: each scored spot shaded red (a foul or nothing) through
+// yellow to green (a ball down or more), the best one ringed in gold
+static void DrawPlacementHeatmap(void) {
+    PlacementHeatmap heatmap;
+    if (!PlacementHelpGet(&heatmap)) return;
+
+    const float cellW = (TABLE_WIDTH  - 2.0f * (RAIL_WIDTH + BALL_RADIUS)) / PLACEMENT_COLS;
+    const float cellH = (TABLE_HEIGHT - 2.0f * (RAIL_WIDTH + BALL_RADIUS)) / PLACEMENT_ROWS;
+    for (int row = 0; row < PLACEMENT_ROWS; row++) {
+        for (int col = 0; col < PLACEMENT_COLS; col++) {
+            if (heatmap.state[row][col] != SPOT_SCORED) continue;
+            float t = (heatmap.score[row][col] + 1.0f) / 3.0f;
+            t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+            Color heat = t < 0.5f ? (Color){ 230, (unsigned char)(80 + 320 * t), 40, 120 }
+                                  : (Color){ (unsigned char)(230 - 400 * (t - 0.5f)), 240, 40, 120 };
+            Vector2 spot = PlacementSpot(row, col);
+            DrawRectangle((int)(spot.x - cellW / 2), (int)(spot.y - cellH / 2), (int)cellW - 1, (int)cellH - 1, heat);
+        }
+    }
+    if (heatmap.bestRow >= 0) {
+        Vector2 best = PlacementSpot(heatmap.bestRow, heatmap.bestCol);
+        DrawCircleLines((int)best.x, (int)best.y, BALL_RADIUS + 3, GOLD);
+    }
+
+    char htext[48];
+    sprintf(htext, "Placement help: %d spots scored", heatmap.scored);
+    DrawText(htext, RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH + 12, 16, LIGHTGRAY);
+}
+
+// Dims the whole window behind an overlay; with overlay alpha shed, only the
+// band behind the overlay's text is covered, opaque
+static void OverlayBackdrop(unsigned char alpha, int bandTop, int bandHeight) {
+    if (GovernorSheds(SHED_OVERLAY_ALPHA)) DrawRectangle(0, bandTop, TABLE_WIDTH, bandHeight, BLACK);
+    else DrawRectangle(0, 0, TABLE_WIDTH, TABLE_HEIGHT + 100, (Color){0, 0, 0, alpha});
 }
 
 void DrawOverlays(Game *game) {
+    if (game->scrubbing) {
+        char rewindText[128];
+        sprintf(rewindText, "REWIND  frame %d/%d   Left/Right step (Shift x10)   Space resume   U undo shot",
+                game->scrubFrame, game->scrubFrames - 1);
+        DrawRectangle(0, 0, TABLE_WIDTH, 24, (Color){0, 0, 0, GovernorSheds(SHED_OVERLAY_ALPHA) ? 255 : 170});
+        DrawText(rewindText, 12, 4, 16, SKYBLUE);
+    }
+
     if (game->state == GAME_SCRATCH) {
-        DrawRectangle(0, 0, TABLE_WIDTH, TABLE_HEIGHT + 100, (Color){0, 0, 0, 150});
-        const char *msg = "SCRATCH! Click to place cue ball (inside rails)";
+        OverlayBackdrop(150, TABLE_HEIGHT/2 - 16, 32);
+        if (game->placementHelp) DrawPlacementHeatmap();
+
+        // The cue ball follows the mouse, red where it cannot go
+        bool valid = CueSpotIsValid(game, game->mousePos);
+        DrawCircleV(game->mousePos, BALL_RADIUS, valid ? Fade(WHITE, 0.7f) : Fade(RED, 0.7f));
+
+        const char *msg = game->placementHelp ? "SCRATCH! Click to place cue ball (H hides help)"
+                                              : "SCRATCH! Click to place cue ball (H for help)";
         DrawText(msg, TABLE_WIDTH/2 - MeasureText(msg, 20)/2, TABLE_HEIGHT/2 - 10, 20, RED);
     }
 
     if (game->state == GAME_WON || game->state == GAME_LOST) {
-        DrawRectangle(0, 0, TABLE_WIDTH, TABLE_HEIGHT + 100, (Color){0, 0, 0, 200});
+        OverlayBackdrop(200, TABLE_HEIGHT/2 - 48, 88);
         char winText[64];
         if (game->state == GAME_WON) {
             sprintf(winText, "%s WINS!", game->players[game->currentPlayer].name);
@@ -132,22 +289,135 @@ void DrawOverlays(Game *game) {
     }
 }
 
+// A saved match offered at startup, shown under the question
+void DrawResumePrompt(Game *saved) {
+    BeginDrawing();
+    ClearBackground((Color){8, 80, 23, 255});
+    DrawTable();
+    DrawPockets();
+    DrawBalls(saved);
+    DrawHUD(saved);
+
+    char text[96];
+    sprintf(text, "Resume the unfinished match? (%s to play, shot %d)",
+            saved->players[saved->currentPlayer].name, saved->shotNumber + 1);
+    OverlayBackdrop(200, TABLE_HEIGHT/2 - 40, 72);
+    DrawText(text, TABLE_WIDTH/2 - MeasureText(text, 20)/2, TABLE_HEIGHT/2 - 30, 20, WHITE);
+    const char *keys = "Enter to resume, N for a new game";
+    DrawText(keys, TABLE_WIDTH/2 - MeasureText(keys, 20)/2, TABLE_HEIGHT/2 + 2, 20, GOLD);
+    EndDrawing();
+}
+
+void SetProfilerVisible(bool visible) {
+    profilerVisible = visible;
+}
+
+// Recent frames as stacked columns against the budget line (update sky blue,
+// draw orange, present gray), each over a strip colored by how much was shed,
+// with what is shed now and the governor's latest decisions
+static void DrawProfiler(void) {
+    const GovernorReport *r = GovernorGetReport();
+    if (!r) return;
+
+    const int x = TABLE_WIDTH - 2 * GOVERNOR_HISTORY - 20, y = 30, graphH = 60;
+    const float budgetMs = r->budget > 0.0 ? (float)(r->budget * 1000.0) : 1000.0f / TARGET_FPS;
+    const float scale = graphH / (2.0f * budgetMs);     // the graph tops out at twice the budget
+    DrawRectangle(x - 6, y - 6, 2 * GOVERNOR_HISTORY + 12, graphH + 86, (Color){0, 0, 0, 200});
+
+    for (int i = 0; i < GOVERNOR_HISTORY; i++) {
+        int h = (r->historyNext + i) % GOVERNOR_HISTORY;
+        float base = 0.0f;
+        const Color colors[PHASE_COUNT] = { SKYBLUE, ORANGE, DARKGRAY };
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            float top = fminf(base + r->historyMs[h][p] * scale, (float)graphH);
+            DrawRectangle(x + 2 * i, y + graphH - (int)top, 2, (int)top - (int)base, colors[p]);
+            base = top;
+        }
+        unsigned char shade = (unsigned char)(r->historyLevel[h] * 255 / SHED_COUNT);
+        DrawRectangle(x + 2 * i, y + graphH + 2, 2, 4, (Color){ shade, (unsigned char)(255 - shade), 0, 255 });
+    }
+    int budgetY = y + graphH - (int)(budgetMs * scale);
+    DrawLine(x, budgetY, x + 2 * GOVERNOR_HISTORY, budgetY, RED);
+
+    char text[96];
+    int last = (r->historyNext + GOVERNOR_HISTORY - 1) % GOVERNOR_HISTORY;
+    sprintf(text, "work %.2f ms of %.1f", r->historyMs[last][PHASE_UPDATE] + r->historyMs[last][PHASE_DRAW], budgetMs);
+    DrawText(text, x, y + graphH + 10, 10, WHITE);
+    sprintf(text, "shed: %s", r->level == 0 ? "nothing" : "");
+    for (int w = 0; w < r->level; w++) {
+        strcat(text, GovernorWorkName((OptionalWork)w));
+        if (w + 1 < r->level) strcat(text, ", ");
+    }
+    DrawText(text, x, y + graphH + 24, 10, r->level ? ORANGE : LIGHTGRAY);
+    for (int i = 0; i < 3 && i < r->decisionCount; i++) {
+        const GovernorDecision *d = &r->decisions[r->decisionCount - 1 - i];
+        sprintf(text, "#%ld %s %s (%.1f ms)", d->frame, d->shed ? "shed" : "restored",
+                GovernorWorkName(d->work), d->workMs);
+        DrawText(text, x, y + graphH + 38 + 12 * i, 10, LIGHTGRAY);
+    }
+}
+
+void SetLatencyVisible(bool visible) {
+    latencyVisible = visible;
+}
+
+// Input-to-photon distribution of recent shots: a histogram of the totals,
+// then the last shot split into its stages
+static void DrawLatency(void) {
+    const LatencyReport *r = LatencyLockReport();
+    if (!r) return;
+
+    const int x = 20, y = 30, graphH = 50, binW = 8;
+    const float binMs = (float)LATENCY_OVERLAY_MAX_MS / LATENCY_OVERLAY_BINS;
+    DrawRectangle(x - 6, y - 6, LATENCY_OVERLAY_BINS * binW + 12, graphH + 62, (Color){0, 0, 0, 200});
+
+    int bins[LATENCY_OVERLAY_BINS] = { 0 };
+    int tallest = 1;
+    for (int i = 0; i < r->recentCount; i++) {
+        const LatencySample *s = &r->recent[i];
+        int b = (int)((s->presented - s->sampled) * 1000.0 / binMs);
+        if (b >= LATENCY_OVERLAY_BINS) b = LATENCY_OVERLAY_BINS - 1;
+        if (++bins[b] > tallest) tallest = bins[b];
+    }
+    for (int b = 0; b < LATENCY_OVERLAY_BINS; b++) {
+        int h = bins[b] * graphH / tallest;
+        DrawRectangle(x + b * binW, y + graphH - h, binW - 1, h, b * binMs < 1000.0f / TARGET_FPS * 2 ? SKYBLUE : ORANGE);
+    }
+
+    char text[96];
+    const FrameStats *total = &r->segments[LATENCY_TOTAL];
+    if (total->count > 0) {
+        sprintf(text, "input to photon: p50 %.0f ms, p95 %.0f ms (%ld shots)", FrameStatsPercentile(total, 0.5) * 1000.0,
+                FrameStatsPercentile(total, 0.95) * 1000.0, total->count);
+        DrawText(text, x, y + graphH + 8, 10, WHITE);
+        const LatencySample *s = &r->recent[(r->recentNext + LATENCY_HISTORY - 1) % LATENCY_HISTORY];
+        sprintf(text, "last: queue %.1f + simulate %.1f + present %.1f ms%s", (s->handled - s->sampled) * 1000.0,
+                (s->moved - s->handled) * 1000.0, (s->presented - s->moved) * 1000.0, s->ahead ? ", run ahead" : "");
+        DrawText(text, x, y + graphH + 22, 10, LIGHTGRAY);
+    } else {
+        DrawText("input to photon: take a shot", x, y + graphH + 8, 10, LIGHTGRAY);
+    }
+    sprintf(text, "0 .. %d ms", LATENCY_OVERLAY_MAX_MS);
+    DrawText(text, x, y + graphH + 36, 10, GRAY);
+    LatencyUnlockReport();
+}
+
 void DrawGame(Game *game) {
     BeginDrawing();
     ClearBackground((Color){8, 80, 23, 255});
 
     DrawTable();
-
-    // Pockets
-    Vector2 pockets[6];
-    GetPocketPositions(pockets);
-    for (int i = 0; i < 6; i++) DrawCircleV(pockets[i], POCKET_RADIUS, BLACK);
+    DrawPockets();
 
     DrawBalls(game);
     DrawCueStick(game);
     DrawPowerBar(game);
     DrawHUD(game);
     DrawOverlays(game);
+    if (profilerVisible) DrawProfiler();
+    if (latencyVisible) DrawLatency();
 
+    GovernorMark(PHASE_DRAW);
     EndDrawing();
+    LatencyPresented(game);
 }
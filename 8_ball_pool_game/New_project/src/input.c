@@ -0,0 +1,37 @@
+#include "input.h"
+#include "utils.h"
+
+void PollInput(InputFrame *input) {
+    input->mouse            = GetMousePosition();
+    input->mousePressed     = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    input->mouseDown        = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    input->mouseReleased    = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
+    input->keyReset         = IsKeyPressed(KEY_R);
+    input->keyPlaybackSpeed = IsKeyPressed(KEY_TAB);
+    input->keySkipToRest    = IsKeyPressed(KEY_F);
+    input->keyUndo          = IsKeyPressed(KEY_U);
+    input->keyResume        = IsKeyPressed(KEY_SPACE);
+    input->keyPlacementHelp = IsKeyPressed(KEY_H);
+
+    int step = (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) ? 10 : 1;
+    input->scrubFrames = 0;
+    if (IsKeyPressed(KEY_LEFT))  input->scrubFrames -= step;
+    if (IsKeyPressed(KEY_RIGHT)) input->scrubFrames += step;
+    input->time             = NowSeconds();
+}
+
+static bool RaylibPoll(InputProvider *self, InputFrame *input) {
+    (void)self;
+    PollInput(input);
+    return true;
+}
+
+static void RaylibClose(InputProvider *self) {
+    (void)self;
+}
+
+void RaylibInputOpen(InputProvider *provider) {
+    provider->poll = RaylibPoll;
+    provider->close = RaylibClose;
+    provider->state = NULL;
+}
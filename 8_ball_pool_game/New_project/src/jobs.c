@@ -0,0 +1,148 @@
+#include "jobs.h"
+#include "config.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static struct {
+    pthread_t threads[JOBS_MAX_THREADS];
+    int workerCount;
+
+    pthread_mutex_t submit;     // one parallel loop at a time
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    JobFn fn;
+    void *ctx;
+    int count;
+    atomic_int next;
+    int generation;
+    int busy;
+    bool quit;
+    bool initialized;
+} jobs;
+
+// Set on pool threads so that nested loops run inline instead of deadlocking
+static _Thread_local bool insideJob;
+
+static void RunIndices(void) {
+    for (;;) {
+        int i = atomic_fetch_add(&jobs.next, 1);
+        if (i >= jobs.count) break;
+        jobs.fn(i, jobs.ctx);
+    }
+}
+
+static void *WorkerThread(void *arg) {
+    (void)arg;
+    insideJob = true;
+    int seen = 0;
+
+    pthread_mutex_lock(&jobs.lock);
+    for (;;) {
+        while (jobs.generation == seen && !jobs.quit) {
+            pthread_cond_wait(&jobs.start, &jobs.lock);
+        }
+        if (jobs.quit) break;
+        seen = jobs.generation;
+        pthread_mutex_unlock(&jobs.lock);
+
+        RunIndices();
+
+        pthread_mutex_lock(&jobs.lock);
+        if (--jobs.busy == 0) pthread_cond_signal(&jobs.done);
+    }
+    pthread_mutex_unlock(&jobs.lock);
+    return NULL;
+}
+
+int JobsCoreCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int n = (int)info.dwNumberOfProcessors;
+#else
+    int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n > 0 ? n : 1;
+}
+
+void JobsInit(int threads) {
+    if (jobs.initialized) return;
+    if (threads <= 0) threads = JobsCoreCount();
+    if (threads > JOBS_MAX_THREADS) threads = JOBS_MAX_THREADS;
+
+    pthread_mutex_init(&jobs.submit, NULL);
+    pthread_mutex_init(&jobs.lock, NULL);
+    pthread_cond_init(&jobs.start, NULL);
+    pthread_cond_init(&jobs.done, NULL);
+    jobs.generation = 0;
+    jobs.busy = 0;
+    jobs.quit = false;
+    jobs.workerCount = 0;
+    jobs.initialized = true;
+
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&jobs.threads[i], NULL, WorkerThread, NULL) != 0) break;
+        jobs.workerCount++;
+    }
+}
+
+void JobsShutdown(void) {
+    if (!jobs.initialized) return;
+
+    pthread_mutex_lock(&jobs.lock);
+    jobs.quit = true;
+    pthread_cond_broadcast(&jobs.start);
+    pthread_mutex_unlock(&jobs.lock);
+
+    for (int i = 0; i < jobs.workerCount; i++) pthread_join(jobs.threads[i], NULL);
+    jobs.workerCount = 0;
+
+    pthread_mutex_destroy(&jobs.submit);
+    pthread_mutex_destroy(&jobs.lock);
+    pthread_cond_destroy(&jobs.start);
+    pthread_cond_destroy(&jobs.done);
+    jobs.initialized = false;
+}
+
+int JobsThreadCount(void) {
+    return jobs.workerCount + 1;
+}
+
+void JobsParallelFor(int count, JobFn fn, void *ctx) {
+    if (count <= 0) return;
+
+    if (!jobs.initialized || jobs.workerCount == 0 || insideJob || count == 1) {
+        for (int i = 0; i < count; i++) fn(i, ctx);
+        return;
+    }
+
+    pthread_mutex_lock(&jobs.submit);
+
+    pthread_mutex_lock(&jobs.lock);
+    jobs.fn = fn;
+    jobs.ctx = ctx;
+    jobs.count = count;
+    atomic_store(&jobs.next, 0);
+    jobs.busy = jobs.workerCount;
+    jobs.generation++;
+    pthread_cond_broadcast(&jobs.start);
+    pthread_mutex_unlock(&jobs.lock);
+
+    insideJob = true;
+    RunIndices();
+    insideJob = false;
+
+    pthread_mutex_lock(&jobs.lock);
+    while (jobs.busy > 0) pthread_cond_wait(&jobs.done, &jobs.lock);
+    pthread_mutex_unlock(&jobs.lock);
+
+    pthread_mutex_unlock(&jobs.submit);
+}
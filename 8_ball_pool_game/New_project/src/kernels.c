@@ -0,0 +1,263 @@
+#include "kernels.h"
+#include "utils.h"
+#include "policy.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+static struct {
+    pthread_once_t once;
+    _Atomic(const PhysicsKernels *) active;
+    bool benchmark;                 // asked for by the first KernelsInit
+    const char *how;
+    KernelTiming timings[KERNELS_MAX];
+    int timed;
+} kernels = { .once = PTHREAD_ONCE_INIT };
+
+#define BENCH_PAIRS (MAX_BALLS * (MAX_BALLS - 1) / 2)
+
+// --- Scalar backend ---
+
+static int GatherPairsScalar(const Ball *balls, int count, Contact *out, int capacity) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (balls[i].pocketed) continue;
+        for (int j = i + 1; j < count; j++) {
+            if (balls[j].pocketed) continue;
+            if (!BallsOverlap(&balls[i], &balls[j])) continue;
+            if (n < capacity) out[n] = (Contact){ i, j, 0, 0.0f };
+            n++;
+        }
+    }
+    return n;
+}
+
+static void PocketScanScalar(const TableGeometry *table, const Ball *balls, int count, int *pockets) {
+    for (int i = 0; i < count; i++) pockets[i] = balls[i].pocketed ? -1 : PocketAt(table, balls[i].position);
+}
+
+static void DampScalar(Ball *balls, int count, float friction) {
+    for (int i = 0; i < count; i++) {
+        Ball *ball = &balls[i];
+        if (ball->pocketed) continue;
+        ball->velocity.x *= friction;
+        ball->velocity.y *= friction;
+        if (fabs(ball->velocity.x) < MIN_VELOCITY) ball->velocity.x = 0;
+        if (fabs(ball->velocity.y) < MIN_VELOCITY) ball->velocity.y = 0;
+    }
+}
+
+static int DotS8Scalar(const signed char *a, const signed char *b, unsigned int n) {
+    int acc = 0;
+    for (unsigned int i = 0; i < n; i++) acc += a[i] * b[i];
+    return acc;
+}
+
+static const PhysicsKernels kernelsScalar = {
+    "scalar", GatherPairsScalar, PocketScanScalar, DampScalar, DotS8Scalar
+};
+
+// --- Choosing ---
+
+int KernelsSupported(const PhysicsKernels **list, int max) {
+    int n = 0;
+    if (n < max) list[n++] = &kernelsScalar;
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    // The AVX2 check includes the operating system saving the ymm registers
+    if (n < max && __builtin_cpu_supports("sse4.2")) list[n++] = &kernelsSse42;
+    if (n < max && __builtin_cpu_supports("avx2")) list[n++] = &kernelsAvx2;
+#endif
+    return n;
+}
+
+const PhysicsKernels *KernelsFind(const char *name) {
+    const PhysicsKernels *list[KERNELS_MAX];
+    int n = KernelsSupported(list, KERNELS_MAX);
+    for (int k = 0; k < n; k++) {
+        if (strcmp(list[k]->name, name) == 0) return list[k];
+    }
+    return NULL;
+}
+
+static void Choose(void) {
+    const char *forced = getenv(KERNELS_ENV);
+    if (forced && forced[0]) {
+        const PhysicsKernels *k = KernelsFind(forced);
+        if (k) {
+            kernels.how = "forced by " KERNELS_ENV;
+            atomic_store(&kernels.active, k);
+            return;
+        }
+        fprintf(stderr, "kernels: %s=%s is not a backend this CPU runs; choosing one instead\n", KERNELS_ENV, forced);
+    }
+
+    if (kernels.benchmark) {
+        kernels.timed = KernelsBenchmark(kernels.timings, KERNELS_MAX);
+        const KernelTiming *best = NULL;
+        for (int k = 0; k < kernels.timed; k++) {
+            const KernelTiming *t = &kernels.timings[k];
+            if (t->matches && (!best || t->micros < best->micros)) best = t;
+        }
+        kernels.how = "self-benchmark";
+        atomic_store(&kernels.active, best ? best->kernels : &kernelsScalar);
+        return;
+    }
+
+    const PhysicsKernels *list[KERNELS_MAX];
+    int n = KernelsSupported(list, KERNELS_MAX);
+    kernels.how = "widest supported";
+    atomic_store(&kernels.active, list[n - 1]);
+}
+
+const PhysicsKernels *KernelsInit(bool benchmark) {
+    kernels.benchmark = benchmark;
+    pthread_once(&kernels.once, Choose);
+    return atomic_load(&kernels.active);
+}
+
+const PhysicsKernels *GetKernels(void) {
+    const PhysicsKernels *k = atomic_load_explicit(&kernels.active, memory_order_acquire);
+    return k ? k : KernelsInit(false);
+}
+
+void KernelsUse(const PhysicsKernels *k) {
+    pthread_once(&kernels.once, Choose);
+    atomic_store(&kernels.active, k);
+}
+
+void KernelsDescribe(char *text, int size) {
+    const PhysicsKernels *active = GetKernels();
+    const PhysicsKernels *list[KERNELS_MAX];
+    int n = KernelsSupported(list, KERNELS_MAX);
+
+    int used = snprintf(text, size, "kernels: %s (cpu:", active->name);
+    for (int k = 0; k < n && used < size; k++) used += snprintf(text + used, size - used, " %s", list[k]->name);
+    if (used < size) used += snprintf(text + used, size - used, "; %s", kernels.how);
+    for (int k = 0; k < kernels.timed && used < size; k++) {
+        const KernelTiming *t = &kernels.timings[k];
+        used += snprintf(text + used, size - used, "%s%s %.3f us%s", k == 0 ? ": " : ", ",
+                         t->kernels->name, t->micros, t->matches ? "" : " MISMATCH");
+    }
+    if (used < size) snprintf(text + used, size - used, ")");
+}
+
+// --- Self-benchmark ---
+
+typedef struct {
+    Ball balls[KERNELS_BENCH_TABLES][MAX_BALLS];
+    signed char a[POLICY_MAX_WIDTH], b[POLICY_MAX_WIDTH];
+} BenchData;
+
+static float RandUnit(unsigned int *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / (float)(1u << 24);
+}
+
+// Racks scattered across the cloth: touching and overlapping neighbours,
+// balls near and inside the pockets, a few already pocketed, and speeds
+// from still to fast with some just under the stop threshold
+static void MakeBenchData(BenchData *data, const TableGeometry *table) {
+    unsigned int seed = 2024;
+    memset(data, 0, sizeof(*data));
+    for (int t = 0; t < KERNELS_BENCH_TABLES; t++) {
+        float cx = table->fieldMinX + RandUnit(&seed) * (table->fieldMaxX - table->fieldMinX);
+        float cy = table->fieldMinY + RandUnit(&seed) * (table->fieldMaxY - table->fieldMinY);
+        for (int i = 0; i < MAX_BALLS; i++) {
+            Ball *b = &data->balls[t][i];
+            int row = i / 4, col = i % 4;
+            b->position.x = cx + (col - 1.5f) * BALL_RADIUS * (1.7f + 0.6f * RandUnit(&seed));
+            b->position.y = cy + (row - 1.5f) * BALL_RADIUS * (1.7f + 0.6f * RandUnit(&seed));
+            if (i % 7 == 3) b->position = table->pockets[(t + i) % 6];
+            float scale = RandUnit(&seed) < 0.25f ? MIN_VELOCITY : 8.0f;
+            b->velocity.x = (RandUnit(&seed) * 2.0f - 1.0f) * scale;
+            b->velocity.y = (RandUnit(&seed) * 2.0f - 1.0f) * scale;
+            b->number = i;
+            b->pocketed = RandUnit(&seed) < 0.15f;
+        }
+    }
+    for (int k = 0; k < POLICY_MAX_WIDTH; k++) {
+        data->a[k] = (signed char)(RandUnit(&seed) * 254.0f - 127.0f);
+        data->b[k] = (signed char)(RandUnit(&seed) * 254.0f - 127.0f);
+    }
+}
+
+// What a step asks of the kernels, over every bench table, and one policy
+// row; the outputs go to balls, pockets and contacts for comparing
+static int RunBench(const PhysicsKernels *k, const TableGeometry *table, const BenchData *data,
+                    Ball *balls, int *pockets, Contact *contacts, int *pairs) {
+    for (int t = 0; t < KERNELS_BENCH_TABLES; t++) {
+        Ball *out = balls + t * MAX_BALLS;
+        memcpy(out, data->balls[t], sizeof(data->balls[t]));
+        k->damp(out, MAX_BALLS, FRICTION);
+        k->pocketScan(table, out, MAX_BALLS, pockets + t * MAX_BALLS);
+        pairs[t] = k->gatherPairs(out, MAX_BALLS, contacts + t * BENCH_PAIRS, BENCH_PAIRS);
+    }
+    return k->dotS8(data->a, data->b, POLICY_MAX_WIDTH);
+}
+
+typedef struct {
+    Ball balls[KERNELS_BENCH_TABLES * MAX_BALLS];
+    int pockets[KERNELS_BENCH_TABLES * MAX_BALLS];
+    Contact contacts[KERNELS_BENCH_TABLES * BENCH_PAIRS];
+    int pairs[KERNELS_BENCH_TABLES];
+    int dot;
+} BenchOutput;
+
+static bool SameOutput(const BenchOutput *a, const BenchOutput *b) {
+    if (a->dot != b->dot || memcmp(a->pairs, b->pairs, sizeof(a->pairs)) != 0) return false;
+    if (memcmp(a->pockets, b->pockets, sizeof(a->pockets)) != 0) return false;
+    for (int i = 0; i < KERNELS_BENCH_TABLES * MAX_BALLS; i++) {
+        if (memcmp(&a->balls[i].velocity, &b->balls[i].velocity, sizeof(Vector2)) != 0) return false;
+    }
+    for (int t = 0; t < KERNELS_BENCH_TABLES; t++) {
+        int n = a->pairs[t] < BENCH_PAIRS ? a->pairs[t] : BENCH_PAIRS;
+        for (int c = 0; c < n; c++) {
+            const Contact *x = &a->contacts[t * BENCH_PAIRS + c];
+            const Contact *y = &b->contacts[t * BENCH_PAIRS + c];
+            if (x->a != y->a || x->b != y->b) return false;
+        }
+    }
+    return true;
+}
+
+int KernelsBenchmark(KernelTiming *timings, int max) {
+    const PhysicsKernels *list[KERNELS_MAX];
+    int n = KernelsSupported(list, max < KERNELS_MAX ? max : KERNELS_MAX);
+    const TableGeometry *table = GetTableGeometry();
+
+    BenchData *data = malloc(sizeof(BenchData));
+    BenchOutput *reference = malloc(sizeof(BenchOutput));
+    BenchOutput *output = malloc(sizeof(BenchOutput));
+    if (!data || !reference || !output) {
+        free(data);
+        free(reference);
+        free(output);
+        return 0;
+    }
+    MakeBenchData(data, table);
+    reference->dot = RunBench(&kernelsScalar, table, data, reference->balls, reference->pockets,
+                              reference->contacts, reference->pairs);
+
+    for (int k = 0; k < n; k++) {
+        output->dot = RunBench(list[k], table, data, output->balls, output->pockets, output->contacts, output->pairs);
+        timings[k].kernels = list[k];
+        timings[k].matches = SameOutput(reference, output);
+
+        // Best of a few rounds, so one preemption does not decide it
+        double best = 1e30;
+        for (int round = 0; round < KERNELS_BENCH_ROUNDS; round++) {
+            double start = NowSeconds();
+            for (int rep = 0; rep < KERNELS_BENCH_REPEATS; rep++) {
+                RunBench(list[k], table, data, output->balls, output->pockets, output->contacts, output->pairs);
+            }
+            double elapsed = NowSeconds() - start;
+            if (elapsed < best) best = elapsed;
+        }
+        timings[k].micros = best * 1e6 / ((double)KERNELS_BENCH_REPEATS * KERNELS_BENCH_TABLES);
+    }
+
+    free(data);
+    free(reference);
+    free(output);
+    return n;
+}
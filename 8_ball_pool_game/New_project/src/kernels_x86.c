@@ -0,0 +1,277 @@
+#include "kernels.h"
+
+#ifdef KERNELS_X86
+#include <immintrin.h>
+
+// Each function is compiled for its own instruction set, so the build needs
+// no -m flags and the rest of the program still runs on any x86-64. The
+// float operations are the scalar ones in the scalar order, with no FMA.
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#define TARGET_AVX2  __attribute__((target("avx2")))
+
+#define CONTACT_LIMIT ((BALL_RADIUS * 2.0f) * (BALL_RADIUS * 2.0f))
+#define CONTACT_FLOOR (0.0001f * 0.0001f)
+#define ROW_PADDING 8               // widest vector, so the last load of a row stays inside
+
+// Ball positions as separate x and y rows. Pocketed balls and the padding are
+// NaN: every comparison with NaN is false, which skips them as scalar does.
+static void LoadRows(const Ball *balls, int count, float *x, float *y) {
+    for (int i = 0; i < count; i++) {
+        x[i] = balls[i].pocketed ? NAN : balls[i].position.x;
+        y[i] = balls[i].pocketed ? NAN : balls[i].position.y;
+    }
+    for (int i = count; i < count + ROW_PADDING; i++) x[i] = y[i] = NAN;
+}
+
+static int AddPairs(unsigned int hits, int i, int j, Contact *out, int capacity, int n) {
+    while (hits) {
+        int k = __builtin_ctz(hits);
+        hits &= hits - 1;
+        if (n < capacity) out[n] = (Contact){ i, j + k, 0, 0.0f };
+        n++;
+    }
+    return n;
+}
+
+// --- SSE4.2 ---
+
+TARGET_SSE42 static int GatherPairsSse42(const Ball *balls, int count, Contact *out, int capacity) {
+    float x[SOLVER_SWEEP_MIN + ROW_PADDING], y[SOLVER_SWEEP_MIN + ROW_PADDING];
+    LoadRows(balls, count, x, y);
+    const __m128 limit = _mm_set1_ps(CONTACT_LIMIT), least = _mm_set1_ps(CONTACT_FLOOR);
+
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (balls[i].pocketed) continue;
+        __m128 xi = _mm_set1_ps(x[i]), yi = _mm_set1_ps(y[i]);
+        for (int j = i + 1; j < count; j += 4) {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + j), xi);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + j), yi);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 hit = _mm_and_ps(_mm_cmplt_ps(d2, limit), _mm_cmpgt_ps(d2, least));
+            n = AddPairs((unsigned int)_mm_movemask_ps(hit), i, j, out, capacity, n);
+        }
+    }
+    return n;
+}
+
+// PocketAt four balls at a time: every lane runs the whole nearest-pocket
+// scan, and the band and drop tests pick -1 or the pocket at the end
+TARGET_SSE42 static void PocketScanSse42(const TableGeometry *t, const Ball *balls, int count, int *pockets) {
+    const __m128 minX = _mm_set1_ps(t->fieldMinX), maxX = _mm_set1_ps(t->fieldMaxX);
+    const __m128 minY = _mm_set1_ps(t->fieldMinY), maxY = _mm_set1_ps(t->fieldMaxY);
+    const __m128 bandLo = _mm_set1_ps(t->fieldMinY + POCKET_DROP_RADIUS);
+    const __m128 bandHi = _mm_set1_ps(t->fieldMaxY - POCKET_DROP_RADIUS);
+    const __m128 drop = _mm_set1_ps(POCKET_DROP_RADIUS * POCKET_DROP_RADIUS);
+    const __m128 ones = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const Ball *b = balls + i;
+        __m128 px = _mm_setr_ps(b[0].position.x, b[1].position.x, b[2].position.x, b[3].position.x);
+        __m128 py = _mm_setr_ps(b[0].position.y, b[1].position.y, b[2].position.y, b[3].position.y);
+        __m128 down = _mm_castsi128_ps(_mm_setr_epi32(-b[0].pocketed, -b[1].pocketed, -b[2].pocketed, -b[3].pocketed));
+
+        __m128 inField = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, minX), _mm_cmple_ps(px, maxX)),
+                                    _mm_and_ps(_mm_cmpge_ps(py, minY), _mm_cmple_ps(py, maxY)));
+        __m128 band = _mm_and_ps(inField, _mm_and_ps(_mm_cmpgt_ps(py, bandLo), _mm_cmplt_ps(py, bandHi)));
+        // Most of the time every ball is in the drop-free band
+        if (_mm_movemask_ps(band) == 0xF) {
+            _mm_storeu_si128((__m128i *)(pockets + i), _mm_set1_epi32(-1));
+            continue;
+        }
+
+        __m128 nearest = _mm_setzero_ps();
+        __m128 nearestDistSq = _mm_set1_ps(1e30f);
+        for (int p = 0; p < 6; p++) {
+            __m128 dx = _mm_sub_ps(px, _mm_set1_ps(t->pockets[p].x));
+            __m128 dy = _mm_sub_ps(py, _mm_set1_ps(t->pockets[p].y));
+            __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 closer = _mm_cmplt_ps(d, nearestDistSq);
+            nearestDistSq = _mm_blendv_ps(nearestDistSq, d, closer);
+            nearest = _mm_blendv_ps(nearest, _mm_castsi128_ps(_mm_set1_epi32(p)), closer);
+        }
+
+        __m128 drops = _mm_or_ps(_mm_cmplt_ps(nearestDistSq, drop), _mm_andnot_ps(inField, ones));
+        __m128 keep = _mm_andnot_ps(down, _mm_andnot_ps(band, drops));
+        __m128 result = _mm_blendv_ps(ones, nearest, keep);
+        _mm_storeu_si128((__m128i *)(pockets + i), _mm_castps_si128(result));
+    }
+    for (; i < count; i++) pockets[i] = balls[i].pocketed ? -1 : PocketAt(t, balls[i].position);
+}
+
+// Two balls' velocities per vector
+TARGET_SSE42 static void DampSse42(Ball *balls, int count, float friction) {
+    const __m128 f = _mm_set1_ps(friction), stop = _mm_set1_ps(MIN_VELOCITY);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&balls[i].velocity);
+        v = _mm_loadh_pi(v, (const __m64 *)&balls[i + 1].velocity);
+        __m128 down = _mm_castsi128_ps(_mm_setr_epi32(-balls[i].pocketed, -balls[i].pocketed,
+                                                      -balls[i + 1].pocketed, -balls[i + 1].pocketed));
+        __m128 damped = _mm_mul_ps(v, f);
+        __m128 slow = _mm_cmplt_ps(_mm_andnot_ps(sign, damped), stop);
+        damped = _mm_andnot_ps(slow, damped);
+        v = _mm_blendv_ps(damped, v, down);
+        _mm_storel_pi((__m64 *)&balls[i].velocity, v);
+        _mm_storeh_pi((__m64 *)&balls[i + 1].velocity, v);
+    }
+    for (; i < count; i++) {
+        Ball *ball = &balls[i];
+        if (ball->pocketed) continue;
+        ball->velocity.x *= friction;
+        ball->velocity.y *= friction;
+        if (fabs(ball->velocity.x) < MIN_VELOCITY) ball->velocity.x = 0;
+        if (fabs(ball->velocity.y) < MIN_VELOCITY) ball->velocity.y = 0;
+    }
+}
+
+TARGET_SSE42 static int DotS8Sse42(const signed char *a, const signed char *b, unsigned int n) {
+    __m128i acc = _mm_setzero_si128();
+    for (unsigned int i = 0; i < n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepi8_epi16(x), _mm_cvtepi8_epi16(y)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(x, 8)),
+                                                _mm_cvtepi8_epi16(_mm_srli_si128(y, 8))));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+
+const PhysicsKernels kernelsSse42 = {
+    "sse4.2", GatherPairsSse42, PocketScanSse42, DampSse42, DotS8Sse42
+};
+
+// --- AVX2 ---
+
+TARGET_AVX2 static int GatherPairsAvx2(const Ball *balls, int count, Contact *out, int capacity) {
+    float x[SOLVER_SWEEP_MIN + ROW_PADDING], y[SOLVER_SWEEP_MIN + ROW_PADDING];
+    LoadRows(balls, count, x, y);
+    const __m256 limit = _mm256_set1_ps(CONTACT_LIMIT), least = _mm256_set1_ps(CONTACT_FLOOR);
+
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (balls[i].pocketed) continue;
+        __m256 xi = _mm256_set1_ps(x[i]), yi = _mm256_set1_ps(y[i]);
+        for (int j = i + 1; j < count; j += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + j), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + j), yi);
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 hit = _mm256_and_ps(_mm256_cmp_ps(d2, limit, _CMP_LT_OQ), _mm256_cmp_ps(d2, least, _CMP_GT_OQ));
+            n = AddPairs((unsigned int)_mm256_movemask_ps(hit), i, j, out, capacity, n);
+        }
+    }
+    return n;
+}
+
+TARGET_AVX2 static void PocketScanAvx2(const TableGeometry *t, const Ball *balls, int count, int *pockets) {
+    const __m256 minX = _mm256_set1_ps(t->fieldMinX), maxX = _mm256_set1_ps(t->fieldMaxX);
+    const __m256 minY = _mm256_set1_ps(t->fieldMinY), maxY = _mm256_set1_ps(t->fieldMaxY);
+    const __m256 bandLo = _mm256_set1_ps(t->fieldMinY + POCKET_DROP_RADIUS);
+    const __m256 bandHi = _mm256_set1_ps(t->fieldMaxY - POCKET_DROP_RADIUS);
+    const __m256 drop = _mm256_set1_ps(POCKET_DROP_RADIUS * POCKET_DROP_RADIUS);
+    const __m256 ones = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const Ball *b = balls + i;
+        __m256 px = _mm256_setr_ps(b[0].position.x, b[1].position.x, b[2].position.x, b[3].position.x,
+                                   b[4].position.x, b[5].position.x, b[6].position.x, b[7].position.x);
+        __m256 py = _mm256_setr_ps(b[0].position.y, b[1].position.y, b[2].position.y, b[3].position.y,
+                                   b[4].position.y, b[5].position.y, b[6].position.y, b[7].position.y);
+        __m256 down = _mm256_castsi256_ps(_mm256_setr_epi32(-b[0].pocketed, -b[1].pocketed, -b[2].pocketed,
+                                                            -b[3].pocketed, -b[4].pocketed, -b[5].pocketed,
+                                                            -b[6].pocketed, -b[7].pocketed));
+
+        __m256 inField = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(px, minX, _CMP_GE_OQ), _mm256_cmp_ps(px, maxX, _CMP_LE_OQ)),
+                                       _mm256_and_ps(_mm256_cmp_ps(py, minY, _CMP_GE_OQ), _mm256_cmp_ps(py, maxY, _CMP_LE_OQ)));
+        __m256 band = _mm256_and_ps(inField, _mm256_and_ps(_mm256_cmp_ps(py, bandLo, _CMP_GT_OQ),
+                                                           _mm256_cmp_ps(py, bandHi, _CMP_LT_OQ)));
+        if (_mm256_movemask_ps(band) == 0xFF) {
+            _mm256_storeu_si256((__m256i *)(pockets + i), _mm256_set1_epi32(-1));
+            continue;
+        }
+
+        __m256 nearest = _mm256_setzero_ps();
+        __m256 nearestDistSq = _mm256_set1_ps(1e30f);
+        for (int p = 0; p < 6; p++) {
+            __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(t->pockets[p].x));
+            __m256 dy = _mm256_sub_ps(py, _mm256_set1_ps(t->pockets[p].y));
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 closer = _mm256_cmp_ps(d, nearestDistSq, _CMP_LT_OQ);
+            nearestDistSq = _mm256_blendv_ps(nearestDistSq, d, closer);
+            nearest = _mm256_blendv_ps(nearest, _mm256_castsi256_ps(_mm256_set1_epi32(p)), closer);
+        }
+
+        __m256 drops = _mm256_or_ps(_mm256_cmp_ps(nearestDistSq, drop, _CMP_LT_OQ), _mm256_andnot_ps(inField, ones));
+        __m256 keep = _mm256_andnot_ps(down, _mm256_andnot_ps(band, drops));
+        __m256 result = _mm256_blendv_ps(ones, nearest, keep);
+        _mm256_storeu_si256((__m256i *)(pockets + i), _mm256_castps_si256(result));
+    }
+    for (; i < count; i++) pockets[i] = balls[i].pocketed ? -1 : PocketAt(t, balls[i].position);
+}
+
+// Four balls' velocities per vector
+TARGET_AVX2 static void DampAvx2(Ball *balls, int count, float friction) {
+    const __m256 f = _mm256_set1_ps(friction), stop = _mm256_set1_ps(MIN_VELOCITY);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Ball *b = balls + i;
+        __m128 lo = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&b[0].velocity),
+                                 (const __m64 *)&b[1].velocity);
+        __m128 hi = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&b[2].velocity),
+                                 (const __m64 *)&b[3].velocity);
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+        __m256 down = _mm256_castsi256_ps(_mm256_setr_epi32(-b[0].pocketed, -b[0].pocketed, -b[1].pocketed,
+                                                            -b[1].pocketed, -b[2].pocketed, -b[2].pocketed,
+                                                            -b[3].pocketed, -b[3].pocketed));
+        __m256 damped = _mm256_mul_ps(v, f);
+        __m256 slow = _mm256_cmp_ps(_mm256_andnot_ps(sign, damped), stop, _CMP_LT_OQ);
+        damped = _mm256_andnot_ps(slow, damped);
+        v = _mm256_blendv_ps(damped, v, down);
+        lo = _mm256_castps256_ps128(v);
+        hi = _mm256_extractf128_ps(v, 1);
+        _mm_storel_pi((__m64 *)&b[0].velocity, lo);
+        _mm_storeh_pi((__m64 *)&b[1].velocity, lo);
+        _mm_storel_pi((__m64 *)&b[2].velocity, hi);
+        _mm_storeh_pi((__m64 *)&b[3].velocity, hi);
+    }
+    for (; i < count; i++) {
+        Ball *ball = &balls[i];
+        if (ball->pocketed) continue;
+        ball->velocity.x *= friction;
+        ball->velocity.y *= friction;
+        if (fabs(ball->velocity.x) < MIN_VELOCITY) ball->velocity.x = 0;
+        if (fabs(ball->velocity.y) < MIN_VELOCITY) ball->velocity.y = 0;
+    }
+}
+
+TARGET_AVX2 static int DotS8Avx2(const signed char *a, const signed char *b, unsigned int n) {
+    __m256i acc = _mm256_setzero_si256();
+    for (unsigned int i = 0; i < n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i xl = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(x));
+        __m256i xh = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(x, 1));
+        __m256i yl = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(y));
+        __m256i yh = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(y, 1));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(xl, yl));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(xh, yh));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+const PhysicsKernels kernelsAvx2 = {
+    "avx2", GatherPairsAvx2, PocketScanAvx2, DampAvx2, DotS8Avx2
+};
+
+#endif // KERNELS_X86
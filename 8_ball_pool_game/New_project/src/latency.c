@@ -0,0 +1,122 @@
+#include "latency.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+enum { STAGE_IDLE, STAGE_HANDLED, STAGE_MOVED };
+
+static const char *segmentNames[LATENCY_SEGMENTS] = { "queue", "simulate", "present", "total" };
+
+static struct {
+    bool initialized;
+    pthread_mutex_t lock;
+    atomic_int stage;
+    LatencySample current;      // the shot in flight
+    Vector2 from;               // cue ball where it was struck
+    LatencyReport report;
+} latency;
+
+void LatencyInit(void) {
+    if (latency.initialized) return;
+    pthread_mutex_init(&latency.lock, NULL);
+    atomic_store(&latency.stage, STAGE_IDLE);
+    for (int s = 0; s < LATENCY_SEGMENTS; s++) FrameStatsReset(&latency.report.segments[s]);
+    latency.initialized = true;
+}
+
+// The sim side writes the shot in flight and the window side reads it, so
+// both do it under the lock: the stage only changes away from STAGE_MOVED
+// with it held, and LatencyStep touches the sample only while the stage is
+// STAGE_HANDLED, which the window side never reads
+void LatencyShotTaken(int shot, Vector2 cueFrom, double sampled, int ahead) {
+    if (!latency.initialized) return;
+    pthread_mutex_lock(&latency.lock);
+    if (atomic_load(&latency.stage) != STAGE_IDLE) latency.report.unpresented++;
+    latency.current = (LatencySample){ shot, ahead, sampled, NowSeconds(), 0.0, 0.0 };
+    latency.from = cueFrom;
+    atomic_store(&latency.stage, STAGE_HANDLED);
+    pthread_mutex_unlock(&latency.lock);
+}
+
+static bool CueMoved(const Game *game, const LatencySample *sample, Vector2 from) {
+    const Ball *cue = &game->balls[0];
+    return game->shotNumber == sample->shot &&
+           (cue->pocketed || cue->position.x != from.x || cue->position.y != from.y);
+}
+
+void LatencyStep(const Game *game) {
+    if (atomic_load_explicit(&latency.stage, memory_order_acquire) != STAGE_HANDLED || game->headless) return;
+    if (!CueMoved(game, &latency.current, latency.from)) return;
+    latency.current.moved = NowSeconds();
+    atomic_store_explicit(&latency.stage, STAGE_MOVED, memory_order_release);
+}
+
+void LatencyPresented(const Game *drawn) {
+    if (atomic_load_explicit(&latency.stage, memory_order_acquire) != STAGE_MOVED) return;
+    double now = NowSeconds();
+
+    pthread_mutex_lock(&latency.lock);
+    if (atomic_load(&latency.stage) != STAGE_MOVED || !CueMoved(drawn, &latency.current, latency.from)) {
+        pthread_mutex_unlock(&latency.lock);
+        return;
+    }
+    atomic_store(&latency.stage, STAGE_IDLE);
+    LatencySample s = latency.current;
+    s.presented = now;
+
+    LatencyReport *r = &latency.report;
+    FrameStatsAdd(&r->segments[LATENCY_QUEUE], s.handled - s.sampled);
+    FrameStatsAdd(&r->segments[LATENCY_SIMULATE], s.moved - s.handled);
+    FrameStatsAdd(&r->segments[LATENCY_PRESENT], s.presented - s.moved);
+    FrameStatsAdd(&r->segments[LATENCY_TOTAL], s.presented - s.sampled);
+    r->recent[r->recentNext] = s;
+    r->recentNext = (r->recentNext + 1) % LATENCY_HISTORY;
+    if (r->recentCount < LATENCY_HISTORY) r->recentCount++;
+    pthread_mutex_unlock(&latency.lock);
+}
+
+const LatencyReport *LatencyLockReport(void) {
+    if (!latency.initialized) return NULL;
+    pthread_mutex_lock(&latency.lock);
+    return &latency.report;
+}
+
+void LatencyUnlockReport(void) {
+    pthread_mutex_unlock(&latency.lock);
+}
+
+const char *LatencySegmentName(LatencySegment segment) {
+    return segmentNames[segment];
+}
+
+void LatencyPrintReport(FILE *out) {
+    const LatencyReport *r = LatencyLockReport();
+    if (!r) return;
+    if (r->segments[LATENCY_TOTAL].count > 0) {
+        fprintf(out, "latency: %ld shots, %ld never shown\n", r->segments[LATENCY_TOTAL].count, r->unpresented);
+        for (int seg = 0; seg < LATENCY_SEGMENTS; seg++) {
+            const FrameStats *s = &r->segments[seg];
+            fprintf(out, "  %-8s mean %.2f ms, p50 %.1f ms, p95 %.1f ms, max %.2f ms\n", segmentNames[seg],
+                    s->sum / s->count * 1000.0, FrameStatsPercentile(s, 0.5) * 1000.0,
+                    FrameStatsPercentile(s, 0.95) * 1000.0, s->max * 1000.0);
+        }
+    }
+    LatencyUnlockReport();
+}
+
+bool LatencyExport(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "shot,queue_ms,simulate_ms,present_ms,total_ms,ahead_frames\n");
+    const LatencyReport *r = LatencyLockReport();
+    if (r) {
+        int first = (r->recentNext - r->recentCount + LATENCY_HISTORY) % LATENCY_HISTORY;
+        for (int i = 0; i < r->recentCount; i++) {
+            const LatencySample *s = &r->recent[(first + i) % LATENCY_HISTORY];
+            fprintf(f, "%d,%.3f,%.3f,%.3f,%.3f,%d\n", s->shot, (s->handled - s->sampled) * 1000.0,
+                    (s->moved - s->handled) * 1000.0, (s->presented - s->moved) * 1000.0,
+                    (s->presented - s->sampled) * 1000.0, s->ahead);
+        }
+        LatencyUnlockReport();
+    }
+    return fclose(f) == 0;
+}
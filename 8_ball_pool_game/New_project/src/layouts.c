@@ -0,0 +1,294 @@
+#include "layouts.h"
+#include "sim.h"
+
+static const char layoutMagic[8] = { 'P', 'O', 'O', 'L', 'L', 'A', 'Y', 'S' };
+
+static LayoutIndex defaultIndex;
+static bool defaultLoaded;
+
+// --- Keys ---
+
+static unsigned short Quantize(float v) {
+    int q = 1 + (int)lroundf(v * LAYOUT_QUANT);
+    return (unsigned short)(q < 1 ? 1 : (q > 0xFFFF ? 0xFFFF : q));
+}
+
+void LayoutKey(const Game *game, unsigned short key[LAYOUT_DIMS], bool *flipX, bool *flipY) {
+    Vector2 cue = game->balls[0].position;
+    bool fx = cue.x > TABLE_WIDTH * 0.5f;
+    bool fy = cue.y > TABLE_HEIGHT * 0.5f;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        const Ball *b = &game->balls[i];
+        if (b->pocketed) {
+            key[2 * i] = key[2 * i + 1] = 0;
+            continue;
+        }
+        key[2 * i]     = Quantize(fx ? TABLE_WIDTH - b->position.x : b->position.x);
+        key[2 * i + 1] = Quantize(fy ? TABLE_HEIGHT - b->position.y : b->position.y);
+    }
+    if (flipX) *flipX = fx;
+    if (flipY) *flipY = fy;
+}
+
+// Each mirroring is its own inverse, so this maps both ways
+float LayoutMirrorAngle(float angle, bool flipX, bool flipY) {
+    if (flipX) angle = PI - angle;
+    if (flipY) angle = -angle;
+    angle = fmodf(angle, 2.0f * PI);
+    return angle < 0.0f ? angle + 2.0f * PI : angle;
+}
+
+// Squared distance, abandoned once it reaches limit: most candidates of a
+// query lose within the first few balls
+static unsigned long long Distance2(const unsigned short *a, const unsigned short *b, unsigned long long limit) {
+    unsigned long long sum = 0;
+    for (int d = 0; d < LAYOUT_DIMS; d += 8) {
+        for (int k = d; k < d + 8; k++) {
+            long long diff = (long long)a[k] - b[k];
+            sum += (unsigned long long)(diff * diff);
+        }
+        if (sum >= limit) return sum;
+    }
+    return sum;
+}
+
+// --- Building ---
+
+static void Swap(LayoutRecord *a, LayoutRecord *b) {
+    LayoutRecord t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Moves the record with the nth smallest key[dim] to position nth, smaller
+// or equal keys before it and larger or equal after
+static void Select(LayoutRecord *r, int lo, int hi, int nth, int dim) {
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        // Median of three as the pivot, parked at hi - 1
+        if (r[mid].key[dim] < r[lo].key[dim]) Swap(&r[mid], &r[lo]);
+        if (r[hi - 1].key[dim] < r[lo].key[dim]) Swap(&r[hi - 1], &r[lo]);
+        if (r[mid].key[dim] < r[hi - 1].key[dim]) Swap(&r[mid], &r[hi - 1]);
+        unsigned short pivot = r[hi - 1].key[dim];
+
+        int i = lo - 1, j = hi - 1;
+        for (;;) {
+            while (r[++i].key[dim] < pivot) {}
+            while (j > lo && r[--j].key[dim] > pivot) {}
+            if (i >= j) break;
+            Swap(&r[i], &r[j]);
+        }
+        Swap(&r[i], &r[hi - 1]);
+        if (i == nth) return;
+        if (nth < i) hi = i;
+        else lo = i + 1;
+    }
+}
+
+// Median of the widest dimension at the middle of the range, the two halves
+// built the same way on either side
+static void BuildTree(LayoutRecord *r, int lo, int hi) {
+    while (hi - lo > 0) {
+        int split = 0;
+        unsigned int widest = 0;
+        for (int d = 0; d < LAYOUT_DIMS; d++) {
+            unsigned short low = 0xFFFF, high = 0;
+            for (int i = lo; i < hi; i++) {
+                unsigned short v = r[i].key[d];
+                if (v < low) low = v;
+                if (v > high) high = v;
+            }
+            if (high >= low && (unsigned int)(high - low) > widest) {
+                widest = high - low;
+                split = d;
+            }
+        }
+        int mid = lo + (hi - lo) / 2;
+        Select(r, lo, hi, mid, split);
+        r[mid].split = (unsigned char)split;
+
+        // Recurse into the smaller half, loop on the larger
+        if (mid - lo < hi - mid - 1) {
+            BuildTree(r, lo, mid);
+            lo = mid + 1;
+        } else {
+            BuildTree(r, mid + 1, hi);
+            hi = mid;
+        }
+    }
+}
+
+bool LayoutIndexBuild(LayoutIndex *index, LayoutRecord *records, int count) {
+    memset(index, 0, sizeof(*index));
+    char *blob = malloc(sizeof(LayoutHeader) + sizeof(LayoutRecord) * (size_t)(count > 0 ? count : 1));
+    if (!blob) {
+        free(records);
+        return false;
+    }
+
+    LayoutHeader *h = (LayoutHeader *)blob;
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, layoutMagic, sizeof(layoutMagic));
+    h->version = LAYOUT_VERSION;
+    h->specHash = TableSpecHash();
+    h->recordSize = sizeof(LayoutRecord);
+    h->recordCount = (unsigned int)count;
+
+    // Group by PlayerType, then one tree per group
+    LayoutRecord *sorted = (LayoutRecord *)(blob + sizeof(LayoutHeader));
+    unsigned int next[LAYOUT_TYPES] = { 0 };
+    for (int i = 0; i < count; i++) h->typeStart[records[i].type + 1]++;
+    for (int t = 0; t < LAYOUT_TYPES; t++) {
+        h->typeStart[t + 1] += h->typeStart[t];
+        next[t] = h->typeStart[t];
+    }
+    for (int i = 0; i < count; i++) sorted[next[records[i].type]++] = records[i];
+    free(records);
+    for (int t = 0; t < LAYOUT_TYPES; t++) BuildTree(sorted, (int)h->typeStart[t], (int)h->typeStart[t + 1]);
+
+    index->owned = blob;
+    index->header = h;
+    index->records = sorted;
+    return true;
+}
+
+bool LayoutIndexWrite(const LayoutIndex *index, const char *path) {
+    char temp[520];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *f = fopen(temp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(index->header, sizeof(LayoutHeader), 1, f) == 1 &&
+              fwrite(index->records, sizeof(LayoutRecord), index->header->recordCount, f) == index->header->recordCount;
+    if (fclose(f) != 0) ok = false;
+    ok = ok && FileReplace(temp, path);
+    if (!ok) remove(temp);
+    return ok;
+}
+
+// --- Loading ---
+
+bool LayoutIndexOpen(LayoutIndex *index, const char *path) {
+    memset(index, 0, sizeof(*index));
+    if (!MapFileOpen(&index->file, path)) return false;
+
+    const LayoutHeader *h = index->file.data;
+    bool ok = index->file.size >= sizeof(LayoutHeader) &&
+              memcmp(h->magic, layoutMagic, sizeof(layoutMagic)) == 0 &&
+              h->version == LAYOUT_VERSION &&
+              h->recordSize == sizeof(LayoutRecord) &&
+              index->file.size >= sizeof(LayoutHeader) + (size_t)h->recordCount * sizeof(LayoutRecord) &&
+              h->typeStart[0] == 0 && h->typeStart[LAYOUT_TYPES] == h->recordCount;
+    for (int t = 0; ok && t < LAYOUT_TYPES; t++) ok = h->typeStart[t] <= h->typeStart[t + 1];
+    // The search indexes key[] by split and trusts each tree to hold one type
+    const LayoutRecord *records = (const LayoutRecord *)((const char *)index->file.data + sizeof(LayoutHeader));
+    for (int t = 0; ok && t < LAYOUT_TYPES; t++) {
+        for (unsigned int i = h->typeStart[t]; ok && i < h->typeStart[t + 1]; i++) {
+            ok = records[i].split < LAYOUT_DIMS && records[i].type == t;
+        }
+    }
+    if (ok && h->specHash != TableSpecHash()) {
+        fprintf(stderr, "layouts: %s was solved for a different table or physics\n", path);
+        ok = false;
+    }
+    if (!ok) {
+        MapFileClose(&index->file);
+        return false;
+    }
+
+    index->header = h;
+    index->records = records;
+    return true;
+}
+
+void LayoutIndexClose(LayoutIndex *index) {
+    if (index->owned) free(index->owned);
+    else MapFileClose(&index->file);
+    memset(index, 0, sizeof(*index));
+}
+
+size_t LayoutIndexBytes(const LayoutIndex *index) {
+    if (!index->header) return 0;
+    return sizeof(LayoutHeader) + (size_t)index->header->recordCount * sizeof(LayoutRecord);
+}
+
+// --- Queries ---
+
+typedef struct {
+    const LayoutRecord *records;
+    const unsigned short *key;
+    LayoutMatch *matches;
+    unsigned long long *distances;  // squared, quantized units, parallel to matches
+    int count, found;
+    long visited, maxVisits;        // 0: exact
+} Query;
+
+static void Offer(Query *q, const LayoutRecord *r, unsigned long long d2) {
+    if (q->found == q->count && d2 >= q->distances[q->found - 1]) return;
+    int k = q->found < q->count ? q->found++ : q->found - 1;
+    while (k > 0 && q->distances[k - 1] > d2) {
+        q->distances[k] = q->distances[k - 1];
+        q->matches[k] = q->matches[k - 1];
+        k--;
+    }
+    q->distances[k] = d2;
+    q->matches[k].record = r;
+}
+
+static void Search(Query *q, int lo, int hi) {
+    while (hi - lo > 0) {
+        int mid = lo + (hi - lo) / 2;
+        const LayoutRecord *node = &q->records[mid];
+        unsigned long long worst = q->found == q->count ? q->distances[q->found - 1] : ~0ull;
+        Offer(q, node, Distance2(node->key, q->key, worst));
+        q->visited++;
+
+        long long diff = (long long)q->key[node->split] - node->key[node->split];
+        int nearLo = diff < 0 ? lo : mid + 1, nearHi = diff < 0 ? mid : hi;
+        int farLo = diff < 0 ? mid + 1 : lo, farHi = diff < 0 ? hi : mid;
+        Search(q, nearLo, nearHi);
+        // Everything across the split plane is at least |diff| away; past
+        // the budget the far sides are left unsearched
+        if (q->found == q->count && (unsigned long long)(diff * diff) >= q->distances[q->found - 1]) return;
+        if (q->maxVisits > 0 && q->visited >= q->maxVisits) return;
+        lo = farLo;
+        hi = farHi;
+    }
+}
+
+int LayoutIndexNearestKey(const LayoutIndex *index, const unsigned short key[LAYOUT_DIMS], int type,
+                          LayoutMatch *matches, int count, int maxVisits, LayoutQueryStats *stats) {
+    if (!index || !index->header || count <= 0 || type < 0 || type >= LAYOUT_TYPES) return 0;
+    unsigned long long distances[64];
+    if (count > 64) count = 64;
+
+    Query q = { index->records, key, matches, distances, count, 0, 0, maxVisits };
+    Search(&q, (int)index->header->typeStart[type], (int)index->header->typeStart[type + 1]);
+    for (int k = 0; k < q.found; k++) {
+        matches[k].distance = sqrtf((float)distances[k]) / LAYOUT_QUANT;
+        matches[k].angle = matches[k].record->angle;
+        matches[k].speed = matches[k].record->speed;
+    }
+    if (stats) stats->visited += q.visited;
+    return q.found;
+}
+
+int LayoutIndexNearest(const LayoutIndex *index, const Game *game, LayoutMatch *matches, int count,
+                       LayoutQueryStats *stats) {
+    unsigned short key[LAYOUT_DIMS];
+    bool flipX, flipY;
+    LayoutKey(game, key, &flipX, &flipY);
+    int found = LayoutIndexNearestKey(index, key, (int)game->players[game->currentPlayer].type,
+                                      matches, count, LAYOUT_MAX_VISITS, stats);
+    for (int k = 0; k < found; k++) matches[k].angle = LayoutMirrorAngle(matches[k].angle, flipX, flipY);
+    return found;
+}
+
+bool LayoutIndexLoadDefault(const char *path) {
+    if (defaultLoaded) return true;
+    defaultLoaded = LayoutIndexOpen(&defaultIndex, path);
+    return defaultLoaded;
+}
+
+const LayoutIndex *GetLayoutIndex(void) {
+    return defaultLoaded ? &defaultIndex : NULL;
+}
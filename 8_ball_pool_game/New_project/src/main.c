@@ -1,19 +1,170 @@
 #include "common.h"
 #include "game.h"
 #include "graphics.h"
+#include "governor.h"
+#include "telemetry.h"
+#include "stream.h"
+#include "input.h"
+#include "pipeline.h"
+#include "utils.h"
+#include "atlas.h"
+#include "autosave.h"
+#include "potlut.h"
+#include "jobs.h"
+#include "latency.h"
+#include "cache.h"
+#include "odds.h"
+#include "placement.h"
+#include "rewind.h"
+#include "runahead.h"
+#include "script.h"
+#include "kernels.h"
 
-int main(void) {
+// A match cut short by a crash (or a quit): offer to pick it up again
+static bool OfferResume(Game *saved) {
+    while (!WindowShouldClose()) {
+        if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_Y)) return true;
+        if (IsKeyPressed(KEY_N)) return false;
+        DrawResumePrompt(saved);
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
     InitWindow(TABLE_WIDTH, TABLE_HEIGHT + 100, WINDOW_TITLE);
     SetTargetFPS(TARGET_FPS);
 
+    TelemetryInit(TELEMETRY_PATH);
+    BreakAtlasLoadDefault(BREAK_ATLAS_PATH);
+
+    // --kernel-bench: choose the physics kernels by timing them instead of by
+    // CPU features. Decided before anything below runs the physics.
+    bool kernelBench = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--kernel-bench") == 0) kernelBench = true;
+    }
+    KernelsInit(kernelBench);
+    char kernelText[256];
+    KernelsDescribe(kernelText, sizeof(kernelText));
+    printf("%s\n", kernelText);
+
+    // Shot odds and placement help run on the job pool; leave a core each for the window and simulation threads
+    int cores = JobsCoreCount();
+    JobsInit(cores > 2 ? cores - 2 : 1);
+    // Built on the job pool the first time, mapped from disk after that
+    PotLutLoadDefault(POT_LUT_PATH);
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+    ShotOddsStart();
+    PlacementHelpStart();
+
+    // --stream <file|-|"|command">: broadcast the table to spectators
+    // --serial: run update and draw on one thread (for comparing frame times)
+    // --rewind-mb <n>: memory budget for shot undo and scrubbing
+    // --script <file>: play an input script instead of the mouse and keyboard
+    // --record-input <file>: save the input as a script for pool_soak or --script
+    // --budget-ms <ms>: frame budget the governor holds to; 0 never sheds
+    // --profile: show frame phases and the governor's decisions
+    // --no-resume: start a new match without offering the autosaved one
+    // --latency: show the input-to-photon latency of recent shots
+    // --latency-csv <file>: save each shot's latency stages on exit
+    // --run-ahead: simulate the dragged shot ahead and show it further along on release
+    bool serial = false;
+    double budgetMs = 1000.0 / TARGET_FPS;
+    int rewindMb = REWIND_BUDGET_MB;
+    const char *scriptPath = NULL;
+    const char *recordPath = NULL;
+    bool offerResume = true;
+    const char *latencyPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) StreamOpen(argv[++i]);
+        else if (strcmp(argv[i], "--serial") == 0) serial = true;
+        else if (strcmp(argv[i], "--rewind-mb") == 0 && i + 1 < argc) rewindMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) scriptPath = argv[++i];
+        else if (strcmp(argv[i], "--record-input") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) budgetMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--profile") == 0) SetProfilerVisible(true);
+        else if (strcmp(argv[i], "--no-resume") == 0) offerResume = false;
+        else if (strcmp(argv[i], "--latency") == 0) SetLatencyVisible(true);
+        else if (strcmp(argv[i], "--run-ahead") == 0) RunAheadEnable(true);
+        else if (strcmp(argv[i], "--latency-csv") == 0 && i + 1 < argc) latencyPath = argv[++i];
+    }
+    GovernorInit(budgetMs / 1000.0);
+    LatencyInit();
+    if (rewindMb > 0) RewindInit((size_t)rewindMb * 1024 * 1024);
+
+    InputProvider provider;
+    if (!scriptPath || !ScriptInputOpen(&provider, scriptPath, false)) RaylibInputOpen(&provider);
+    ScriptRecorder recorder = { 0 };
+    if (recordPath) ScriptRecorderOpen(&recorder, recordPath);
+
     Game game;
     InitGame(&game);
 
+    // Scripted runs neither resume nor overwrite the player's save
+    if (!scriptPath) {
+        static Game saved;
+        if (offerResume && AutosaveLoad(AUTOSAVE_PATH, &saved) && OfferResume(&saved)) {
+            game = saved;
+            strcpy(game.statusMessage, "Match resumed from the last shot");
+        }
+        AutosaveStart(AUTOSAVE_PATH);
+    }
+
+    if (!serial && !PipelineStart(&game)) serial = true;
+
+    FrameStats frameStats;
+    FrameStatsReset(&frameStats);
+    double lastFrame = NowSeconds();
+
     while (!WindowShouldClose()) {
-        UpdateGame(&game);
-        DrawGame(&game);
+        GovernorBeginFrame();
+        InputFrame input;
+        if (!provider.poll(&provider, &input)) break;
+        ScriptRecorderAdd(&recorder, &input);
+
+        if (serial) {
+            UpdateGame(&game, &input);
+            StreamFrame(&game);
+            ShotOddsAim(&game);
+            PlacementHelpUpdate(&game);
+            GovernorMark(PHASE_UPDATE);
+            DrawGame(&game);
+        } else {
+            PipelineSubmitInput(&input);
+            Game *latest = PipelineLatest();
+            ShotOddsAim(latest);
+            PlacementHelpUpdate(latest);
+            GovernorMark(PHASE_UPDATE);
+            DrawGame(latest);
+        }
+        GovernorEndFrame();
+
+        double now = NowSeconds();
+        FrameStatsAdd(&frameStats, now - lastFrame);
+        lastFrame = now;
     }
 
+    if (!serial) PipelineStop(&game);
+    AutosaveStop();
+    ScriptRecorderClose(&recorder);
+    provider.close(&provider);
+    FrameStatsPrint(&frameStats, serial ? "frame time (serial)" : "frame time (pipelined)");
+    GovernorPrintReport(stdout);
+    AutosavePrintReport(stdout);
+    LatencyPrintReport(stdout);
+    RunAheadPrintReport(stdout);
+    if (latencyPath && !LatencyExport(latencyPath)) fprintf(stderr, "latency: cannot write %s\n", latencyPath);
+
+    RewindPrintReport(stdout);
+    RewindShutdown();
+    PlacementHelpStop();
+    ShotOddsStop();
+    ShotCachePrintReport(stdout);
+    ShotCacheShutdown();
+    JobsShutdown();
+
+    StreamClose();
+    TelemetryShutdown();
     CloseWindow();
     return 0;
 }
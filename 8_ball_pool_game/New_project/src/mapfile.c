@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+#include "mapfile.h"
+
+// Kept apart from common.h: windows.h and raylib.h declare clashing names
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+
+bool MapFileOpen(MappedFile *m, const char *path) {
+    m->data = NULL;
+    m->size = 0;
+    m->handle = NULL;
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m->data = view;
+    m->size = (size_t)size.QuadPart;
+    m->handle = mapping;
+    return true;
+}
+
+void MapFileClose(MappedFile *m) {
+    if (m->data) UnmapViewOfFile(m->data);
+    if (m->handle) CloseHandle(m->handle);
+    m->data = NULL;
+    m->handle = NULL;
+    m->size = 0;
+}
+
+bool FileCommit(FILE *f) {
+    return fflush(f) == 0 && _commit(_fileno(f)) == 0;
+}
+
+bool FileReplace(const char *from, const char *to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool MapFileOpen(MappedFile *m, const char *path) {
+    m->data = NULL;
+    m->size = 0;
+    m->handle = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    m->data = view;
+    m->size = (size_t)st.st_size;
+    return true;
+}
+
+void MapFileClose(MappedFile *m) {
+    if (m->data) munmap((void *)m->data, m->size);
+    m->data = NULL;
+    m->size = 0;
+}
+
+bool FileCommit(FILE *f) {
+    return fflush(f) == 0 && fsync(fileno(f)) == 0;
+}
+
+bool FileReplace(const char *from, const char *to) {
+    return rename(from, to) == 0;
+}
+#endif
@@ -0,0 +1,185 @@
+#include "odds.h"
+#include "ai.h"
+#include "cache.h"
+#include "game.h"
+#include "jobs.h"
+#include "governor.h"
+#include "sim.h"
+#include <pthread.h>
+
+// The window thread posts the aim it is drawing; the sampler thread picks up
+// the newest one, runs a batch and adds it to the totals only if the aim has
+// not changed meanwhile. Sampled shots are snapped to shot cache buckets, so
+// nearby samples and re-aims at an earlier line come back as lookups.
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool running;
+
+    // Latest aim from the window thread
+    Game game;
+    float angle;
+    float speed;
+    unsigned long long stateHash;
+    unsigned int generation;
+    bool active;
+
+    // Totals for the current generation
+    int samples;
+    int successes;
+} odds;
+
+typedef struct {
+    const Game *game;
+    unsigned long long stateHash;
+    float angles[ODDS_BATCH];
+    float speeds[ODDS_BATCH];
+    bool success[ODDS_BATCH];
+} OddsBatch;
+
+static inline float HashUniform(unsigned int x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Unit normal noise approximated by the sum of four uniforms (Irwin-Hall),
+// with a counter-based hash as the generator: no branches, no state carried
+// between lanes, so the loop over the batch vectorizes.
+static void SampleNoise(OddsBatch *b, float angle, float speed, unsigned int seed) {
+    const float angleScale = ODDS_ANGLE_NOISE * (PI / 180.0f) * 1.7320508f;
+    const float speedScale = ODDS_POWER_NOISE * speed * 1.7320508f;
+    for (int i = 0; i < ODDS_BATCH; i++) {
+        unsigned int base = (seed + (unsigned int)i) * 8u;
+        float na = HashUniform(base) + HashUniform(base + 1) + HashUniform(base + 2) + HashUniform(base + 3) - 2.0f;
+        float np = HashUniform(base + 4) + HashUniform(base + 5) + HashUniform(base + 6) + HashUniform(base + 7) - 2.0f;
+        b->angles[i] = angle + na * angleScale;
+        b->speeds[i] = fminf(fmaxf(speed + np * speedScale, 0.0f), MAX_SHOT_SPEED);
+    }
+}
+
+static void RunSample(int index, void *ctx) {
+    OddsBatch *b = ctx;
+    float angle = b->angles[index];
+    float speed = b->speeds[index];
+    ShotCacheCanonical(&angle, &speed);
+
+    ShotOutcome outcome;
+    unsigned long long key = ShotCacheKey(b->stateHash, angle, speed);
+    if (!ShotCacheLookup(key, &outcome)) {
+        SimulateShot(b->game, angle, speed, NULL, &outcome);
+        ShotCacheStore(key, &outcome);
+    }
+    b->success[index] = ScoreOutcome(b->game, &outcome) > 0.0f;
+}
+
+static void *SamplerThread(void *arg) {
+    (void)arg;
+    static Game request;
+    static OddsBatch batch;
+
+    pthread_mutex_lock(&odds.lock);
+    for (;;) {
+        while (odds.running && (!odds.active || odds.samples >= ODDS_MAX_SAMPLES)) {
+            pthread_cond_wait(&odds.wake, &odds.lock);
+        }
+        if (!odds.running) break;
+
+        request = odds.game;
+        float angle = odds.angle;
+        float speed = odds.speed;
+        unsigned int generation = odds.generation;
+        unsigned int seed = generation * 0x10000u + (unsigned int)odds.samples;
+        batch.game = &request;
+        batch.stateHash = odds.stateHash;
+        pthread_mutex_unlock(&odds.lock);
+
+        SampleNoise(&batch, angle, speed, seed);
+        JobsParallelFor(ODDS_BATCH, RunSample, &batch);
+        int hits = 0;
+        for (int i = 0; i < ODDS_BATCH; i++) hits += batch.success[i];
+
+        pthread_mutex_lock(&odds.lock);
+        if (generation == odds.generation) {
+            odds.samples += ODDS_BATCH;
+            odds.successes += hits;
+        }
+    }
+    pthread_mutex_unlock(&odds.lock);
+    return NULL;
+}
+
+bool ShotOddsStart(void) {
+    if (odds.running) return true;
+    pthread_mutex_init(&odds.lock, NULL);
+    pthread_cond_init(&odds.wake, NULL);
+    odds.running = true;
+    odds.active = false;
+    if (pthread_create(&odds.thread, NULL, SamplerThread, NULL) != 0) {
+        odds.running = false;
+        return false;
+    }
+    return true;
+}
+
+void ShotOddsStop(void) {
+    if (!odds.running) return;
+    pthread_mutex_lock(&odds.lock);
+    odds.running = false;
+    pthread_cond_signal(&odds.wake);
+    pthread_mutex_unlock(&odds.lock);
+    pthread_join(odds.thread, NULL);
+    pthread_cond_destroy(&odds.wake);
+    pthread_mutex_destroy(&odds.lock);
+}
+
+void ShotOddsAim(const Game *game) {
+    if (!odds.running) return;
+
+    float angle = 0.0f, speed = 0.0f;
+    bool aiming = game->aiming && !game->ballsMoving && !game->balls[0].pocketed &&
+                  (game->state == GAME_START || game->state == GAME_PLAYING) &&
+                  !GovernorSheds(SHED_BACKGROUND_AI) &&
+                  GetAim(game, &angle, &speed) && speed > 0.0f;
+
+    pthread_mutex_lock(&odds.lock);
+    if (!aiming) {
+        odds.active = false;
+    } else {
+        // Hashing every frame is cheap next to a single simulated shot
+        unsigned long long stateHash = StateHash(game);
+        if (!odds.active || angle != odds.angle || speed != odds.speed || stateHash != odds.stateHash) {
+            odds.game = *game;
+            odds.angle = angle;
+            odds.speed = speed;
+            odds.stateHash = stateHash;
+            odds.generation++;
+            odds.samples = 0;
+            odds.successes = 0;
+            odds.active = true;
+            pthread_cond_signal(&odds.wake);
+        }
+    }
+    pthread_mutex_unlock(&odds.lock);
+}
+
+// margin is the 95% half-width of the estimate
+bool ShotOddsGet(float *chance, float *margin, int *samples) {
+    if (!odds.running) return false;
+
+    pthread_mutex_lock(&odds.lock);
+    bool ready = odds.active && odds.samples > 0;
+    if (ready) {
+        float p = (float)odds.successes / (float)odds.samples;
+        *chance = p;
+        *margin = 1.96f * sqrtf(p * (1.0f - p) / (float)odds.samples);
+        *samples = odds.samples;
+    }
+    pthread_mutex_unlock(&odds.lock);
+    return ready;
+}
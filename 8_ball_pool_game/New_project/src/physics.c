@@ -1,5 +1,9 @@
 #include "physics.h"
 #include "utils.h"
+#include "solver.h"
+#include "table.h"
+#include "events.h"
+#include "kernels.h"
 
 void ResolveElasticCollision(Ball *a, Ball *b) {
     float dx = b->position.x - a->position.x;
@@ -28,72 +32,90 @@ void ResolveElasticCollision(Ball *a, Ball *b) {
 }
 
 void CheckCollisions(Game *game) {
+    SolverStats stats = {0};
+    SolveContacts(game->balls, MAX_BALLS, &stats, &game->events);
+    game->shotStats.speedClamps += stats.speedClamps;
+}
+
+// The physical half of pocketing: a ball that drops stops and leaves the
+// table. What it means for the game is decided by the rules from the event.
+void PocketBalls(Game *game) {
+    int pockets[MAX_BALLS];
+    GetKernels()->pocketScan(GetTableGeometry(), game->balls, MAX_BALLS, pockets);
     for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed) continue;
-        for (int j = i + 1; j < MAX_BALLS; j++) {
-            if (game->balls[j].pocketed) continue;
-
-            float dist = Distance(game->balls[i].position, game->balls[j].position);
-            float minDist = BALL_RADIUS * 2.0f;
-
-            if (dist < minDist && dist > 0.0001f) {
-                // Separate overlapping balls
-                float overlap = 0.5f * (minDist - dist + 0.001f);
-                Vector2 normal = {
-                    (game->balls[j].position.x - game->balls[i].position.x) / dist,
-                    (game->balls[j].position.y - game->balls[i].position.y) / dist
-                };
-                game->balls[i].position.x -= normal.x * overlap;
-                game->balls[i].position.y -= normal.y * overlap;
-                game->balls[j].position.x += normal.x * overlap;
-                game->balls[j].position.y += normal.y * overlap;
-
-                ResolveElasticCollision(&game->balls[i], &game->balls[j]);
-
-                ClampBallSpeed(&game->balls[i], MAX_BALL_SPEED);
-                ClampBallSpeed(&game->balls[j], MAX_BALL_SPEED);
-            }
-        }
+        if (pockets[i] < 0) continue;
+
+        Ball *ball = &game->balls[i];
+        ball->pocketed = true;
+        ball->velocity = (Vector2){0, 0};
+        EventRingPush(&game->events, EVENT_POCKET, i, pockets[i], 0.0f, ball->position);
     }
 }
 
-void UpdatePhysics(Game *game) {
+// Moves every ball stride steps' worth. For stride 1 this is exactly one
+// UpdatePhysics step; larger strides scale the move and compound the friction.
+// Each pass only touches its own ball, so running friction over the whole
+// rack between the sweep and the bookkeeping gives the per-ball result.
+static void MoveBalls(Game *game, int stride, float friction) {
+    const TableGeometry *table = GetTableGeometry();
+    bool wasMoving[MAX_BALLS];
+    int bounces[MAX_BALLS];
+
+    // Move, bouncing off cushions and jaws along the way
     for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed) continue;
+        Ball *ball = &game->balls[i];
+        if (ball->pocketed) continue;
+        wasMoving[i] = ball->velocity.x != 0.0f || ball->velocity.y != 0.0f;
+
+        if (stride > 1) {
+            ball->velocity.x *= stride;
+            ball->velocity.y *= stride;
+            bounces[i] = SweepBall(table, ball, RAIL_RESTITUTION);
+            ball->velocity.x /= stride;
+            ball->velocity.y /= stride;
+        } else {
+            bounces[i] = SweepBall(table, ball, RAIL_RESTITUTION);
+        }
+    }
 
-        // Move
-        game->balls[i].position.x += game->balls[i].velocity.x;
-        game->balls[i].position.y += game->balls[i].velocity.y;
+    // Friction, and stop very slow balls
+    GetKernels()->damp(game->balls, MAX_BALLS, friction);
 
-        // Friction
-        game->balls[i].velocity.x *= FRICTION;
-        game->balls[i].velocity.y *= FRICTION;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        Ball *ball = &game->balls[i];
+        if (ball->pocketed) continue;
 
-        // Stop very slow balls
-        if (fabs(game->balls[i].velocity.x) < MIN_VELOCITY) game->balls[i].velocity.x = 0;
-        if (fabs(game->balls[i].velocity.y) < MIN_VELOCITY) game->balls[i].velocity.y = 0;
+        if (ClampBallSpeed(ball, MAX_BALL_SPEED)) game->shotStats.speedClamps++;
 
-        // Rail bounces
-        if (game->balls[i].position.x - BALL_RADIUS < RAIL_WIDTH) {
-            game->balls[i].position.x = RAIL_WIDTH + BALL_RADIUS;
-            game->balls[i].velocity.x = -game->balls[i].velocity.x * 0.86f;
-        }
-        if (game->balls[i].position.x + BALL_RADIUS > TABLE_WIDTH - RAIL_WIDTH) {
-            game->balls[i].position.x = TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
-            game->balls[i].velocity.x = -game->balls[i].velocity.x * 0.86f;
-        }
-        if (game->balls[i].position.y - BALL_RADIUS < RAIL_WIDTH) {
-            game->balls[i].position.y = RAIL_WIDTH + BALL_RADIUS;
-            game->balls[i].velocity.y = -game->balls[i].velocity.y * 0.86f;
-        }
-        if (game->balls[i].position.y + BALL_RADIUS > TABLE_HEIGHT - RAIL_WIDTH) {
-            game->balls[i].position.y = TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
-            game->balls[i].velocity.y = -game->balls[i].velocity.y * 0.86f;
-        }
+        float speed = sqrtf(ball->velocity.x * ball->velocity.x +
+                            ball->velocity.y * ball->velocity.y);
+        if (speed > game->shotStats.peakSpeed) game->shotStats.peakSpeed = speed;
+        if (i == 0 && speed > game->shotStats.peakCueSpeed) game->shotStats.peakCueSpeed = speed;
 
-        ClampBallSpeed(&game->balls[i], MAX_BALL_SPEED);
+        if (bounces[i] > 0) EventRingPush(&game->events, EVENT_RAIL, i, bounces[i], speed, ball->position);
+        if (wasMoving[i] && speed == 0.0f) EventRingPush(&game->events, EVENT_REST, i, 0, 0.0f, ball->position);
     }
 
     CheckCollisions(game);
-    CheckPockets(game);
+    PocketBalls(game);
+}
+
+void UpdatePhysics(Game *game) {
+    MoveBalls(game, 1, FRICTION);
+}
+
+void UpdatePhysicsCoarse(Game *game, int maxStride) {
+    float fastest = 0.0f;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        const Ball *ball = &game->balls[i];
+        if (ball->pocketed) continue;
+        fastest = fmaxf(fastest, fabsf(ball->velocity.x) + fabsf(ball->velocity.y));
+    }
+    int stride = fastest > 0.0f ? (int)(COARSE_MAX_TRAVEL / fastest) : maxStride;
+    if (stride > maxStride) stride = maxStride;
+    if (stride <= 1) {
+        MoveBalls(game, 1, FRICTION);
+        return;
+    }
+    MoveBalls(game, stride, powf(FRICTION, (float)stride));
 }
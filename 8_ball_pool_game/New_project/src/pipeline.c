@@ -0,0 +1,130 @@
+#include "pipeline.h"
+#include "game.h"
+#include "stream.h"
+#include "utils.h"
+#include <pthread.h>
+
+#define TRIPLE_BUFFER_FRESH 4
+
+// --- Triple buffer ---
+
+void TripleBufferInit(TripleBuffer *tb, const Game *initial) {
+    for (int i = 0; i < 3; i++) tb->slots[i] = *initial;
+    tb->back = 0;
+    atomic_store(&tb->middle, 1);
+    tb->front = 2;
+}
+
+Game *TripleBufferBack(TripleBuffer *tb) {
+    return &tb->slots[tb->back];
+}
+
+// Swap the freshly written back slot into the middle and take the old middle
+void TripleBufferPublish(TripleBuffer *tb) {
+    int old = atomic_exchange_explicit(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    tb->back = old & 3;
+}
+
+// Take the middle slot if a newer snapshot was published; otherwise keep the current one
+Game *TripleBufferAcquire(TripleBuffer *tb) {
+    if (atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH) {
+        int old = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+        tb->front = old & 3;
+    }
+    return &tb->slots[tb->front];
+}
+
+// --- Input queue ---
+
+void InputQueueInit(InputQueue *q) {
+    atomic_store(&q->head, 0);
+    atomic_store(&q->tail, 0);
+}
+
+bool InputQueuePush(InputQueue *q, const InputFrame *input) {
+    int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    int next = (tail + 1) % INPUT_QUEUE_SIZE;
+    if (next == atomic_load_explicit(&q->head, memory_order_acquire)) return false;
+    q->items[tail] = *input;
+    atomic_store_explicit(&q->tail, next, memory_order_release);
+    return true;
+}
+
+bool InputQueuePop(InputQueue *q, InputFrame *input) {
+    int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&q->tail, memory_order_acquire)) return false;
+    *input = q->items[head];
+    atomic_store_explicit(&q->head, (head + 1) % INPUT_QUEUE_SIZE, memory_order_release);
+    return true;
+}
+
+// --- Simulation thread ---
+
+static struct {
+    pthread_t thread;
+    atomic_bool running;
+    Game game;              // owned by the simulation thread while running
+    TripleBuffer snapshots;
+    InputQueue input;
+    FrameStats tickStats;
+    int droppedInput;
+} pipeline;
+
+static void *SimulationThread(void *arg) {
+    (void)arg;
+    double next = NowSeconds();
+
+    while (atomic_load(&pipeline.running)) {
+        double start = NowSeconds();
+
+        InputFrame input;
+        while (InputQueuePop(&pipeline.input, &input)) HandleInput(&pipeline.game, &input);
+        TickGame(&pipeline.game);
+        StreamFrame(&pipeline.game);
+
+        *TripleBufferBack(&pipeline.snapshots) = pipeline.game;
+        TripleBufferPublish(&pipeline.snapshots);
+
+        double now = NowSeconds();
+        FrameStatsAdd(&pipeline.tickStats, now - start);
+
+        // Fixed tick; after a long stall, resynchronize instead of running a burst of catch-up ticks
+        next += 1.0 / TARGET_FPS;
+        if (next < now - 0.25) next = now;
+        SleepSeconds(next - now);
+    }
+    return NULL;
+}
+
+bool PipelineStart(const Game *initial) {
+    pipeline.game = *initial;
+    TripleBufferInit(&pipeline.snapshots, initial);
+    InputQueueInit(&pipeline.input);
+    FrameStatsReset(&pipeline.tickStats);
+    pipeline.droppedInput = 0;
+
+    atomic_store(&pipeline.running, true);
+    if (pthread_create(&pipeline.thread, NULL, SimulationThread, NULL) != 0) {
+        atomic_store(&pipeline.running, false);
+        return false;
+    }
+    return true;
+}
+
+void PipelineSubmitInput(const InputFrame *input) {
+    if (!InputQueuePush(&pipeline.input, input)) pipeline.droppedInput++;
+}
+
+Game *PipelineLatest(void) {
+    return TripleBufferAcquire(&pipeline.snapshots);
+}
+
+void PipelineStop(Game *final) {
+    if (!atomic_load(&pipeline.running)) return;
+    atomic_store(&pipeline.running, false);
+    pthread_join(pipeline.thread, NULL);
+
+    FrameStatsPrint(&pipeline.tickStats, "simulation tick");
+    if (pipeline.droppedInput > 0) printf("pipeline: dropped %d input frames\n", pipeline.droppedInput);
+    if (final) *final = pipeline.game;
+}
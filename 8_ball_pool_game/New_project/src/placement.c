@@ -0,0 +1,244 @@
+#include "placement.h"
+#include "ai.h"
+#include "jobs.h"
+#include "governor.h"
+#include "sim.h"
+#include <pthread.h>
+
+// --- Free-space grid ---
+
+static inline int GridCol(float x) {
+    int c = (int)(x / BALL_GRID_CELL);
+    return c < 0 ? 0 : c >= BALL_GRID_COLS ? BALL_GRID_COLS - 1 : c;
+}
+
+static inline int GridRow(float y) {
+    int r = (int)(y / BALL_GRID_CELL);
+    return r < 0 ? 0 : r >= BALL_GRID_ROWS ? BALL_GRID_ROWS - 1 : r;
+}
+
+void BallGridBuild(BallGrid *grid, const Game *game) {
+    memset(grid->head, -1, sizeof(grid->head));
+    for (int i = 1; i < MAX_BALLS; i++) {
+        const Ball *b = &game->balls[i];
+        grid->next[i] = -1;
+        if (b->pocketed) continue;
+        int r = GridRow(b->position.y), c = GridCol(b->position.x);
+        grid->next[i] = grid->head[r][c];
+        grid->head[r][c] = (signed char)i;
+    }
+}
+
+// Balls in the clamped edge cells may sit beyond them, which only makes the
+// neighbourhood wider; a ball off the 3x3 block is always over a cell away.
+bool BallGridIsFree(const BallGrid *grid, const Game *game, Vector2 spot, float clearance) {
+    int r0 = GridRow(spot.y), c0 = GridCol(spot.x);
+    float clearance2 = clearance * clearance;
+    for (int r = r0 - 1; r <= r0 + 1; r++) {
+        if (r < 0 || r >= BALL_GRID_ROWS) continue;
+        for (int c = c0 - 1; c <= c0 + 1; c++) {
+            if (c < 0 || c >= BALL_GRID_COLS) continue;
+            for (int i = grid->head[r][c]; i >= 0; i = grid->next[i]) {
+                float dx = game->balls[i].position.x - spot.x;
+                float dy = game->balls[i].position.y - spot.y;
+                if (dx * dx + dy * dy < clearance2) return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool InsideRails(Vector2 spot) {
+    return spot.x > RAIL_WIDTH + BALL_RADIUS && spot.x < TABLE_WIDTH  - RAIL_WIDTH - BALL_RADIUS &&
+           spot.y > RAIL_WIDTH + BALL_RADIUS && spot.y < TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
+}
+
+bool CueSpotIsValid(const Game *game, Vector2 spot) {
+    if (!InsideRails(spot)) return false;
+    if (game->cueGridReady) return BallGridIsFree(&game->cueGrid, game, spot, BALL_RADIUS * 2.0f);
+    BallGrid grid;
+    BallGridBuild(&grid, game);
+    return BallGridIsFree(&grid, game, spot, BALL_RADIUS * 2.0f);
+}
+
+// --- Placement help ---
+
+// The window thread posts the table while a human has ball in hand; the
+// scorer thread works through the spots of the newest one and publishes each
+// batch only if the table has not changed meanwhile. Only the cue ball moves
+// between spots, so each spot's state hash is the table's with the cue ball
+// swapped in.
+
+#define PLACEMENT_SPOTS (PLACEMENT_COLS * PLACEMENT_ROWS)
+#define PLACEMENT_ORDER_STEP 97     // coprime with PLACEMENT_SPOTS: spreads each batch over the table
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool running;
+
+    // Latest table from the window thread
+    Game game;
+    unsigned long long stateHash;
+    unsigned int generation;
+    bool active;
+
+    // Results for the current generation
+    int next;               // spots handed out, in PLACEMENT_ORDER_STEP order
+    PlacementHeatmap heatmap;
+} help;
+
+typedef struct {
+    const Game *game;           // the table with the cue ball in play
+    const BallGrid *grid;
+    unsigned long long baseHash;
+    int spots[PLACEMENT_BATCH];
+    unsigned char state[PLACEMENT_BATCH];
+    float score[PLACEMENT_BATCH];
+} SpotBatch;
+
+Vector2 PlacementSpot(int row, int col) {
+    const float left = RAIL_WIDTH + BALL_RADIUS, top = RAIL_WIDTH + BALL_RADIUS;
+    const float width = TABLE_WIDTH - 2.0f * left, height = TABLE_HEIGHT - 2.0f * top;
+    return (Vector2){ left + width * (col + 0.5f) / PLACEMENT_COLS, top + height * (row + 0.5f) / PLACEMENT_ROWS };
+}
+
+static void ScoreSpot(int index, void *ctx) {
+    SpotBatch *b = ctx;
+    int spot = b->spots[index];
+    Vector2 position = PlacementSpot(spot / PLACEMENT_COLS, spot % PLACEMENT_COLS);
+
+    if (!InsideRails(position) || !BallGridIsFree(b->grid, b->game, position, BALL_RADIUS * 2.0f)) {
+        b->state[index] = SPOT_BLOCKED;
+        return;
+    }
+
+    Game trial = *b->game;
+    trial.balls[0].position = position;
+    ShotChoice best;
+    unsigned long long hash = b->baseHash ^ StateHashBall(0, &trial.balls[0]);
+    bool found = SearchPotShots(&trial, hash, &best, NULL) && best.score > 0.0f;
+    if (!found) {
+        found = SearchShotCoarse(&trial, hash, SEARCH_ANGLE_STEPS / PLACEMENT_ANGLE_STEPS,
+                                 SEARCH_POWER_STEPS / PLACEMENT_POWER_STEPS, &best);
+    }
+    b->state[index] = found ? SPOT_SCORED : SPOT_BLOCKED;
+    b->score[index] = found ? best.score : 0.0f;
+}
+
+static void *ScorerThread(void *arg) {
+    (void)arg;
+    static Game request;
+    static BallGrid grid;
+    static SpotBatch batch;
+    unsigned int prepared = 0;
+
+    pthread_mutex_lock(&help.lock);
+    for (;;) {
+        while (help.running && (!help.active || help.next >= PLACEMENT_SPOTS)) {
+            pthread_cond_wait(&help.wake, &help.lock);
+        }
+        if (!help.running) break;
+
+        unsigned int generation = help.generation;
+        if (prepared != generation) request = help.game;
+        int count = 0;
+        for (; count < PLACEMENT_BATCH && help.next < PLACEMENT_SPOTS; count++) {
+            batch.spots[count] = (help.next++ * PLACEMENT_ORDER_STEP) % PLACEMENT_SPOTS;
+        }
+        pthread_mutex_unlock(&help.lock);
+
+        // The same table the shot search will see once the cue ball is down
+        if (prepared != generation) {
+            request.state = GAME_PLAYING;
+            request.balls[0].pocketed = false;
+            request.balls[0].velocity = (Vector2){ 0, 0 };
+            request.balls[0].position = request.cueBallPos;
+            batch.baseHash = StateHash(&request) ^ StateHashBall(0, &request.balls[0]);
+            BallGridBuild(&grid, &request);
+            batch.game = &request;
+            batch.grid = &grid;
+            prepared = generation;
+        }
+        JobsParallelFor(count, ScoreSpot, &batch);
+
+        pthread_mutex_lock(&help.lock);
+        if (generation == help.generation) {
+            PlacementHeatmap *h = &help.heatmap;
+            for (int i = 0; i < count; i++) {
+                int row = batch.spots[i] / PLACEMENT_COLS, col = batch.spots[i] % PLACEMENT_COLS;
+                h->state[row][col] = batch.state[i];
+                h->score[row][col] = batch.score[i];
+                if (batch.state[i] != SPOT_SCORED) continue;
+                h->scored++;
+                if (h->bestRow < 0 || batch.score[i] > h->score[h->bestRow][h->bestCol]) {
+                    h->bestRow = row;
+                    h->bestCol = col;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&help.lock);
+    return NULL;
+}
+
+bool PlacementHelpStart(void) {
+    if (help.running) return true;
+    pthread_mutex_init(&help.lock, NULL);
+    pthread_cond_init(&help.wake, NULL);
+    help.running = true;
+    help.active = false;
+    if (pthread_create(&help.thread, NULL, ScorerThread, NULL) != 0) {
+        help.running = false;
+        return false;
+    }
+    return true;
+}
+
+void PlacementHelpStop(void) {
+    if (!help.running) return;
+    pthread_mutex_lock(&help.lock);
+    help.running = false;
+    pthread_cond_signal(&help.wake);
+    pthread_mutex_unlock(&help.lock);
+    pthread_join(help.thread, NULL);
+    pthread_cond_destroy(&help.wake);
+    pthread_mutex_destroy(&help.lock);
+}
+
+void PlacementHelpUpdate(const Game *game) {
+    if (!help.running) return;
+
+    bool wanted = game->placementHelp && game->state == GAME_SCRATCH && !game->scrubbing &&
+                  !GovernorSheds(SHED_BACKGROUND_AI);
+
+    pthread_mutex_lock(&help.lock);
+    if (!wanted) {
+        help.active = false;
+    } else {
+        // The table does not move while the ball is in hand, so this rarely restarts
+        unsigned long long stateHash = StateHash(game);
+        if (!help.active || stateHash != help.stateHash) {
+            help.game = *game;
+            help.stateHash = stateHash;
+            help.generation++;
+            help.next = 0;
+            memset(&help.heatmap, 0, sizeof(help.heatmap));
+            help.heatmap.bestRow = help.heatmap.bestCol = -1;
+            help.active = true;
+            pthread_cond_signal(&help.wake);
+        }
+    }
+    pthread_mutex_unlock(&help.lock);
+}
+
+bool PlacementHelpGet(PlacementHeatmap *heatmap) {
+    if (!help.running) return false;
+
+    pthread_mutex_lock(&help.lock);
+    bool ready = help.active;
+    if (ready) *heatmap = help.heatmap;
+    pthread_mutex_unlock(&help.lock);
+    return ready;
+}
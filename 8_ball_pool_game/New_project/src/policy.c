@@ -0,0 +1,165 @@
+#include "policy.h"
+#include "sim.h"
+#include "kernels.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const char policyMagic[8] = { 'P', 'O', 'O', 'L', 'M', 'L', 'P', '1' };
+
+static PolicyModel defaultPolicy;
+static bool defaultLoaded;
+
+// --- Encoding ---
+
+// Positions to [-1, 1] across the cloth, zero for a pocketed ball; the
+// shooter's group one-hot, so the same table reads differently per player
+void PolicyEncode(const Game *game, float features[POLICY_INPUTS]) {
+    memset(features, 0, sizeof(float) * POLICY_INPUTS);
+    const float halfW = TABLE_WIDTH * 0.5f, halfH = TABLE_HEIGHT * 0.5f;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        const Ball *b = &game->balls[i];
+        if (b->pocketed) {
+            features[3 * i + 2] = 1.0f;
+            continue;
+        }
+        features[3 * i]     = (b->position.x - halfW) / halfW;
+        features[3 * i + 1] = (b->position.y - halfH) / halfH;
+    }
+    PlayerType type = game->players[game->currentPlayer].type;
+    features[3 * MAX_BALLS + (type == PLAYER_SOLIDS ? 1 : type == PLAYER_STRIPES ? 2 : 0)] = 1.0f;
+}
+
+// --- Kernels ---
+
+// Both vectors padded to a multiple of POLICY_ALIGN and clamped to +-127, so
+// a pair of products never overflows 16 bits. On x86 the physics kernel
+// backend chosen at startup does the work.
+static int Dot(const signed char *a, const signed char *w, unsigned int n) {
+#if defined(__ARM_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (unsigned int i = 0; i < n; i += 16) {
+        int8x16_t x = vld1q_s8(a + i);
+        int8x16_t y = vld1q_s8(w + i);
+        int16x8_t p = vmull_s8(vget_low_s8(x), vget_low_s8(y));
+        p = vmlal_s8(p, vget_high_s8(x), vget_high_s8(y));
+        acc = vpadalq_s16(acc, p);
+    }
+    return vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) + vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+#else
+    return GetKernels()->dotS8(a, w, n);
+#endif
+}
+
+const char *PolicyKernelName(void) {
+#if defined(__ARM_NEON)
+    return "neon";
+#else
+    return GetKernels()->name;
+#endif
+}
+
+static void Quantize(const float *values, unsigned int count, float step, signed char *out, unsigned int padded) {
+    float inv = 1.0f / step;
+    for (unsigned int i = 0; i < count; i++) {
+        float q = roundf(values[i] * inv);
+        out[i] = (signed char)(q > 127.0f ? 127 : q < -127.0f ? -127 : q);
+    }
+    memset(out + count, 0, padded - count);
+}
+
+// --- Loading ---
+
+bool PolicyOpen(PolicyModel *model, const char *path) {
+    memset(model, 0, sizeof(*model));
+    if (!MapFileOpen(&model->file, path)) return false;
+
+    const PolicyHeader *h = model->file.data;
+    bool ok = model->file.size >= sizeof(PolicyHeader) &&
+              memcmp(h->magic, policyMagic, sizeof(policyMagic)) == 0 &&
+              h->version == POLICY_VERSION && h->layerCount >= 1 && h->layerCount <= POLICY_MAX_LAYERS &&
+              h->layers[0].inputs == POLICY_INPUTS && h->layers[h->layerCount - 1].outputs == POLICY_OUTPUTS;
+    for (unsigned int l = 0; ok && l < h->layerCount; l++) {
+        const PolicyLayerInfo *info = &h->layers[l];
+        unsigned long long bytes = (unsigned long long)info->outputs * (2 * sizeof(float) + info->inputs);
+        ok = info->inputs % POLICY_ALIGN == 0 && info->offset % POLICY_ALIGN == 0 &&
+             info->offset + bytes <= model->file.size && info->inputScale > 0.0f &&
+             (l == 0 || info->inputs >= h->layers[l - 1].outputs);
+        if (!ok) break;
+        const char *base = (const char *)model->file.data + info->offset;
+        model->layers[l].scales = (const float *)base;
+        model->layers[l].bias = (const float *)base + info->outputs;
+        model->layers[l].weights = (const signed char *)(base + 2 * sizeof(float) * info->outputs);
+        if (info->inputs > model->maxWidth) model->maxWidth = info->inputs;
+        if (info->outputs > model->maxWidth) model->maxWidth = info->outputs;
+    }
+    if (ok && model->maxWidth > POLICY_MAX_WIDTH) ok = false;
+    if (!ok) {
+        MapFileClose(&model->file);
+        return false;
+    }
+    if (h->specHash != TableSpecHash()) {
+        fprintf(stderr, "policy: %s was trained on a different table or physics; its picks may be off\n", path);
+    }
+    model->header = h;
+    return true;
+}
+
+void PolicyClose(PolicyModel *model) {
+    MapFileClose(&model->file);
+    memset(model, 0, sizeof(*model));
+}
+
+// --- Inference ---
+
+void PolicyForward(const PolicyModel *model, const float features[POLICY_INPUTS], float logits[POLICY_OUTPUTS]) {
+    const PolicyHeader *h = model->header;
+    _Alignas(POLICY_ALIGN) signed char input[POLICY_MAX_WIDTH];
+    float values[POLICY_MAX_WIDTH];
+
+    Quantize(features, POLICY_INPUTS, h->layers[0].inputScale, input, POLICY_INPUTS);
+    for (unsigned int l = 0; l < h->layerCount; l++) {
+        const PolicyLayerInfo *info = &h->layers[l];
+        const PolicyLayer *layer = &model->layers[l];
+        bool last = l + 1 == h->layerCount;
+        float *out = last ? logits : values;
+        for (unsigned int o = 0; o < info->outputs; o++) {
+            float y = (float)Dot(input, layer->weights + (size_t)o * info->inputs, info->inputs) * layer->scales[o] +
+                      layer->bias[o];
+            out[o] = info->relu && y < 0.0f ? 0.0f : y;
+        }
+        if (!last) Quantize(values, info->outputs, h->layers[l + 1].inputScale, input, h->layers[l + 1].inputs);
+    }
+}
+
+int PolicyShortlist(const PolicyModel *model, const Game *game, PolicyShot *shots, int count) {
+    if (!model || !model->header || count <= 0) return 0;
+    float features[POLICY_INPUTS];
+    float logits[POLICY_OUTPUTS];
+    PolicyEncode(game, features);
+    PolicyForward(model, features, logits);
+
+    // Insertion into a short sorted list; ties keep the lower index
+    int n = 0;
+    for (int i = 0; i < POLICY_OUTPUTS; i++) {
+        if (n == count && logits[i] <= shots[n - 1].logit) continue;
+        int k = n < count ? n++ : n - 1;
+        while (k > 0 && shots[k - 1].logit < logits[i]) {
+            shots[k] = shots[k - 1];
+            k--;
+        }
+        shots[k] = (PolicyShot){ i, logits[i] };
+    }
+    return n;
+}
+
+bool PolicyLoadDefault(const char *path) {
+    if (defaultLoaded) return true;
+    defaultLoaded = PolicyOpen(&defaultPolicy, path);
+    return defaultLoaded;
+}
+
+const PolicyModel *GetPolicy(void) {
+    return defaultLoaded ? &defaultPolicy : NULL;
+}
@@ -0,0 +1,234 @@
+#include "potlut.h"
+#include "game.h"
+#include "events.h"
+#include "jobs.h"
+#include "physics.h"
+#include "sim.h"
+#include "table.h"
+#include "utils.h"
+
+#define PROBE_BALL 1
+
+static const char potLutMagic[8] = { 'P', 'O', 'O', 'L', 'P', 'O', 'T', 'S' };
+
+static PotLut defaultLut;
+static bool defaultLoaded;
+
+// --- Building ---
+
+typedef struct {
+    Game lone;                  // every ball down but PROBE_BALL
+    int cols, rows;
+    float originX, originY;
+    PotCell *cells;
+} BuildJob;
+
+// Rolls the lone object ball from start along angle. The pocket it drops in,
+// or -1 if it touches a cushion or jaw first or comes to rest on the cloth.
+static int Probe(const BuildJob *job, Vector2 start, float angle) {
+    Game g = job->lone;
+    Ball *b = &g.balls[PROBE_BALL];
+    b->position = start;
+    b->velocity = (Vector2){ cosf(angle) * POT_LUT_PROBE_SPEED, sinf(angle) * POT_LUT_PROBE_SPEED };
+
+    for (int step = 0; step < FAST_FORWARD_MAX_STEPS; step++) {
+        UpdatePhysics(&g);
+        for (int k = 0; k < EventRingCount(&g.events); k++) {
+            const PhysicsEvent *e = EventRingAt(&g.events, k);
+            if (e->type == EVENT_POCKET) return e->b;
+            if (e->type == EVENT_RAIL || e->type == EVENT_REST) return -1;
+        }
+        EventRingClear(&g.events);
+        if (b->pocketed) return PocketAt(GetTableGeometry(), b->position);
+        if (b->velocity.x == 0.0f && b->velocity.y == 0.0f) return -1;
+    }
+    return -1;
+}
+
+// Narrows the boundary between an offset that pots in pocket (in) and one
+// that does not (out)
+static float RefineEdge(const BuildJob *job, Vector2 start, float direct, int pocket, float in, float out) {
+    for (int i = 0; i < POT_LUT_REFINE_STEPS; i++) {
+        float mid = 0.5f * (in + out);
+        if (Probe(job, start, direct + mid) == pocket) in = mid;
+        else out = mid;
+    }
+    return in;
+}
+
+// Scans offsets either side of the direct line and keeps the run of potting
+// offsets that holds the direct line, or failing that the one nearest it
+static PotWindow SolveWindow(const BuildJob *job, Vector2 start, int pocket) {
+    PotWindow w = { 0.0f, 0.0f };
+    Vector2 p = GetTableGeometry()->pockets[pocket];
+    float direct = atan2f(p.y - start.y, p.x - start.x);
+    const float step = POT_LUT_SCAN_STEP * (PI / 180.0f);
+    const int n = (int)(POT_LUT_SCAN_RANGE / POT_LUT_SCAN_STEP + 0.5f);
+
+    bool hit[2 * 64 + 1];
+    for (int k = -n; k <= n; k++) hit[k + n] = Probe(job, start, direct + k * step) == pocket;
+
+    int bestLo = 0, bestHi = -1, bestDistance = 1 << 30;
+    for (int k = -n; k <= n; k++) {
+        if (!hit[k + n] || (k > -n && hit[k - 1 + n])) continue;
+        int hi = k;
+        while (hi < n && hit[hi + 1 + n]) hi++;
+        int distance = k > 0 ? k : hi < 0 ? -hi : 0;
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            bestLo = k;
+            bestHi = hi;
+        }
+    }
+    if (bestHi < bestLo) return w;
+
+    float lo = bestLo * step, hi = bestHi * step;
+    if (bestLo > -n) lo = RefineEdge(job, start, direct, pocket, lo, lo - step);
+    if (bestHi < n) hi = RefineEdge(job, start, direct, pocket, hi, hi + step);
+    w.offset = 0.5f * (lo + hi);
+    w.margin = 0.5f * (hi - lo);
+    return w;
+}
+
+static void BuildCell(int index, void *ctx) {
+    BuildJob *job = ctx;
+    int row = index / job->cols, col = index % job->cols;
+    Vector2 start = { job->originX + col * POT_LUT_CELL, job->originY + row * POT_LUT_CELL };
+    PotCell *cell = &job->cells[index];
+    for (int k = 0; k < 6; k++) cell->pockets[k] = SolveWindow(job, start, k);
+}
+
+bool PotLutBuild(const char *path) {
+    const TableGeometry *table = GetTableGeometry();
+    BuildJob *job = calloc(1, sizeof(*job));
+    if (!job) return false;
+
+    InitGame(&job->lone);
+    for (int i = 0; i < MAX_BALLS; i++) {
+        job->lone.balls[i].pocketed = i != PROBE_BALL;
+        job->lone.balls[i].velocity = (Vector2){ 0, 0 };
+    }
+    EventRingClear(&job->lone.events);
+
+    // Cell centres run over the area where a ball touches no cushion
+    job->originX = table->safeMinX;
+    job->originY = table->safeMinY;
+    job->cols = (int)((table->safeMaxX - table->safeMinX) / POT_LUT_CELL) + 1;
+    job->rows = (int)((table->safeMaxY - table->safeMinY) / POT_LUT_CELL) + 1;
+    int count = job->cols * job->rows;
+    job->cells = calloc((size_t)count, sizeof(PotCell));
+    if (!job->cells) {
+        free(job);
+        return false;
+    }
+
+    double start = NowSeconds();
+    JobsParallelFor(count, BuildCell, job);
+
+    PotLutHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, potLutMagic, sizeof(potLutMagic));
+    h.version = POT_LUT_VERSION;
+    h.specHash = TableSpecHash();
+    h.cols = job->cols;
+    h.rows = job->rows;
+    h.originX = job->originX;
+    h.originY = job->originY;
+    h.cell = POT_LUT_CELL;
+    h.recordSize = sizeof(PotCell);
+
+    // Written aside and renamed over the old table, so a reader never maps half a file
+    char temp[512];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *f = fopen(temp, "wb");
+    bool ok = f && fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(job->cells, sizeof(PotCell), (size_t)count, f) == (size_t)count;
+    if (f && fclose(f) != 0) ok = false;
+    ok = ok && FileReplace(temp, path);
+    if (!ok) remove(temp);
+
+    printf("pot table: %d x %d cells, %.1f s on %d threads%s\n", job->cols, job->rows,
+           NowSeconds() - start, JobsThreadCount(), ok ? "" : " (not saved)");
+    free(job->cells);
+    free(job);
+    return ok;
+}
+
+// --- Lookups ---
+
+bool PotLutOpen(PotLut *lut, const char *path) {
+    lut->header = NULL;
+    lut->cells = NULL;
+    if (!MapFileOpen(&lut->file, path)) return false;
+
+    const PotLutHeader *h = lut->file.data;
+    bool ok = lut->file.size >= sizeof(PotLutHeader) &&
+              memcmp(h->magic, potLutMagic, sizeof(potLutMagic)) == 0 &&
+              h->version == POT_LUT_VERSION &&
+              h->recordSize == sizeof(PotCell) && h->cols > 0 && h->rows > 0 &&
+              isfinite(h->cell) && h->cell > 0.0f && isfinite(h->originX) && isfinite(h->originY) &&
+              lut->file.size >= sizeof(PotLutHeader) + (size_t)h->cols * h->rows * sizeof(PotCell);
+    if (ok && h->specHash != TableSpecHash()) {
+        fprintf(stderr, "pot table: %s was built for a different table or physics\n", path);
+        ok = false;
+    }
+    if (!ok) {
+        MapFileClose(&lut->file);
+        return false;
+    }
+
+    lut->header = h;
+    lut->cells = (const PotCell *)((const char *)lut->file.data + sizeof(PotLutHeader));
+    return true;
+}
+
+void PotLutClose(PotLut *lut) {
+    MapFileClose(&lut->file);
+    lut->header = NULL;
+    lut->cells = NULL;
+}
+
+// Window of the nearest cell, re-centred on the line from object to pocket
+bool PotLutWindow(const PotLut *lut, Vector2 object, int pocket, float *angle, float *margin) {
+    if (!lut || !lut->header || pocket < 0 || pocket >= 6) return false;
+    const PotLutHeader *h = lut->header;
+    int col = (int)floorf((object.x - h->originX) / h->cell + 0.5f);
+    int row = (int)floorf((object.y - h->originY) / h->cell + 0.5f);
+    if (col < 0 || col >= h->cols || row < 0 || row >= h->rows) return false;
+
+    const PotWindow *w = &lut->cells[row * h->cols + col].pockets[pocket];
+    if (w->margin <= 0.0f) return false;
+    Vector2 p = GetTableGeometry()->pockets[pocket];
+    if (angle) *angle = atan2f(p.y - object.y, p.x - object.x) + w->offset;
+    if (margin) *margin = w->margin;
+    return true;
+}
+
+// The cue ball sends the object ball along the line of centres at contact,
+// so it is aimed at the ghost ball two radii back along objectAngle
+int PotLutCandidates(const PotLut *lut, Vector2 cue, Vector2 object, PotCandidate candidates[6]) {
+    int count = 0;
+    for (int k = 0; k < 6; k++) {
+        PotCandidate c;
+        c.pocket = k;
+        if (!PotLutWindow(lut, object, k, &c.objectAngle, &c.margin)) continue;
+        Vector2 ghost = { object.x - cosf(c.objectAngle) * 2.0f * BALL_RADIUS,
+                          object.y - sinf(c.objectAngle) * 2.0f * BALL_RADIUS };
+        c.cueAngle = atan2f(ghost.y - cue.y, ghost.x - cue.x);
+        c.cut = fabsf(remainderf(c.objectAngle - c.cueAngle, 2.0f * PI));
+        if (c.cut >= POT_LUT_MAX_CUT * (PI / 180.0f)) continue;
+        candidates[count++] = c;
+    }
+    return count;
+}
+
+bool PotLutLoadDefault(const char *path) {
+    if (defaultLoaded) return true;
+    defaultLoaded = PotLutOpen(&defaultLut, path);
+    if (!defaultLoaded && PotLutBuild(path)) defaultLoaded = PotLutOpen(&defaultLut, path);
+    return defaultLoaded;
+}
+
+const PotLut *GetPotLut(void) {
+    return defaultLoaded ? &defaultLut : NULL;
+}
@@ -0,0 +1,38 @@
+#include "procmem.h"
+
+// Kept apart from common.h: windows.h and raylib.h declare clashing names
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2     // GetProcessMemoryInfo from kernel32, no psapi.lib
+#include <windows.h>
+#include <psapi.h>
+
+bool ProcessMemory(size_t *resident, size_t *peak) {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return false;
+    *resident = counters.WorkingSetSize;
+    *peak = counters.PeakWorkingSetSize;
+    return true;
+}
+
+#else
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+bool ProcessMemory(size_t *resident, size_t *peak) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return false;
+    unsigned long pages = 0, residentPages = 0;
+    int read = fscanf(f, "%lu %lu", &pages, &residentPages);
+    fclose(f);
+    if (read != 2) return false;
+    *resident = (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *peak = (size_t)usage.ru_maxrss * 1024;    // kilobytes on Linux
+    if (*peak < *resident) *peak = *resident;
+    return true;
+}
+#endif
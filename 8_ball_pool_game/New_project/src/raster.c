@@ -0,0 +1,233 @@
+#include "raster.h"
+#include "table.h"
+
+bool CanvasInit(Canvas *canvas, int width, int height) {
+    canvas->width = width;
+    canvas->height = height;
+    canvas->pixels = malloc(sizeof(Color) * (size_t)width * (size_t)height);
+    return canvas->pixels != NULL;
+}
+
+void CanvasFree(Canvas *canvas) {
+    free(canvas->pixels);
+    canvas->pixels = NULL;
+}
+
+// --- Spans ---
+
+static inline unsigned char Mix(unsigned char src, unsigned char dst, unsigned int a) {
+    return (unsigned char)((src * a + dst * (255u - a) + 127u) / 255u);
+}
+
+// Pixels x0..x1 inclusive of row y, clipped
+static void FillSpan(Canvas *canvas, int y, int x0, int x1, Color color) {
+    if (y < 0 || y >= canvas->height || color.a == 0) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= canvas->width) x1 = canvas->width - 1;
+    Color *row = canvas->pixels + (size_t)y * canvas->width;
+
+    if (color.a == 255) {
+        for (int x = x0; x <= x1; x++) row[x] = color;
+        return;
+    }
+    for (int x = x0; x <= x1; x++) {
+        Color *d = &row[x];
+        d->r = Mix(color.r, d->r, color.a);
+        d->g = Mix(color.g, d->g, color.a);
+        d->b = Mix(color.b, d->b, color.a);
+        d->a = (unsigned char)(color.a + d->a * (255u - color.a) / 255u);
+    }
+}
+
+// Covered pixels of a row are those whose centers fall in [left, right]
+static void FillCenters(Canvas *canvas, int y, float left, float right, Color color) {
+    int x0 = (int)ceilf(left - 0.5f);
+    int x1 = (int)floorf(right - 0.5f);
+    if (x0 <= x1) FillSpan(canvas, y, x0, x1, color);
+}
+
+static void RowRange(const Canvas *canvas, float top, float bottom, int *y0, int *y1) {
+    *y0 = (int)ceilf(top - 0.5f);
+    *y1 = (int)floorf(bottom - 0.5f);
+    if (*y0 < 0) *y0 = 0;
+    if (*y1 >= canvas->height) *y1 = canvas->height - 1;
+}
+
+// --- Shapes ---
+
+void RasterClear(Canvas *canvas, Color color) {
+    size_t count = (size_t)canvas->width * canvas->height;
+    for (size_t i = 0; i < count; i++) canvas->pixels[i] = color;
+}
+
+void RasterRectangle(Canvas *canvas, float x, float y, float width, float height, Color color) {
+    int y0, y1;
+    RowRange(canvas, y, y + height, &y0, &y1);
+    for (int row = y0; row <= y1; row++) FillCenters(canvas, row, x, x + width, color);
+}
+
+void RasterCircle(Canvas *canvas, Vector2 center, float radius, Color color) {
+    int y0, y1;
+    RowRange(canvas, center.y - radius, center.y + radius, &y0, &y1);
+    for (int row = y0; row <= y1; row++) {
+        float dy = row + 0.5f - center.y;
+        float dx2 = radius * radius - dy * dy;
+        if (dx2 < 0.0f) continue;
+        float dx = sqrtf(dx2);
+        FillCenters(canvas, row, center.x - dx, center.x + dx, color);
+    }
+}
+
+// A quad of the given thickness along a-b with square ends at a and b, like
+// DrawLineEx. Each row is clipped against the quad's four edges.
+void RasterLine(Canvas *canvas, Vector2 a, Vector2 b, float thick, Color color) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len < 0.0001f) return;
+    float ux = dx / len, uy = dy / len;     // along the line
+    float half = thick * 0.5f;
+
+    float hx = fabsf(uy) * half, hy = fabsf(ux) * half;
+    float top = fminf(a.y, b.y) - hy, bottom = fmaxf(a.y, b.y) + hy;
+    int y0, y1;
+    RowRange(canvas, top, bottom, &y0, &y1);
+    float minX = fminf(a.x, b.x) - hx, maxX = fmaxf(a.x, b.x) + hx;
+
+    for (int row = y0; row <= y1; row++) {
+        float py = row + 0.5f - a.y;
+        float left = minX, right = maxX;
+
+        // Along the line ux*px + uy*py in [0, len], across it -uy*px + ux*py in [-half, half]
+        const float slopes[2]  = { ux, -uy };
+        const float offsets[2] = { uy * py, ux * py };
+        const float lows[2]    = { 0.0f, -half };
+        const float highs[2]   = { len, half };
+        bool empty = false;
+        for (int k = 0; k < 2; k++) {
+            if (fabsf(slopes[k]) < 1e-6f) {
+                if (offsets[k] < lows[k] || offsets[k] > highs[k]) empty = true;
+                continue;
+            }
+            float x0 = (lows[k] - offsets[k]) / slopes[k], x1 = (highs[k] - offsets[k]) / slopes[k];
+            if (x0 > x1) { float t = x0; x0 = x1; x1 = t; }
+            left = fmaxf(left, a.x + x0);
+            right = fminf(right, a.x + x1);
+        }
+        if (!empty) FillCenters(canvas, row, left, right, color);
+    }
+}
+
+// --- Numbers ---
+
+// 3x5 digits, top row in the high bits. Ball numbers are the only text on
+// the table, so digits are all the offline path draws.
+static const unsigned short digitGlyphs[10] = {
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7292, 0x7BEF, 0x7BCF
+};
+
+static int GlyphScale(int fontSize) {
+    int scale = fontSize / 6;
+    return scale < 1 ? 1 : scale;
+}
+
+int RasterMeasureNumber(const char *digits, int fontSize) {
+    int scale = GlyphScale(fontSize);
+    int count = (int)strlen(digits);
+    return count > 0 ? count * 3 * scale + (count - 1) * scale : 0;
+}
+
+void RasterNumber(Canvas *canvas, const char *digits, int x, int y, int fontSize, Color color) {
+    int scale = GlyphScale(fontSize);
+    int top = y + (fontSize - 5 * scale) / 2;
+    for (const char *d = digits; *d; d++, x += 4 * scale) {
+        if (*d < '0' || *d > '9') continue;
+        unsigned short glyph = digitGlyphs[*d - '0'];
+        for (int gy = 0; gy < 5; gy++) {
+            for (int gx = 0; gx < 3; gx++) {
+                if (!(glyph & (1u << (14 - gy * 3 - gx)))) continue;
+                for (int sy = 0; sy < scale; sy++) {
+                    FillSpan(canvas, top + gy * scale + sy, x + gx * scale, x + gx * scale + scale - 1, color);
+                }
+            }
+        }
+    }
+}
+
+// --- Frame passes, matching graphics.c ---
+
+void RasterDrawTable(Canvas *canvas) {
+    RasterRectangle(canvas, RAIL_WIDTH, RAIL_WIDTH, TABLE_WIDTH - 2*RAIL_WIDTH, TABLE_HEIGHT - 2*RAIL_WIDTH, GREEN);
+    RasterRectangle(canvas, 0, 0, TABLE_WIDTH, RAIL_WIDTH, BROWN);
+    RasterRectangle(canvas, 0, TABLE_HEIGHT - RAIL_WIDTH, TABLE_WIDTH, RAIL_WIDTH, BROWN);
+    RasterRectangle(canvas, 0, 0, RAIL_WIDTH, TABLE_HEIGHT, BROWN);
+    RasterRectangle(canvas, TABLE_WIDTH - RAIL_WIDTH, 0, RAIL_WIDTH, TABLE_HEIGHT, BROWN);
+}
+
+void RasterDrawPockets(Canvas *canvas) {
+    Vector2 pockets[6];
+    GetPocketPositions(pockets);
+    for (int i = 0; i < 6; i++) RasterCircle(canvas, pockets[i], POCKET_RADIUS, BLACK);
+
+    const TableGeometry *table = GetTableGeometry();
+    for (int i = 0; i < table->cushionCount; i++) {
+        const Cushion *c = &table->cushions[i];
+        RasterLine(canvas, c->a, c->b, 2.0f + 2.0f * c->radius, DARKGREEN);
+    }
+}
+
+void RasterDrawBalls(Canvas *canvas, const Game *game) {
+    for (int i = 0; i < MAX_BALLS; i++) {
+        const Ball *b = &game->balls[i];
+        if (b->pocketed) continue;
+
+        RasterCircle(canvas, b->position, BALL_RADIUS, b->color);
+
+        if (b->isStriped) {
+            RasterRectangle(canvas, b->position.x - BALL_RADIUS*0.9f, b->position.y - BALL_RADIUS*0.28f,
+                            BALL_RADIUS*1.8f, BALL_RADIUS*0.56f, WHITE);
+            RasterCircle(canvas, b->position, BALL_RADIUS - 1, b->color);
+        }
+
+        if (b->type == BALL_CUE) {
+            RasterCircle(canvas, b->position, 4, LIGHTGRAY);
+        } else {
+            char numStr[4];
+            sprintf(numStr, "%d", b->number);
+            int x = (int)(b->position.x - RasterMeasureNumber(numStr, 12) / 2.0f);
+            RasterNumber(canvas, numStr, x, (int)(b->position.y - 6), 12, WHITE);
+        }
+    }
+}
+
+void RasterDrawCueStick(Canvas *canvas, const Game *game) {
+    if (game->ballsMoving) return;
+    if (game->state != GAME_START && game->state != GAME_PLAYING) return;
+
+    Vector2 cueBallPos = game->balls[0].pocketed ? game->cueBallPos : game->balls[0].position;
+    Vector2 dir = { game->mousePos.x - cueBallPos.x, game->mousePos.y - cueBallPos.y };
+    float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
+    if (len > 0.0001f) { dir.x /= len; dir.y /= len; }
+
+    float effectiveLength = game->stickLength + game->stickPullPixels;
+    Vector2 stickTip  = { cueBallPos.x - dir.x * (BALL_RADIUS + effectiveLength),
+                          cueBallPos.y - dir.y * (BALL_RADIUS + effectiveLength) };
+    Vector2 stickBase = { cueBallPos.x - dir.x * (BALL_RADIUS + 4),
+                          cueBallPos.y - dir.y * (BALL_RADIUS + 4) };
+
+    RasterLine(canvas, stickTip, stickBase, 8.0f, (Color){100, 60, 20, 255});
+    RasterLine(canvas, stickTip, stickBase, 6.0f, BROWN);
+    RasterCircle(canvas, (Vector2){ stickTip.x + dir.x*6, stickTip.y + dir.y*6 }, 4, LIGHTGRAY);
+
+    if (game->aiming) {
+        Vector2 lineEnd = { cueBallPos.x + dir.x * 420, cueBallPos.y + dir.y * 420 };
+        RasterLine(canvas, cueBallPos, lineEnd, 1.5f, (Color){ 255, 255, 255, (unsigned char)(255 * 0.22f) });
+    }
+}
+
+void RasterDrawFrame(Canvas *canvas, const Game *game) {
+    RasterClear(canvas, (Color){8, 80, 23, 255});
+    RasterDrawTable(canvas);
+    RasterDrawPockets(canvas);
+    RasterDrawBalls(canvas, game);
+    RasterDrawCueStick(canvas, game);
+}
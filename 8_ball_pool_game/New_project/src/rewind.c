@@ -0,0 +1,402 @@
+#include "rewind.h"
+#include "utils.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Only the part of Game before the event ring is recorded; the ring is
+// scratch space that is empty between steps.
+#define STATE_BYTES offsetof(Game, events)
+#define STATE_WORDS (STATE_BYTES / 4)
+#define MAX_RECORD (STATE_WORDS * 6 + 16)
+
+#define RECORD_KEY   'K'
+#define RECORD_DELTA 'D'
+
+typedef struct {
+    int shotNumber;
+    int firstBlock;
+    int lastBlock;
+    int blockCount;
+    size_t length;              // bytes written
+    int frames;                 // frame 0 is the checkpoint before the shot
+    int keyCount;
+    int keyFrame[REWIND_MAX_KEYS];
+    size_t keyOffset[REWIND_MAX_KEYS];
+} RewindShot;
+
+typedef struct {
+    int block;
+    size_t offset;
+} Cursor;
+
+static struct {
+    unsigned char *blocks;
+    int *next;                  // block chain, -1 ends a shot
+    int blockCount;
+    int freeList;
+    int freeCount;
+    size_t budget;
+
+    RewindShot shots[REWIND_MAX_SHOTS];
+    int first;                  // oldest shot
+    int count;
+    bool recording;             // newest shot is still being written
+
+    Game prev;                  // last recorded frame
+    bool havePrev;
+    Game restore;               // decode target
+    int lastShotNumber;
+
+    int scrubShot;              // shot index while scrubbing
+    size_t scrubEnd;            // end of the frame on screen
+
+    unsigned char scratch[MAX_RECORD];
+    long long evictedShots;
+    double lastRestoreMicros;
+} rw;
+
+// --- Blocks ---
+
+static RewindShot *ShotAt(int k) {
+    return &rw.shots[(rw.first + k) % REWIND_MAX_SHOTS];
+}
+
+static void FreeChain(int block) {
+    while (block >= 0) {
+        int after = rw.next[block];
+        rw.next[block] = rw.freeList;
+        rw.freeList = block;
+        rw.freeCount++;
+        block = after;
+    }
+}
+
+static void DropOldestShot(void) {
+    FreeChain(ShotAt(0)->firstBlock);
+    rw.first = (rw.first + 1) % REWIND_MAX_SHOTS;
+    rw.count--;
+    rw.evictedShots++;
+}
+
+static void DropShotsFrom(int k) {
+    while (rw.count > k) {
+        FreeChain(ShotAt(rw.count - 1)->firstBlock);
+        rw.count--;
+    }
+}
+
+// Makes room for size more bytes in s, evicting older shots as needed. The
+// space is reserved before anything is written, so a record is never torn.
+static bool Reserve(RewindShot *s, size_t size) {
+    while (s->blockCount * (size_t)REWIND_BLOCK_SIZE - s->length < size) {
+        while (rw.freeCount == 0) {
+            if (rw.count == 0 || ShotAt(0) == s) return false;
+            DropOldestShot();
+        }
+        int block = rw.freeList;
+        rw.freeList = rw.next[block];
+        rw.freeCount--;
+        rw.next[block] = -1;
+
+        if (s->lastBlock >= 0) rw.next[s->lastBlock] = block;
+        else s->firstBlock = block;
+        s->lastBlock = block;
+        s->blockCount++;
+    }
+    return true;
+}
+
+static void CursorSeek(Cursor *c, const RewindShot *s, size_t offset) {
+    c->block = s->firstBlock;
+    for (size_t k = offset / REWIND_BLOCK_SIZE; k > 0; k--) c->block = rw.next[c->block];
+    c->offset = offset;
+}
+
+static unsigned char CursorByte(Cursor *c) {
+    unsigned char b = rw.blocks[(size_t)c->block * REWIND_BLOCK_SIZE + c->offset % REWIND_BLOCK_SIZE];
+    c->offset++;
+    if (c->offset % REWIND_BLOCK_SIZE == 0) c->block = rw.next[c->block];
+    return b;
+}
+
+static bool Append(RewindShot *s, const unsigned char *data, size_t size) {
+    if (!Reserve(s, size)) return false;
+    Cursor c;
+    CursorSeek(&c, s, s->length);
+    for (size_t i = 0; i < size; i++) {
+        rw.blocks[(size_t)c.block * REWIND_BLOCK_SIZE + c.offset % REWIND_BLOCK_SIZE] = data[i];
+        c.offset++;
+        if (c.offset % REWIND_BLOCK_SIZE == 0) c.block = rw.next[c.block];
+    }
+    s->length += size;
+    return true;
+}
+
+// --- Records ---
+
+static uint32_t Word(const Game *g, size_t w) {
+    uint32_t x;
+    memcpy(&x, (const unsigned char *)g + w * 4, 4);
+    return x;
+}
+
+// Changed words as (zero words skipped, byte mask, non-zero bytes); a zero
+// mask ends the record. Ball positions and velocities usually differ only in
+// their low mantissa bytes from one frame to the next.
+static size_t EncodeRecord(unsigned char *out, const Game *ref, const Game *cur) {
+    size_t n = 0;
+    out[n++] = ref ? RECORD_DELTA : RECORD_KEY;
+    unsigned int skip = 0;
+    for (size_t w = 0; w < STATE_WORDS; w++) {
+        uint32_t x = Word(cur, w) ^ (ref ? Word(ref, w) : 0);
+        if (x == 0) {
+            skip++;
+            continue;
+        }
+        while (skip >= 0x80) {
+            out[n++] = (unsigned char)(skip | 0x80);
+            skip >>= 7;
+        }
+        out[n++] = (unsigned char)skip;
+        skip = 0;
+
+        unsigned char mask = 0;
+        for (int b = 0; b < 4; b++) {
+            if ((x >> (8 * b)) & 0xff) mask |= (unsigned char)(1 << b);
+        }
+        out[n++] = mask;
+        for (int b = 0; b < 4; b++) {
+            if (mask & (1 << b)) out[n++] = (unsigned char)(x >> (8 * b));
+        }
+    }
+    out[n++] = 0;
+    out[n++] = 0;
+    return n;
+}
+
+static void DecodeRecord(Cursor *c, Game *state) {
+    unsigned char *bytes = (unsigned char *)state;
+    if (CursorByte(c) == RECORD_KEY) memset(bytes, 0, STATE_BYTES);
+
+    size_t w = 0;
+    for (;;) {
+        unsigned int skip = 0;
+        int shift = 0;
+        unsigned char b;
+        do {
+            b = CursorByte(c);
+            skip |= (unsigned int)(b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        unsigned char mask = CursorByte(c);
+        if (mask == 0) break;
+
+        w += skip;
+        for (int k = 0; k < 4; k++) {
+            if (mask & (1 << k)) bytes[w * 4 + (size_t)k] ^= CursorByte(c);
+        }
+        w++;
+    }
+}
+
+static bool AppendFrame(RewindShot *s, const Game *game) {
+    bool key = s->frames % REWIND_KEYFRAME_INTERVAL == 0;
+    size_t size = EncodeRecord(rw.scratch, key ? NULL : &rw.prev, game);
+    size_t offset = s->length;
+    if (!Append(s, rw.scratch, size)) return false;
+
+    if (key && s->keyCount < REWIND_MAX_KEYS) {
+        s->keyFrame[s->keyCount] = s->frames;
+        s->keyOffset[s->keyCount] = offset;
+        s->keyCount++;
+    }
+    s->frames++;
+    return true;
+}
+
+// Rebuilds frame f of shot s into game, leaving the cursor after it
+static void RestoreFrame(const RewindShot *s, int f, Game *game, Cursor *c) {
+    double start = NowSeconds();
+    int key = 0;
+    while (key + 1 < s->keyCount && s->keyFrame[key + 1] <= f) key++;
+
+    CursorSeek(c, s, s->keyOffset[key]);
+    for (int frame = s->keyFrame[key]; frame <= f; frame++) DecodeRecord(c, &rw.restore);
+
+    memcpy(game, &rw.restore, STATE_BYTES);
+    memset(&game->events, 0, sizeof(game->events));
+    rw.lastRestoreMicros = (NowSeconds() - start) * 1e6;
+}
+
+// Cuts shot s after the frame ending at `end`, returning its later blocks
+static void Truncate(RewindShot *s, int frames, size_t end) {
+    s->length = end;
+    s->frames = frames;
+    while (s->keyCount > 0 && s->keyFrame[s->keyCount - 1] >= frames) s->keyCount--;
+
+    int keep = (int)((end + REWIND_BLOCK_SIZE - 1) / REWIND_BLOCK_SIZE);
+    if (keep == 0) {
+        FreeChain(s->firstBlock);
+        s->firstBlock = s->lastBlock = -1;
+        s->blockCount = 0;
+        return;
+    }
+    int block = s->firstBlock;
+    for (int k = 1; k < keep; k++) block = rw.next[block];
+    FreeChain(rw.next[block]);
+    rw.next[block] = -1;
+    s->lastBlock = block;
+    s->blockCount = keep;
+}
+
+// --- Public ---
+
+bool RewindInit(size_t budgetBytes) {
+    RewindShutdown();
+    size_t perBlock = REWIND_BLOCK_SIZE + sizeof(int);
+    if (budgetBytes <= sizeof(rw) + perBlock) return false;
+
+    // The shot table and scratch space count against the budget too
+    int count = (int)((budgetBytes - sizeof(rw)) / perBlock);
+    rw.blocks = malloc((size_t)count * REWIND_BLOCK_SIZE);
+    rw.next = malloc(sizeof(int) * (size_t)count);
+    if (!rw.blocks || !rw.next) {
+        RewindShutdown();
+        return false;
+    }
+    rw.blockCount = count;
+    rw.budget = budgetBytes;
+    rw.freeList = -1;
+    rw.freeCount = 0;
+    for (int b = count - 1; b >= 0; b--) {
+        rw.next[b] = rw.freeList;
+        rw.freeList = b;
+        rw.freeCount++;
+    }
+    rw.lastShotNumber = -1;
+    return true;
+}
+
+void RewindShutdown(void) {
+    free(rw.blocks);
+    free(rw.next);
+    memset(&rw, 0, sizeof(rw));
+}
+
+// The given frame becomes the base for the next delta (also after jumping back)
+static void ContinueFrom(const Game *game, bool recording) {
+    memcpy(&rw.prev, game, STATE_BYTES);
+    rw.havePrev = true;
+    rw.lastShotNumber = game->shotNumber;
+    rw.recording = recording;
+}
+
+void RewindRecord(const Game *game) {
+    if (!rw.blocks || game->headless || game->scrubbing) return;
+    if (!rw.havePrev) ContinueFrom(game, false);
+
+    bool moving = game->shotPending || game->ballsMoving;
+    if (moving && game->shotNumber != rw.lastShotNumber) {
+        // New shot: the previous frame is the table just before it was struck
+        if (rw.count == REWIND_MAX_SHOTS) DropOldestShot();
+        RewindShot *s = ShotAt(rw.count++);
+        memset(s, 0, sizeof(*s));
+        s->shotNumber = game->shotNumber;
+        s->firstBlock = s->lastBlock = -1;
+        rw.recording = AppendFrame(s, &rw.prev);
+        if (!rw.recording) DropShotsFrom(rw.count - 1);
+    }
+
+    if (rw.recording) {
+        if (!AppendFrame(ShotAt(rw.count - 1), game)) rw.recording = false;
+        if (!moving) rw.recording = false;
+    }
+
+    memcpy(&rw.prev, game, STATE_BYTES);
+    rw.havePrev = true;
+    rw.lastShotNumber = game->shotNumber;
+}
+
+static void ClearAim(Game *game) {
+    game->aiming = false;
+    game->stickPullPixels = 0.0f;
+    game->power = 0.0f;
+    game->stickRecoil = false;
+}
+
+bool RewindUndo(Game *game) {
+    if (rw.count == 0) return false;
+
+    // Undo while paused on a frame goes to the start of the shot being viewed
+    int k = game->scrubbing ? rw.scrubShot : rw.count - 1;
+    Cursor c;
+    RestoreFrame(ShotAt(k), 0, game, &c);
+    DropShotsFrom(k);
+
+    ClearAim(game);
+    game->scrubbing = false;
+    sprintf(game->statusMessage, "Shot undone. %s's turn", game->players[game->currentPlayer].name);
+    ContinueFrom(game, false);
+    return true;
+}
+
+bool RewindScrub(Game *game, int frames) {
+    if (rw.count == 0) return false;
+
+    if (!game->scrubbing) {
+        rw.scrubShot = rw.count - 1;
+        game->scrubFrame = ShotAt(rw.scrubShot)->frames - 1;
+    }
+    const RewindShot *s = ShotAt(rw.scrubShot);
+    int f = game->scrubFrame + frames;
+    if (f < 0) f = 0;
+    if (f > s->frames - 1) f = s->frames - 1;
+
+    Cursor c;
+    RestoreFrame(s, f, game, &c);
+    rw.scrubEnd = c.offset;
+    game->scrubbing = true;
+    game->scrubFrame = f;
+    game->scrubFrames = s->frames;
+    return true;
+}
+
+bool RewindResume(Game *game) {
+    if (!game->scrubbing) return false;
+    game->scrubbing = false;
+
+    // Frame 0 is the table before the shot, so resuming there is an undo
+    if (game->scrubFrame == 0) {
+        game->scrubbing = true;
+        return RewindUndo(game);
+    }
+
+    DropShotsFrom(rw.scrubShot + 1);
+    RewindShot *s = ShotAt(rw.scrubShot);
+    Truncate(s, game->scrubFrame + 1, rw.scrubEnd);
+    ContinueFrom(game, game->shotPending || game->ballsMoving);
+    return true;
+}
+
+void RewindGetReport(RewindReport *report) {
+    memset(report, 0, sizeof(*report));
+    report->budget = rw.budget;
+    report->bytesUsed = sizeof(rw) + (size_t)rw.blockCount * sizeof(int) +
+                        (size_t)(rw.blockCount - rw.freeCount) * REWIND_BLOCK_SIZE;
+    report->shots = rw.count;
+    for (int k = 0; k < rw.count; k++) report->frames += ShotAt(k)->frames;
+    report->rawBytes = report->frames * (long long)STATE_BYTES;
+    report->evictedShots = rw.evictedShots;
+    report->lastRestoreMicros = rw.lastRestoreMicros;
+}
+
+void RewindPrintReport(FILE *f) {
+    RewindReport r;
+    RewindGetReport(&r);
+    long long stored = 0;
+    for (int k = 0; k < rw.count; k++) stored += (long long)ShotAt(k)->length;
+    fprintf(f, "rewind: %d shots, %lld frames in %.1f KiB (%.1fx smaller than copies), "
+               "%.1f of %.1f MiB used, %lld shots evicted, last restore %.1f us\n",
+            r.shots, r.frames, stored / 1024.0, stored > 0 ? (double)r.rawBytes / (double)stored : 0.0,
+            r.bytesUsed / 1048576.0, r.budget / 1048576.0, r.evictedShots, r.lastRestoreMicros);
+}
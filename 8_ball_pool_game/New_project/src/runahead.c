@@ -0,0 +1,106 @@
+#include "runahead.h"
+#include "game.h"
+#include "sim.h"
+#include "utils.h"
+
+// Used from HandleInput only, so always on the thread that owns the game
+static struct {
+    bool enabled;
+    bool valid;
+    Game ahead;                     // the speculated shot, RUNAHEAD_FRAMES ticks in
+    unsigned long long baseHash;    // StateHash of the table it was struck from
+    Vector2 cueFrom;                // exact, where the hash quantizes
+    int shotNumber;
+    int playbackSpeed;
+    float angle, speed;
+    RunAheadReport report;
+} ra;
+
+void RunAheadEnable(bool enabled) {
+    memset(&ra, 0, sizeof(ra));
+    ra.enabled = enabled;
+}
+
+void RunAheadSpeculate(const Game *game) {
+    if (!ra.enabled || game->headless) return;
+
+    float angle, speed;
+    if (!GetAim(game, &angle, &speed)) {
+        ra.valid = false;
+        return;
+    }
+    // Holding still: the speculation from an earlier frame still stands
+    if (ra.valid && angle == ra.angle && speed == ra.speed && game->shotNumber == ra.shotNumber &&
+        game->playbackSpeed == ra.playbackSpeed) {
+        return;
+    }
+
+    double start = NowSeconds();
+    Game *g = &ra.ahead;
+    *g = *game;
+    g->headless = true;
+    ReleaseShot(g, angle, speed);
+    for (int f = 0; f < RUNAHEAD_FRAMES; f++) TickGame(g);
+
+    // A shot over this soon gains nothing, and its end has to run live to be recorded
+    ra.valid = g->shotPending;
+    ra.baseHash = StateHash(game);
+    ra.cueFrom = game->balls[0].position;
+    ra.shotNumber = game->shotNumber;
+    ra.playbackSpeed = game->playbackSpeed;
+    ra.angle = angle;
+    ra.speed = speed;
+
+    ra.report.speculations++;
+    ra.report.steps += (long)RUNAHEAD_FRAMES * game->playbackSpeed;
+    ra.report.seconds += NowSeconds() - start;
+}
+
+int RunAheadTake(Game *game, float angle, float shotSpeed) {
+    if (!ra.enabled || game->headless) return 0;
+    RunAheadReport *r = &ra.report;
+    r->releases++;
+
+    bool valid = ra.valid;
+    ra.valid = false;
+    if (!valid || game->shotNumber != ra.shotNumber || game->playbackSpeed != ra.playbackSpeed ||
+        game->balls[0].position.x != ra.cueFrom.x || game->balls[0].position.y != ra.cueFrom.y ||
+        StateHash(game) != ra.baseHash) {
+        r->stale++;
+        return 0;
+    }
+    float angleError = fabsf(remainderf(angle - ra.angle, 2.0f * PI));
+    float speedError = fabsf(shotSpeed - ra.speed);
+    if (angleError > RUNAHEAD_ANGLE_TOLERANCE * (PI / 180.0f) || speedError > RUNAHEAD_SPEED_TOLERANCE * MAX_SHOT_SPEED) {
+        r->misses++;
+        return 0;
+    }
+    if (angleError == 0.0f && speedError == 0.0f) r->hits++;
+    else r->nearHits++;
+
+    // The input side of the table stays live; the rest is the shot in flight
+    Vector2 mouse = game->mousePos;
+    bool placementHelp = game->placementHelp;
+    *game = ra.ahead;
+    game->headless = false;
+    game->mousePos = mouse;
+    game->placementHelp = placementHelp;
+
+    r->framesSaved += RUNAHEAD_FRAMES;
+    return RUNAHEAD_FRAMES;
+}
+
+void RunAheadPrintReport(FILE *out) {
+    const RunAheadReport *r = &ra.report;
+    if (!ra.enabled) return;
+    long adopted = r->hits + r->nearHits;
+    fprintf(out, "run-ahead: %ld releases, %ld adopted (%ld exact, %ld within tolerance), %ld missed, %ld stale; "
+                 "hit rate %.1f%%\n",
+            r->releases, adopted, r->hits, r->nearHits, r->misses, r->stale,
+            r->releases ? 100.0 * adopted / r->releases : 0.0);
+    fprintf(out, "  saved %ld frames (%.1f ms per adopted shot); %ld speculations, %ld steps, %.2f ms on the simulation thread "
+                 "(%.1f us each)\n",
+            r->framesSaved, adopted ? 1000.0 * r->framesSaved / adopted / TARGET_FPS : 0.0,
+            r->speculations, r->steps, r->seconds * 1000.0,
+            r->speculations ? r->seconds * 1e6 / r->speculations : 0.0);
+}
@@ -0,0 +1,231 @@
+#include "script.h"
+#include "utils.h"
+
+typedef enum {
+    SCRIPT_MOVE,
+    SCRIPT_PRESS,
+    SCRIPT_RELEASE,
+    SCRIPT_KEY,
+    SCRIPT_SCRUB
+} ScriptEventType;
+
+typedef enum {
+    SCRIPT_KEY_RESET,
+    SCRIPT_KEY_SPEED,
+    SCRIPT_KEY_SKIP,
+    SCRIPT_KEY_UNDO,
+    SCRIPT_KEY_RESUME,
+    SCRIPT_KEY_HELP,
+    SCRIPT_KEY_COUNT
+} ScriptKey;
+
+static const char *keyNames[SCRIPT_KEY_COUNT] = { "reset", "speed", "skip", "undo", "resume", "help" };
+
+typedef struct {
+    long frame;
+    ScriptEventType type;
+    Vector2 position;
+    int value;              // key or scrub frames
+} ScriptEvent;
+
+typedef struct {
+    ScriptEvent *events;
+    int count;
+    long endFrame;
+    bool loop;
+
+    // Replay position
+    int next;
+    long frame;
+    Vector2 mouse;
+    bool mouseDown;
+} ScriptState;
+
+// --- Playback ---
+
+static bool ParseLine(char *line, ScriptEvent *e, bool *isEnd) {
+    char *comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+
+    char name[16];
+    int used = 0;
+    if (sscanf(line, "%ld %15s %n", &e->frame, name, &used) < 2 || e->frame < 0) return false;
+    const char *args = line + used;
+
+    *isEnd = false;
+    memset(&e->position, 0, sizeof(e->position));
+    e->value = 0;
+    if (strcmp(name, "move") == 0) {
+        e->type = SCRIPT_MOVE;
+        return sscanf(args, "%f %f", &e->position.x, &e->position.y) == 2;
+    }
+    if (strcmp(name, "press") == 0)   { e->type = SCRIPT_PRESS;   return true; }
+    if (strcmp(name, "release") == 0) { e->type = SCRIPT_RELEASE; return true; }
+    if (strcmp(name, "end") == 0)     { *isEnd = true;            return true; }
+    if (strcmp(name, "scrub") == 0) {
+        e->type = SCRIPT_SCRUB;
+        return sscanf(args, "%d", &e->value) == 1;
+    }
+    if (strcmp(name, "key") == 0) {
+        char key[16];
+        if (sscanf(args, "%15s", key) != 1) return false;
+        e->type = SCRIPT_KEY;
+        for (int k = 0; k < SCRIPT_KEY_COUNT; k++) {
+            if (strcmp(key, keyNames[k]) == 0) {
+                e->value = k;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool IsBlank(const char *line) {
+    for (; *line && *line != '#'; line++) {
+        if (*line != ' ' && *line != '\t' && *line != '\r' && *line != '\n') return false;
+    }
+    return true;
+}
+
+static bool ScriptPoll(InputProvider *self, InputFrame *input) {
+    ScriptState *s = self->state;
+    if (s->frame > s->endFrame) {
+        if (!s->loop) return false;
+        s->next = 0;
+        s->frame = 0;
+    }
+
+    memset(input, 0, sizeof(*input));
+    for (; s->next < s->count && s->events[s->next].frame == s->frame; s->next++) {
+        const ScriptEvent *e = &s->events[s->next];
+        switch (e->type) {
+            case SCRIPT_MOVE:    s->mouse = e->position; break;
+            case SCRIPT_PRESS:   input->mousePressed = true;  s->mouseDown = true;  break;
+            case SCRIPT_RELEASE: input->mouseReleased = true; s->mouseDown = false; break;
+            case SCRIPT_SCRUB:   input->scrubFrames += e->value; break;
+            case SCRIPT_KEY:
+                if (e->value == SCRIPT_KEY_RESET)  input->keyReset = true;
+                if (e->value == SCRIPT_KEY_SPEED)  input->keyPlaybackSpeed = true;
+                if (e->value == SCRIPT_KEY_SKIP)   input->keySkipToRest = true;
+                if (e->value == SCRIPT_KEY_UNDO)   input->keyUndo = true;
+                if (e->value == SCRIPT_KEY_RESUME) input->keyResume = true;
+                if (e->value == SCRIPT_KEY_HELP)   input->keyPlacementHelp = true;
+                break;
+        }
+    }
+    input->mouse = s->mouse;
+    input->mouseDown = s->mouseDown;
+    input->time = NowSeconds();
+    s->frame++;
+    return true;
+}
+
+static void ScriptClose(InputProvider *self) {
+    ScriptState *s = self->state;
+    if (!s) return;
+    free(s->events);
+    free(s);
+    self->state = NULL;
+}
+
+bool ScriptInputOpen(InputProvider *provider, const char *path, bool loop) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+
+    ScriptState *s = calloc(1, sizeof(ScriptState));
+    if (!s) {
+        fclose(f);
+        return false;
+    }
+    s->loop = loop;
+    s->endFrame = -1;
+
+    int capacity = 0;
+    int lineNumber = 0;
+    char line[256];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNumber++;
+        if (IsBlank(line)) continue;
+
+        ScriptEvent e;
+        bool isEnd;
+        if (!ParseLine(line, &e, &isEnd)) {
+            fprintf(stderr, "script: %s:%d: cannot parse \"%s\"\n", path, lineNumber, strtok(line, "\r\n"));
+            ok = false;
+            break;
+        }
+        if (e.frame > s->endFrame) s->endFrame = e.frame;
+        if (isEnd) continue;
+
+        // Events replay in file order within a frame, and frames must not go back
+        if (s->count > 0 && e.frame < s->events[s->count - 1].frame) {
+            fprintf(stderr, "script: %s:%d: frame %ld is before the previous event\n", path, lineNumber, e.frame);
+            ok = false;
+            break;
+        }
+        if (s->count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ScriptEvent *grown = realloc(s->events, sizeof(ScriptEvent) * (size_t)capacity);
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            s->events = grown;
+        }
+        s->events[s->count++] = e;
+    }
+    fclose(f);
+
+    if (!ok || s->endFrame < 0) {
+        free(s->events);
+        free(s);
+        return false;
+    }
+
+    provider->poll = ScriptPoll;
+    provider->close = ScriptClose;
+    provider->state = s;
+    return true;
+}
+
+// --- Recording ---
+
+bool ScriptRecorderOpen(ScriptRecorder *recorder, const char *path) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->file = fopen(path, "w");
+    if (!recorder->file) return false;
+    fprintf(recorder->file, "# pool input script: <frame> <event> [args]\n");
+    fprintf(recorder->file, "0 key reset\n");
+    recorder->frame = 1;
+    return true;
+}
+
+// One call per InputFrame handed to the game, in order
+void ScriptRecorderAdd(ScriptRecorder *recorder, const InputFrame *input) {
+    FILE *f = recorder->file;
+    if (!f) return;
+
+    long frame = recorder->frame++;
+    if (!recorder->haveMouse || input->mouse.x != recorder->mouse.x || input->mouse.y != recorder->mouse.y) {
+        fprintf(f, "%ld move %.9g %.9g\n", frame, input->mouse.x, input->mouse.y);
+        recorder->mouse = input->mouse;
+        recorder->haveMouse = true;
+    }
+    if (input->mousePressed)     fprintf(f, "%ld press\n", frame);
+    if (input->mouseReleased)    fprintf(f, "%ld release\n", frame);
+    if (input->keyReset)         fprintf(f, "%ld key reset\n", frame);
+    if (input->keyPlaybackSpeed) fprintf(f, "%ld key speed\n", frame);
+    if (input->keySkipToRest)    fprintf(f, "%ld key skip\n", frame);
+    if (input->keyUndo)          fprintf(f, "%ld key undo\n", frame);
+    if (input->keyResume)        fprintf(f, "%ld key resume\n", frame);
+    if (input->keyPlacementHelp) fprintf(f, "%ld key help\n", frame);
+    if (input->scrubFrames != 0) fprintf(f, "%ld scrub %d\n", frame, input->scrubFrames);
+}
+
+void ScriptRecorderClose(ScriptRecorder *recorder) {
+    if (!recorder->file) return;
+    if (recorder->frame > 0) fprintf(recorder->file, "%ld end\n", recorder->frame - 1);
+    fclose(recorder->file);
+    recorder->file = NULL;
+}
@@ -0,0 +1,142 @@
+#include "sim.h"
+#include "game.h"
+#include "utils.h"
+
+unsigned short PocketedMask(const Game *game) {
+    unsigned short mask = 0;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        if (game->balls[i].pocketed) mask |= (unsigned short)(1u << i);
+    }
+    return mask;
+}
+
+void SimulateShotCoarse(const Game *start, float angle, float speed, int stride, Game *end, ShotOutcome *out) {
+    Game local;
+    Game *g = end ? end : &local;
+    *g = *start;
+    g->headless = true;
+    g->physicsStride = stride;
+
+    TakeShot(g, angle, speed);
+    int steps = FastForwardShot(g, FAST_FORWARD_MAX_STEPS);
+
+    if (out) {
+        out->pocketed = PocketedMask(g) & ~PocketedMask(start);
+        out->scratch = (out->pocketed & 1u) != 0;
+        out->eightPocketed = (out->pocketed & (1u << 8)) != 0;
+        out->stateAfter = g->state;
+        out->nextPlayer = g->currentPlayer;
+        out->steps = steps;
+    }
+    g->physicsStride = start->physicsStride;
+}
+
+void SimulateShot(const Game *start, float angle, float speed, Game *end, ShotOutcome *out) {
+    SimulateShotCoarse(start, angle, speed, 0, end, out);
+}
+
+// --- Self-play ---
+
+void SelfPlayInit(SelfPlay *play, unsigned long long seed, float greedy) {
+    play->rng = seed ? seed : 1;
+    play->greedy = greedy;
+    SelfPlayRestart(play);
+}
+
+void SelfPlayRestart(SelfPlay *play) {
+    InitGame(&play->game);
+    play->game.headless = true;
+}
+
+static void PlaceRandom(SelfPlay *play) {
+    const float margin = RAIL_WIDTH + BALL_RADIUS;
+    for (int tries = 0; tries < 1000; tries++) {
+        Vector2 spot = {
+            margin + RandomFloat(&play->rng) * (TABLE_WIDTH - 2.0f * margin),
+            margin + RandomFloat(&play->rng) * (TABLE_HEIGHT - 2.0f * margin),
+        };
+        if (PlaceCueBall(&play->game, spot)) return;
+    }
+    PlaceCueBall(&play->game, play->game.cueBallPos);
+}
+
+const Game *SelfPlayPosition(SelfPlay *play) {
+    for (;;) {
+        if (play->game.state == GAME_SCRATCH) PlaceRandom(play);
+        if (play->game.state == GAME_START || play->game.state == GAME_PLAYING) return &play->game;
+        SelfPlayRestart(play);
+    }
+}
+
+void SelfPlayShot(SelfPlay *play, float angle, float speed) {
+    if (RandomFloat(&play->rng) >= play->greedy) {
+        angle = RandomFloat(&play->rng) * 2.0f * PI;
+        speed = MAX_SHOT_SPEED * (0.2f + 0.8f * RandomFloat(&play->rng));
+    }
+    Game end;
+    SimulateShot(&play->game, angle, speed, &end, NULL);
+    play->game = end;
+}
+
+static unsigned int HashBytes(unsigned int h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Fingerprint of everything a precomputed table depends on: dimensions,
+// physics constants and the rack. Files built for another spec are rejected.
+unsigned int TableSpecHash(void) {
+    float spec[] = {
+        TABLE_WIDTH, TABLE_HEIGHT, RAIL_WIDTH, BALL_RADIUS, POCKET_RADIUS,
+        FRICTION, MIN_VELOCITY, MAX_BALL_SPEED, MAX_SHOT_SPEED, RAIL_RESTITUTION,
+        CORNER_MOUTH, SIDE_MOUTH, JAW_LENGTH, JAW_NOSE_RADIUS, POCKET_DROP_RADIUS
+    };
+    unsigned int h = HashBytes(2166136261u, spec, sizeof(spec));
+
+    Game rack;
+    InitGame(&rack);
+    for (int i = 0; i < MAX_BALLS; i++) {
+        h = HashBytes(h, &rack.balls[i].position, sizeof(Vector2));
+    }
+    return h;
+}
+
+// splitmix64 finalizer: spreads small, similar inputs over all 64 bits
+static unsigned long long Mix64(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+unsigned long long StateHashBall(int index, const Ball *ball) {
+    if (ball->pocketed) return Mix64(0x706f636b00000000ull | (unsigned)index);
+    long long qx = llroundf(ball->position.x / STATE_QUANT);
+    long long qy = llroundf(ball->position.y / STATE_QUANT);
+    unsigned long long cell = ((unsigned long long)(qx & 0xffffff) << 24) | (unsigned long long)(qy & 0xffffff);
+    return Mix64(cell ^ ((unsigned long long)(index + 1) << 52));
+}
+
+unsigned long long StateHashRules(const Game *game) {
+    unsigned long long rules = (unsigned long long)game->currentPlayer;
+    rules = rules * 8 + (unsigned long long)game->state;
+    rules = rules * 4 + (unsigned long long)game->players[0].type;
+    rules = rules * 4 + (unsigned long long)game->players[1].type;
+    rules = rules * 2 + (game->assignedTypes ? 1u : 0u);
+    rules = rules * 2 + (game->firstShot ? 1u : 0u);
+    rules = rules * 16 + (unsigned long long)(game->players[0].ballsRemaining & 15);
+    rules = rules * 16 + (unsigned long long)(game->players[1].ballsRemaining & 15);
+    return Mix64(rules ^ 0x72756c6573000000ull);
+}
+
+unsigned long long StateHash(const Game *game) {
+    unsigned long long h = StateHashRules(game);
+    for (int i = 0; i < MAX_BALLS; i++) h ^= StateHashBall(i, &game->balls[i]);
+    return h;
+}
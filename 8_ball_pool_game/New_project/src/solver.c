@@ -0,0 +1,249 @@
+#include "solver.h"
+#include "physics.h"
+#include "utils.h"
+#include "jobs.h"
+#include "kernels.h"
+
+#define MAX_PAIRS (MAX_BALLS * (MAX_BALLS - 1) / 2)
+
+static bool failAllocations;
+
+void SolverFailAllocations(bool fail) {
+    failAllocations = fail;
+}
+
+static void *Allocate(size_t size) {
+    return failAllocations ? NULL : malloc(size);
+}
+
+typedef struct {
+    float x;
+    int index;
+} SweepEntry;
+
+static int CompareByX(const void *pa, const void *pb) {
+    const SweepEntry *a = pa;
+    const SweepEntry *b = pb;
+    if (a->x < b->x) return -1;
+    if (a->x > b->x) return 1;
+    return a->index - b->index;
+}
+
+static int ComparePairs(const void *pa, const void *pb) {
+    const Contact *a = pa;
+    const Contact *b = pb;
+    if (a->a != b->a) return a->a - b->a;
+    return a->b - b->b;
+}
+
+// Every pair, one at a time, for any count; the kernels stop at SOLVER_SWEEP_MIN
+static int GatherAllPairs(const Ball *balls, int count, Contact *out, int capacity) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (balls[i].pocketed) continue;
+        for (int j = i + 1; j < count; j++) {
+            if (balls[j].pocketed || !BallsOverlap(&balls[i], &balls[j])) continue;
+            if (n < capacity) out[n] = (Contact){ i, j, 0, 0.0f };
+            n++;
+        }
+    }
+    return n;
+}
+
+// Returns the number of overlapping pairs, which can be larger than capacity;
+// only the first capacity are stored. Pairs come out sorted by (a, b).
+int GatherContacts(const Ball *balls, int count, Contact *out, int capacity) {
+    int n = 0;
+
+    // Every pair for a normal table, several at a time where the CPU allows
+    if (count <= SOLVER_SWEEP_MIN) return GetKernels()->gatherPairs(balls, count, out, capacity);
+
+    // Sort and sweep along x for big tables
+    SweepEntry *order = Allocate(sizeof(SweepEntry) * count);
+    if (!order) return GatherAllPairs(balls, count, out, capacity);   // slower, same pairs
+    int active = 0;
+    for (int i = 0; i < count; i++) {
+        if (!balls[i].pocketed) order[active++] = (SweepEntry){ balls[i].position.x, i };
+    }
+    qsort(order, active, sizeof(SweepEntry), CompareByX);
+
+    for (int s = 0; s < active; s++) {
+        for (int t = s + 1; t < active; t++) {
+            if (order[t].x - order[s].x >= BALL_RADIUS * 2.0f) break;
+            if (!BallsOverlap(&balls[order[s].index], &balls[order[t].index])) continue;
+            int a = order[s].index < order[t].index ? order[s].index : order[t].index;
+            int b = order[s].index < order[t].index ? order[t].index : order[s].index;
+            if (n < capacity) out[n] = (Contact){ a, b, 0, 0.0f };
+            n++;
+        }
+    }
+    free(order);
+
+    qsort(out, n < capacity ? n : capacity, sizeof(Contact), ComparePairs);
+    return n;
+}
+
+// Greedy coloring in contact order: each contact takes the lowest color not
+// yet used by either of its balls. Contacts are then regrouped by color
+// (stable, so each batch keeps the (a, b) order). Contacts that would need more
+// than SOLVER_MAX_COLORS colors share the last batch, which is solved serially.
+// Returns the number of batches; batch k is [batchStart[k], batchStart[k+1]).
+// Without memory for the coloring every contact goes to the overflow batch,
+// in gather order.
+int ColorContacts(Contact *contacts, int n, int ballCount, int *batchStart) {
+    unsigned int smallMasks[MAX_BALLS];
+    Contact smallSorted[MAX_PAIRS];
+    unsigned char smallColors[MAX_PAIRS];
+
+    unsigned int *used = ballCount <= MAX_BALLS ? smallMasks : Allocate(sizeof(unsigned int) * ballCount);
+    Contact *sorted    = n <= MAX_PAIRS ? smallSorted : Allocate(sizeof(Contact) * n);
+    unsigned char *colorOf = n <= MAX_PAIRS ? smallColors : Allocate(n);
+    if (!used || !sorted || !colorOf) {
+        if (used != smallMasks) free(used);
+        if (sorted != smallSorted) free(sorted);
+        if (colorOf != smallColors) free(colorOf);
+        for (int c = 0; c <= SOLVER_MAX_COLORS; c++) batchStart[c] = 0;
+        batchStart[SOLVER_MAX_COLORS + 1] = n;
+        return SOLVER_MAX_COLORS + 1;
+    }
+    memset(used, 0, sizeof(unsigned int) * ballCount);
+
+    int counts[SOLVER_MAX_COLORS + 1] = {0};
+    int batches = 0;
+
+    for (int k = 0; k < n; k++) {
+        unsigned int taken = used[contacts[k].a] | used[contacts[k].b];
+        int c = 0;
+        while (c < SOLVER_MAX_COLORS && (taken & (1u << c))) c++;
+        if (c < SOLVER_MAX_COLORS) {
+            used[contacts[k].a] |= 1u << c;
+            used[contacts[k].b] |= 1u << c;
+        }
+        colorOf[k] = (unsigned char)c;
+        counts[c]++;
+        if (c + 1 > batches) batches = c + 1;
+    }
+
+    batchStart[0] = 0;
+    for (int c = 0; c < batches; c++) batchStart[c + 1] = batchStart[c] + counts[c];
+
+    int fill[SOLVER_MAX_COLORS + 1];
+    memcpy(fill, batchStart, sizeof(int) * (batches + 1));
+    for (int k = 0; k < n; k++) sorted[fill[colorOf[k]]++] = contacts[k];
+    memcpy(contacts, sorted, sizeof(Contact) * n);
+
+    if (used != smallMasks) free(used);
+    if (sorted != smallSorted) free(sorted);
+    if (colorOf != smallColors) free(colorOf);
+    return batches;
+}
+
+static void ResolveContact(Ball *balls, Contact *c) {
+    Ball *a = &balls[c->a];
+    Ball *b = &balls[c->b];
+    c->result = 0;
+
+    // Earlier batches may already have pushed this pair apart
+    float dist = Distance(a->position, b->position);
+    float minDist = BALL_RADIUS * 2.0f;
+    if (dist >= minDist || dist <= 0.0001f) return;
+
+    // Separate overlapping balls
+    float overlap = 0.5f * (minDist - dist + 0.001f);
+    Vector2 normal = {
+        (b->position.x - a->position.x) / dist,
+        (b->position.y - a->position.y) / dist
+    };
+    a->position.x -= normal.x * overlap;
+    a->position.y -= normal.y * overlap;
+    b->position.x += normal.x * overlap;
+    b->position.y += normal.y * overlap;
+
+    // Equal masses: the impulse is the closing speed along the normal
+    float closing = (a->velocity.x - b->velocity.x) * normal.x + (a->velocity.y - b->velocity.y) * normal.y;
+    c->impulse = fabsf(closing);
+
+    ResolveElasticCollision(a, b);
+
+    c->result = SOLVER_RESOLVED;
+    if (ClampBallSpeed(a, MAX_BALL_SPEED)) c->result |= SOLVER_CLAMPED_A;
+    if (ClampBallSpeed(b, MAX_BALL_SPEED)) c->result |= SOLVER_CLAMPED_B;
+}
+
+typedef struct {
+    Ball *balls;
+    Contact *contacts;
+    int first;
+    int count;
+} BatchJob;
+
+static void ResolveChunk(int index, void *ctx) {
+    BatchJob *job = ctx;
+    int begin = job->first + index * SOLVER_CHUNK;
+    int end = begin + SOLVER_CHUNK;
+    if (end > job->first + job->count) end = job->first + job->count;
+    for (int k = begin; k < end; k++) ResolveContact(job->balls, &job->contacts[k]);
+}
+
+void ResolveContactBatches(Ball *balls, Contact *contacts, const int *batchStart, int batches) {
+    for (int c = 0; c < batches; c++) {
+        int first = batchStart[c];
+        int count = batchStart[c + 1] - first;
+
+        // The overflow batch can share balls between contacts
+        bool independent = c < SOLVER_MAX_COLORS;
+
+        if (independent && count >= SOLVER_PARALLEL_MIN && JobsThreadCount() > 1) {
+            BatchJob job = { balls, contacts, first, count };
+            JobsParallelFor((count + SOLVER_CHUNK - 1) / SOLVER_CHUNK, ResolveChunk, &job);
+        } else {
+            for (int k = first; k < first + count; k++) ResolveContact(balls, &contacts[k]);
+        }
+    }
+}
+
+void SolveContacts(Ball *balls, int count, SolverStats *stats, EventRing *events) {
+    Contact small[MAX_PAIRS];
+    Contact *contacts = small;
+    int capacity = MAX_PAIRS;
+
+    int n = GatherContacts(balls, count, contacts, capacity);
+    if (n > capacity) {
+        Contact *all = Allocate(sizeof(Contact) * n);
+        if (all) {
+            contacts = all;
+            capacity = n;
+            n = GatherContacts(balls, count, contacts, capacity);
+        } else {
+            // Solve the pairs that fit; the rest still overlap next step
+            if (stats) stats->dropped += n - capacity;
+            n = capacity;
+        }
+    }
+
+    int batchStart[SOLVER_MAX_COLORS + 2];
+    int batches = ColorContacts(contacts, n, count, batchStart);
+    ResolveContactBatches(balls, contacts, batchStart, batches);
+
+    if (stats) {
+        stats->batches += batches;
+        for (int k = 0; k < n; k++) {
+            if (contacts[k].result & SOLVER_RESOLVED)  stats->contacts++;
+            if (contacts[k].result & SOLVER_CLAMPED_A) stats->speedClamps++;
+            if (contacts[k].result & SOLVER_CLAMPED_B) stats->speedClamps++;
+        }
+    }
+
+    // Contacts come out in gather-and-color order, which is the same for any thread count
+    if (events) {
+        for (int k = 0; k < n; k++) {
+            const Contact *c = &contacts[k];
+            if (!(c->result & SOLVER_RESOLVED)) continue;
+            Vector2 at = { 0.5f * (balls[c->a].position.x + balls[c->b].position.x),
+                           0.5f * (balls[c->a].position.y + balls[c->b].position.y) };
+            EventRingPush(events, EVENT_CONTACT, c->a, c->b, c->impulse, at);
+        }
+    }
+
+    if (contacts != small) free(contacts);
+}
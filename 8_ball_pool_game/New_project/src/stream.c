@@ -0,0 +1,402 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stream.h"
+#include "game.h"
+#include "utils.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+static const char streamMagic[8] = { 'P', 'O', 'O', 'L', 'S', 'T', 'R', 'M' };
+#define STREAM_VERSION 1
+
+// --- Writer ---
+
+static struct {
+    FILE *file;
+    bool isPipe;
+    bool started;
+    long bytes;
+
+    unsigned char buf[512];
+    int len;
+
+    unsigned short x[MAX_BALLS];
+    unsigned short y[MAX_BALLS];
+    unsigned short pocketedMask;
+    int shotNumber;
+    int currentPlayer;
+    GameState state;
+    PlayerType types[2];
+    int remaining[2];
+    char status[100];
+    int idleFrames;
+} writer;
+
+static void PutU8(int v) {
+    writer.buf[writer.len++] = (unsigned char)v;
+}
+
+static void PutU16(int v) {
+    writer.buf[writer.len++] = (unsigned char)(v & 0xFF);
+    writer.buf[writer.len++] = (unsigned char)((v >> 8) & 0xFF);
+}
+
+static unsigned short Quantize(float v) {
+    int q = (int)lroundf(v * STREAM_QUANT);
+    if (q < 0) q = 0;
+    if (q > 0xFFFF) q = 0xFFFF;
+    return (unsigned short)q;
+}
+
+static int NearestPocket(Vector2 pos) {
+    Vector2 pockets[6];
+    GetPocketPositions(pockets);
+    int best = 0;
+    for (int p = 1; p < 6; p++) {
+        if (Distance(pos, pockets[p]) < Distance(pos, pockets[best])) best = p;
+    }
+    return best;
+}
+
+static void PutRules(const Game *game) {
+    PutU8(game->state);
+    PutU8(game->currentPlayer);
+    PutU8(game->players[0].type);
+    PutU8(game->players[1].type);
+    PutU8(game->players[0].ballsRemaining);
+    PutU8(game->players[1].ballsRemaining);
+    PutU8(game->assignedTypes);
+}
+
+static void PutStatus(const Game *game) {
+    int n = (int)strlen(game->statusMessage);
+    if (n > (int)sizeof(game->statusMessage) - 1) n = (int)sizeof(game->statusMessage) - 1;
+    PutU8(n);
+    memcpy(writer.buf + writer.len, game->statusMessage, n);
+    writer.len += n;
+}
+
+static void RememberRules(const Game *game) {
+    writer.currentPlayer = game->currentPlayer;
+    writer.state = game->state;
+    writer.types[0] = game->players[0].type;
+    writer.types[1] = game->players[1].type;
+    writer.remaining[0] = game->players[0].ballsRemaining;
+    writer.remaining[1] = game->players[1].ballsRemaining;
+    memcpy(writer.status, game->statusMessage, sizeof(writer.status));
+}
+
+static void FlushIdle(void) {
+    if (writer.idleFrames == 0) return;
+    PutU8(STREAM_IDLE);
+    PutU8(writer.idleFrames);
+    writer.idleFrames = 0;
+}
+
+static void WriteKeyframe(const Game *game) {
+    FlushIdle();
+    PutU8(STREAM_KEYFRAME);
+    PutU16(game->shotNumber);
+
+    unsigned short mask = 0;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        writer.x[i] = Quantize(game->balls[i].position.x);
+        writer.y[i] = Quantize(game->balls[i].position.y);
+        PutU16(writer.x[i]);
+        PutU16(writer.y[i]);
+        if (game->balls[i].pocketed) mask |= (unsigned short)(1u << i);
+    }
+    PutU16(mask);
+    PutRules(game);
+
+    // The shot that starts here, for renderers that want to draw the stick
+    PutU16((int)lroundf(game->shotStats.shotAngle * 10000.0f) & 0xFFFF);
+    PutU8((int)lroundf(game->shotStats.shotSpeed / MAX_SHOT_SPEED * 255.0f));
+    PutStatus(game);
+
+    writer.pocketedMask = mask;
+    writer.shotNumber = game->shotNumber;
+    RememberRules(game);
+}
+
+bool StreamOpen(const char *target) {
+    if (writer.file) return true;
+
+    writer.isPipe = false;
+    if (strcmp(target, "-") == 0) {
+        writer.file = stdout;
+    } else if (target[0] == '|') {
+        writer.file = popen(target + 1, "w");
+        writer.isPipe = true;
+    } else {
+        writer.file = fopen(target, "wb");
+    }
+    if (!writer.file) {
+        fprintf(stderr, "stream: cannot open %s\n", target);
+        return false;
+    }
+
+    writer.started = false;
+    writer.bytes = 0;
+    writer.idleFrames = 0;
+
+    writer.len = 0;
+    memcpy(writer.buf, streamMagic, sizeof(streamMagic));
+    writer.len = sizeof(streamMagic);
+    PutU8(STREAM_VERSION);
+    PutU16(TABLE_WIDTH);
+    PutU16(TABLE_HEIGHT);
+    PutU8(MAX_BALLS);
+    PutU8(STREAM_QUANT);
+    fwrite(writer.buf, 1, writer.len, writer.file);
+    writer.bytes += writer.len;
+    return true;
+}
+
+void StreamFrame(const Game *game) {
+    if (!writer.file) return;
+    writer.len = 0;
+
+    if (!writer.started || game->shotNumber != writer.shotNumber) {
+        writer.started = true;
+        WriteKeyframe(game);
+    } else {
+        // Events first, so the frame that follows already reflects them
+        unsigned short mask = 0;
+        for (int i = 0; i < MAX_BALLS; i++) {
+            if (game->balls[i].pocketed) mask |= (unsigned short)(1u << i);
+        }
+        unsigned short newlyPocketed = mask & ~writer.pocketedMask;
+        for (int i = 0; i < MAX_BALLS; i++) {
+            if (!(newlyPocketed & (1u << i))) continue;
+            FlushIdle();
+            PutU8(STREAM_POCKET);
+            PutU8(i);
+            PutU8(NearestPocket(game->balls[i].position));
+        }
+
+        if (game->currentPlayer != writer.currentPlayer) {
+            FlushIdle();
+            PutU8(STREAM_TURN);
+            PutU8(game->currentPlayer);
+        }
+        if (game->state != writer.state ||
+            game->players[0].type != writer.types[0] || game->players[1].type != writer.types[1] ||
+            game->players[0].ballsRemaining != writer.remaining[0] ||
+            game->players[1].ballsRemaining != writer.remaining[1]) {
+            FlushIdle();
+            PutU8(STREAM_STATE);
+            PutRules(game);
+        }
+        if (strcmp(game->statusMessage, writer.status) != 0) {
+            FlushIdle();
+            PutU8(STREAM_STATUS);
+            PutStatus(game);
+        }
+        RememberRules(game);
+
+        // Then the frame: positions of the balls whose quantized position
+        // changed, at most 1 + 2 + 2 + MAX_BALLS * 4 = 69 bytes
+        unsigned short changed = mask ^ writer.pocketedMask;
+        unsigned short qx[MAX_BALLS], qy[MAX_BALLS];
+        for (int i = 0; i < MAX_BALLS; i++) {
+            if (game->balls[i].pocketed) continue;
+            qx[i] = Quantize(game->balls[i].position.x);
+            qy[i] = Quantize(game->balls[i].position.y);
+            if (qx[i] != writer.x[i] || qy[i] != writer.y[i]) changed |= (unsigned short)(1u << i);
+        }
+        writer.pocketedMask = mask;
+
+        if (changed == 0) {
+            writer.idleFrames++;
+            if (writer.idleFrames >= STREAM_HEARTBEAT_FRAMES) FlushIdle();
+        } else {
+            FlushIdle();
+            PutU8(STREAM_DELTA);
+            PutU16(changed);
+            PutU16(mask);
+            for (int i = 0; i < MAX_BALLS; i++) {
+                if (!(changed & (1u << i)) || game->balls[i].pocketed) continue;
+                writer.x[i] = qx[i];
+                writer.y[i] = qy[i];
+                PutU16(qx[i]);
+                PutU16(qy[i]);
+            }
+        }
+    }
+
+    if (writer.len > 0) {
+        fwrite(writer.buf, 1, writer.len, writer.file);
+        fflush(writer.file);
+        writer.bytes += writer.len;
+    }
+}
+
+void StreamClose(void) {
+    if (!writer.file) return;
+    writer.len = 0;
+    FlushIdle();
+    if (writer.len > 0) fwrite(writer.buf, 1, writer.len, writer.file);
+
+    if (writer.isPipe) pclose(writer.file);
+    else if (writer.file != stdout) fclose(writer.file);
+    else fflush(stdout);
+    writer.file = NULL;
+}
+
+long StreamBytesWritten(void) {
+    return writer.bytes;
+}
+
+// --- Reader ---
+
+static int GetU8(StreamReader *r) {
+    return fgetc(r->file);
+}
+
+static int GetU16(StreamReader *r) {
+    int lo = fgetc(r->file);
+    int hi = fgetc(r->file);
+    if (lo == EOF || hi == EOF) return -1;
+    return lo | (hi << 8);
+}
+
+static bool GetRules(StreamReader *r) {
+    int v[7];
+    for (int k = 0; k < 7; k++) {
+        v[k] = GetU8(r);
+        if (v[k] == EOF) return false;
+    }
+    r->game.state = (GameState)v[0];
+    r->game.currentPlayer = v[1] & 1;
+    r->game.players[0].type = (PlayerType)v[2];
+    r->game.players[1].type = (PlayerType)v[3];
+    r->game.players[0].ballsRemaining = v[4];
+    r->game.players[1].ballsRemaining = v[5];
+    r->game.assignedTypes = v[6] != 0;
+    return true;
+}
+
+static bool GetStatus(StreamReader *r) {
+    int n = GetU8(r);
+    if (n == EOF || n >= (int)sizeof(r->game.statusMessage)) return false;
+    if (fread(r->game.statusMessage, 1, n, r->file) != (size_t)n) return false;
+    r->game.statusMessage[n] = '\0';
+    return true;
+}
+
+static void SetPocketedMask(StreamReader *r, int mask) {
+    for (int i = 0; i < MAX_BALLS; i++) r->game.balls[i].pocketed = (mask >> i) & 1;
+}
+
+bool StreamReaderOpen(StreamReader *r, const char *source) {
+    memset(r, 0, sizeof(*r));
+    if (strcmp(source, "-") == 0) {
+        r->file = stdin;
+    } else if (source[0] == '|') {
+        r->file = popen(source + 1, "r");
+        r->isPipe = true;
+    } else {
+        r->file = fopen(source, "rb");
+    }
+    if (!r->file) return false;
+
+    char magic[8];
+    if (fread(magic, 1, sizeof(magic), r->file) != sizeof(magic) ||
+        memcmp(magic, streamMagic, sizeof(magic)) != 0 ||
+        GetU8(r) != STREAM_VERSION ||
+        GetU16(r) != TABLE_WIDTH || GetU16(r) != TABLE_HEIGHT ||
+        GetU8(r) != MAX_BALLS || GetU8(r) != STREAM_QUANT) {
+        StreamReaderClose(r);
+        return false;
+    }
+
+    // Ball colors, numbers and names are fixed; only positions and rules are streamed
+    InitGame(&r->game);
+    r->lastPocketedBall = -1;
+    r->lastPocket = -1;
+    return true;
+}
+
+int StreamReadRecord(StreamReader *r, StreamRecord *type) {
+    int t = GetU8(r);
+    if (t == EOF) return -1;
+    if (type) *type = (StreamRecord)t;
+
+    switch (t) {
+        case STREAM_KEYFRAME: {
+            int shot = GetU16(r);
+            for (int i = 0; i < MAX_BALLS; i++) {
+                int x = GetU16(r);
+                int y = GetU16(r);
+                if (x < 0 || y < 0) return -1;
+                r->game.balls[i].position = (Vector2){ (float)x / STREAM_QUANT, (float)y / STREAM_QUANT };
+            }
+            int mask = GetU16(r);
+            if (shot < 0 || mask < 0 || !GetRules(r)) return -1;
+            SetPocketedMask(r, mask);
+
+            int angle = GetU16(r);
+            int power = GetU8(r);
+            if (angle < 0 || power == EOF || !GetStatus(r)) return -1;
+            r->game.shotNumber = shot;
+            r->game.shotStats.shotAngle = (short)angle / 10000.0f;
+            r->game.shotStats.shotSpeed = power / 255.0f * MAX_SHOT_SPEED;
+            r->game.ballsMoving = false;
+            r->frame++;
+            return 1;
+        }
+        case STREAM_DELTA: {
+            int changed = GetU16(r);
+            int mask = GetU16(r);
+            if (changed < 0 || mask < 0) return -1;
+            SetPocketedMask(r, mask);
+            for (int i = 0; i < MAX_BALLS; i++) {
+                if (!((changed >> i) & 1) || ((mask >> i) & 1)) continue;
+                int x = GetU16(r);
+                int y = GetU16(r);
+                if (x < 0 || y < 0) return -1;
+                r->game.balls[i].position = (Vector2){ (float)x / STREAM_QUANT, (float)y / STREAM_QUANT };
+            }
+            r->game.ballsMoving = true;
+            r->frame++;
+            return 1;
+        }
+        case STREAM_IDLE: {
+            int n = GetU8(r);
+            if (n == EOF) return -1;
+            r->game.ballsMoving = false;
+            r->frame += n;
+            return n;
+        }
+        case STREAM_POCKET: {
+            int ball = GetU8(r);
+            int pocket = GetU8(r);
+            if (ball == EOF || pocket == EOF || ball >= MAX_BALLS) return -1;
+            r->game.balls[ball].pocketed = true;
+            r->lastPocketedBall = ball;
+            r->lastPocket = pocket;
+            return 0;
+        }
+        case STREAM_TURN: {
+            int player = GetU8(r);
+            if (player == EOF) return -1;
+            r->game.currentPlayer = player & 1;
+            return 0;
+        }
+        case STREAM_STATE:
+            return GetRules(r) ? 0 : -1;
+        case STREAM_STATUS:
+            return GetStatus(r) ? 0 : -1;
+    }
+    return -1;
+}
+
+void StreamReaderClose(StreamReader *r) {
+    if (!r->file) return;
+    if (r->isPipe) pclose(r->file);
+    else if (r->file != stdin) fclose(r->file);
+    r->file = NULL;
+}
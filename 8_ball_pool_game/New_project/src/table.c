@@ -0,0 +1,405 @@
+#include "table.h"
+#include "utils.h"
+#include <pthread.h>
+
+static TableGeometry defaultTable;
+static pthread_once_t defaultTableOnce = PTHREAD_ONCE_INIT;
+
+static void BuildDefaultTable(void) {
+    BuildTableGeometry(&defaultTable);
+}
+
+const TableGeometry *GetTableGeometry(void) {
+    pthread_once(&defaultTableOnce, BuildDefaultTable);
+    return &defaultTable;
+}
+
+// --- Construction ---
+
+static void AddCushion(TableGeometry *t, float ax, float ay, float bx, float by, float radius) {
+    if (t->cushionCount >= TABLE_MAX_CUSHIONS) return;
+    t->cushions[t->cushionCount++] = (Cushion){ { ax, ay }, { bx, by }, radius };
+}
+
+static void CushionBounds(const Cushion *c, float *minX, float *minY, float *maxX, float *maxY) {
+    *minX = fminf(c->a.x, c->b.x) - c->radius;
+    *minY = fminf(c->a.y, c->b.y) - c->radius;
+    *maxX = fmaxf(c->a.x, c->b.x) + c->radius;
+    *maxY = fmaxf(c->a.y, c->b.y) + c->radius;
+}
+
+// Median split on the longer axis of the cushion midpoints, two cushions per leaf
+static int BuildNode(TableGeometry *t, int first, int count) {
+    int index = t->nodeCount++;
+    BvhNode *node = &t->nodes[index];
+
+    CushionBounds(&t->cushions[first], &node->minX, &node->minY, &node->maxX, &node->maxY);
+    float cMinX = 1e9f, cMinY = 1e9f, cMaxX = -1e9f, cMaxY = -1e9f;
+    for (int i = first; i < first + count; i++) {
+        float x0, y0, x1, y1;
+        CushionBounds(&t->cushions[i], &x0, &y0, &x1, &y1);
+        node->minX = fminf(node->minX, x0);
+        node->minY = fminf(node->minY, y0);
+        node->maxX = fmaxf(node->maxX, x1);
+        node->maxY = fmaxf(node->maxY, y1);
+
+        float mx = 0.5f * (t->cushions[i].a.x + t->cushions[i].b.x);
+        float my = 0.5f * (t->cushions[i].a.y + t->cushions[i].b.y);
+        cMinX = fminf(cMinX, mx); cMaxX = fmaxf(cMaxX, mx);
+        cMinY = fminf(cMinY, my); cMaxY = fmaxf(cMaxY, my);
+    }
+
+    if (count <= 2) {
+        node->first = first;
+        node->count = count;
+        node->right = -1;
+        return index;
+    }
+
+    // Insertion sort by midpoint along the split axis; the table has a few dozen cushions at most
+    bool splitX = (cMaxX - cMinX) >= (cMaxY - cMinY);
+    for (int i = first + 1; i < first + count; i++) {
+        Cushion c = t->cushions[i];
+        float key = splitX ? c.a.x + c.b.x : c.a.y + c.b.y;
+        int j = i - 1;
+        while (j >= first) {
+            float other = splitX ? t->cushions[j].a.x + t->cushions[j].b.x
+                                 : t->cushions[j].a.y + t->cushions[j].b.y;
+            if (other <= key) break;
+            t->cushions[j + 1] = t->cushions[j];
+            j--;
+        }
+        t->cushions[j + 1] = c;
+    }
+
+    int half = count / 2;
+    node->count = 0;
+    node->first = -1;
+    BuildNode(t, first, half);
+    int right = BuildNode(t, first + half, count - half);
+    t->nodes[index].right = right;
+    return index;
+}
+
+void BuildTableGeometry(TableGeometry *t) {
+    memset(t, 0, sizeof(*t));
+    GetPocketPositions(t->pockets);
+
+    float l = RAIL_WIDTH, r = TABLE_WIDTH - RAIL_WIDTH;
+    float top = RAIL_WIDTH, bottom = TABLE_HEIGHT - RAIL_WIDTH;
+    float mid = TABLE_WIDTH * 0.5f;
+    float cm = CORNER_MOUTH, sm = SIDE_MOUTH, jaw = JAW_LENGTH;
+    float diag = jaw * 0.70710678f;
+
+    t->fieldMinX = l;  t->fieldMaxX = r;
+    t->fieldMinY = top; t->fieldMaxY = bottom;
+    float inset = BALL_RADIUS + JAW_NOSE_RADIUS + 0.5f;
+    t->safeMinX = l + inset;  t->safeMaxX = r - inset;
+    t->safeMinY = top + inset; t->safeMaxY = bottom - inset;
+
+    // Run extents keep a ball's full radius off the jaw noses at both ends
+    float clear = BALL_RADIUS + JAW_NOSE_RADIUS + 0.5f;
+    t->runs[0] = (RailRun){ 0, l + cm + clear,   mid - sm - clear };
+    t->runs[1] = (RailRun){ 0, mid + sm + clear, r - cm - clear };
+    t->runs[2] = (RailRun){ 1, l + cm + clear,   mid - sm - clear };
+    t->runs[3] = (RailRun){ 1, mid + sm + clear, r - cm - clear };
+    t->runs[4] = (RailRun){ 2, top + cm + clear, bottom - cm - clear };
+    t->runs[5] = (RailRun){ 3, top + cm + clear, bottom - cm - clear };
+
+    // Cushion noses: six straight runs between the pocket mouths
+    AddCushion(t, l + cm,  top,    mid - sm, top,    0.0f);
+    AddCushion(t, mid + sm, top,   r - cm,   top,    0.0f);
+    AddCushion(t, l + cm,  bottom, mid - sm, bottom, 0.0f);
+    AddCushion(t, mid + sm, bottom, r - cm,  bottom, 0.0f);
+    AddCushion(t, l, top + cm,    l, bottom - cm, 0.0f);
+    AddCushion(t, r, top + cm,    r, bottom - cm, 0.0f);
+
+    // Corner jaws run at 45 degrees from each cushion end into the rail
+    AddCushion(t, l + cm, top, l + cm - diag, top - diag, JAW_NOSE_RADIUS);
+    AddCushion(t, l, top + cm, l - diag, top + cm - diag, JAW_NOSE_RADIUS);
+    AddCushion(t, r - cm, top, r - cm + diag, top - diag, JAW_NOSE_RADIUS);
+    AddCushion(t, r, top + cm, r + diag, top + cm - diag, JAW_NOSE_RADIUS);
+    AddCushion(t, l + cm, bottom, l + cm - diag, bottom + diag, JAW_NOSE_RADIUS);
+    AddCushion(t, l, bottom - cm, l - diag, bottom - cm + diag, JAW_NOSE_RADIUS);
+    AddCushion(t, r - cm, bottom, r - cm + diag, bottom + diag, JAW_NOSE_RADIUS);
+    AddCushion(t, r, bottom - cm, r + diag, bottom - cm + diag, JAW_NOSE_RADIUS);
+
+    // Side jaws narrow slightly into the throat
+    AddCushion(t, mid - sm, top, mid - sm + 3.0f, top - jaw, JAW_NOSE_RADIUS);
+    AddCushion(t, mid + sm, top, mid + sm - 3.0f, top - jaw, JAW_NOSE_RADIUS);
+    AddCushion(t, mid - sm, bottom, mid - sm + 3.0f, bottom + jaw, JAW_NOSE_RADIUS);
+    AddCushion(t, mid + sm, bottom, mid + sm - 3.0f, bottom + jaw, JAW_NOSE_RADIUS);
+
+    t->nodeCount = 0;
+    BuildNode(t, 0, t->cushionCount);
+}
+
+// --- Queries ---
+
+static Vector2 ClosestPoint(const Cushion *c, Vector2 p) {
+    float ux = c->b.x - c->a.x, uy = c->b.y - c->a.y;
+    float len2 = ux*ux + uy*uy;
+    float s = len2 > 0.0f ? ((p.x - c->a.x) * ux + (p.y - c->a.y) * uy) / len2 : 0.0f;
+    if (s < 0.0f) s = 0.0f;
+    if (s > 1.0f) s = 1.0f;
+    return (Vector2){ c->a.x + ux * s, c->a.y + uy * s };
+}
+
+// Earliest time in [0, 1] at which a circle of radius r moving from p by d touches a point
+static bool SweepPoint(Vector2 p, Vector2 d, Vector2 c, float r, float *t) {
+    float fx = p.x - c.x, fy = p.y - c.y;
+    float a = d.x*d.x + d.y*d.y;
+    float b = 2.0f * (fx*d.x + fy*d.y);
+    float k = fx*fx + fy*fy - r*r;
+    if (a < 1e-12f || b >= 0.0f) return false;
+    float disc = b*b - 4.0f*a*k;
+    if (disc < 0.0f) return false;
+    float hit = (-b - sqrtf(disc)) / (2.0f * a);
+    if (hit < 0.0f || hit > 1.0f) return false;
+    *t = hit;
+    return true;
+}
+
+// Earliest touch of a moving ball against one capsule; n is the contact normal
+static bool SweepCushion(const Cushion *c, Vector2 p, Vector2 d, float *t, Vector2 *n) {
+    float r = BALL_RADIUS + c->radius;
+
+    // Already touching: only a hit if moving further in
+    Vector2 q = ClosestPoint(c, p);
+    float dist = Distance(p, q);
+    if (dist < r - 0.001f) {
+        if (dist < 0.0001f) return false;
+        Vector2 m = { (p.x - q.x) / dist, (p.y - q.y) / dist };
+        if (m.x*d.x + m.y*d.y >= 0.0f) return false;
+        *t = 0.0f;
+        *n = m;
+        return true;
+    }
+
+    bool found = false;
+    float best = 2.0f;
+    Vector2 bestN = { 0, 0 };
+
+    // Flat side of the capsule
+    float ux = c->b.x - c->a.x, uy = c->b.y - c->a.y;
+    float len = sqrtf(ux*ux + uy*uy);
+    if (len > 0.0001f) {
+        ux /= len; uy /= len;
+        Vector2 m = { -uy, ux };
+        float s0 = (p.x - c->a.x) * m.x + (p.y - c->a.y) * m.y;
+        if (s0 < 0.0f) { m.x = -m.x; m.y = -m.y; s0 = -s0; }
+        float approach = d.x*m.x + d.y*m.y;
+        if (approach < 0.0f) {
+            float hit = (s0 - r) / -approach;
+            if (hit >= 0.0f && hit <= 1.0f) {
+                float proj = (p.x + d.x*hit - c->a.x) * ux + (p.y + d.y*hit - c->a.y) * uy;
+                if (proj >= 0.0f && proj <= len) {
+                    best = hit;
+                    bestN = m;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    // Rounded ends
+    Vector2 ends[2] = { c->a, c->b };
+    for (int e = 0; e < 2; e++) {
+        float hit;
+        if (SweepPoint(p, d, ends[e], r, &hit) && hit < best) {
+            Vector2 at = { p.x + d.x*hit, p.y + d.y*hit };
+            best = hit;
+            bestN = (Vector2){ (at.x - ends[e].x) / r, (at.y - ends[e].y) / r };
+            found = true;
+        }
+    }
+
+    if (found) {
+        *t = best;
+        *n = bestN;
+    }
+    return found;
+}
+
+// Collects the cushions whose bounds overlap the box; returns how many were written
+static int QueryBox(const TableGeometry *t, float minX, float minY, float maxX, float maxY,
+                    const Cushion **out, int capacity) {
+    int stack[32];
+    int top = 0;
+    int found = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const BvhNode *node = &t->nodes[stack[--top]];
+        if (node->maxX < minX || node->minX > maxX || node->maxY < minY || node->minY > maxY) continue;
+        if (node->count > 0) {
+            for (int i = node->first; i < node->first + node->count && found < capacity; i++) {
+                out[found++] = &t->cushions[i];
+            }
+        } else {
+            int self = (int)(node - t->nodes);
+            stack[top++] = node->right;
+            stack[top++] = self + 1;
+        }
+    }
+    return found;
+}
+
+// Moves a ball by its velocity for one step, bouncing off any cushion it
+// sweeps into. Returns the number of cushion hits.
+// Moves that cross exactly one side of the safe rect, within a straight run,
+// can only touch that run's line: reflect against the plane directly.
+static bool SweepFlatRail(const TableGeometry *t, Ball *ball, Vector2 end, float restitution, int *hits) {
+    Vector2 p = ball->position;
+    float minX = fminf(p.x, end.x), maxX = fmaxf(p.x, end.x);
+    float minY = fminf(p.y, end.y), maxY = fmaxf(p.y, end.y);
+
+    int side = -1, crossed = 0;
+    if (minY <= t->safeMinY) { side = 0; crossed++; }
+    if (maxY >= t->safeMaxY) { side = 1; crossed++; }
+    if (minX <= t->safeMinX) { side = 2; crossed++; }
+    if (maxX >= t->safeMaxX) { side = 3; crossed++; }
+    if (crossed != 1) return false;
+
+    bool horizontal = side < 2;
+    float lo = horizontal ? minX : minY;
+    float hi = horizontal ? maxX : maxY;
+    bool inRun = false;
+    for (int i = 0; i < 6; i++) {
+        if (t->runs[i].side == side && lo >= t->runs[i].lo && hi <= t->runs[i].hi) {
+            inRun = true;
+            break;
+        }
+    }
+    if (!inRun) return false;
+
+    // Signed distance from the contact line (centre one radius off the cushion), positive inside
+    float limit, from, to, sign;
+    switch (side) {
+        case 0:  limit = t->fieldMinY + BALL_RADIUS; from = p.y; to = end.y; sign = 1.0f;  break;
+        case 1:  limit = t->fieldMaxY - BALL_RADIUS; from = p.y; to = end.y; sign = -1.0f; break;
+        case 2:  limit = t->fieldMinX + BALL_RADIUS; from = p.x; to = end.x; sign = 1.0f;  break;
+        default: limit = t->fieldMaxX - BALL_RADIUS; from = p.x; to = end.x; sign = -1.0f; break;
+    }
+    float d0 = (from - limit) * sign;
+    float d1 = (to - limit) * sign;
+
+    Vector2 v = ball->velocity;
+    if (d1 >= 0.0f) {
+        ball->position = end;
+        if (d0 < 0.0f) {
+            // Started inside the cushion but moving out: just push back to the line
+            if (horizontal) ball->position.y = fmaxf(ball->position.y * sign, limit * sign) * sign;
+            else ball->position.x = fmaxf(ball->position.x * sign, limit * sign) * sign;
+        }
+        return true;
+    }
+
+    float f = d0 > 0.0f ? d0 / (d0 - d1) : 0.0f;
+    float along = horizontal ? v.x : v.y;
+    float normal = (horizontal ? v.y : v.x) * -restitution;
+    float rest = 1.0f - f;
+    float pAlong = (horizontal ? p.x : p.y) + along;
+    float pNormal = limit + normal * rest;
+    if (horizontal) {
+        ball->position = (Vector2){ pAlong, pNormal };
+        ball->velocity = (Vector2){ along, normal };
+    } else {
+        ball->position = (Vector2){ pNormal, pAlong };
+        ball->velocity = (Vector2){ normal, along };
+    }
+    *hits = 1;
+    return true;
+}
+
+int SweepBall(const TableGeometry *t, Ball *ball, float restitution) {
+    Vector2 p = ball->position;
+    Vector2 v = ball->velocity;
+    Vector2 end = { p.x + v.x, p.y + v.y };
+
+    // Common case: the whole move stays clear of every cushion
+    if (p.x > t->safeMinX && p.x < t->safeMaxX && p.y > t->safeMinY && p.y < t->safeMaxY &&
+        end.x > t->safeMinX && end.x < t->safeMaxX && end.y > t->safeMinY && end.y < t->safeMaxY) {
+        ball->position = end;
+        return 0;
+    }
+
+    // Next most common: the move only reaches the straight part of one rail
+    int hits = 0;
+    if (SweepFlatRail(t, ball, end, restitution, &hits)) return hits;
+
+    float reach = BALL_RADIUS + JAW_NOSE_RADIUS + 1.0f;
+    const Cushion *near[TABLE_MAX_CUSHIONS];
+    int count = QueryBox(t, fminf(p.x, end.x) - reach, fminf(p.y, end.y) - reach,
+                         fmaxf(p.x, end.x) + reach, fmaxf(p.y, end.y) + reach, near, TABLE_MAX_CUSHIONS);
+
+    float remaining = 1.0f;
+    for (int bounce = 0; bounce < TABLE_MAX_BOUNCES && remaining > 0.0f; bounce++) {
+        Vector2 d = { v.x * remaining, v.y * remaining };
+        float best = 2.0f;
+        Vector2 n = { 0, 0 };
+        for (int i = 0; i < count; i++) {
+            float hit;
+            Vector2 normal;
+            if (SweepCushion(near[i], p, d, &hit, &normal) && hit < best) {
+                best = hit;
+                n = normal;
+            }
+        }
+
+        if (best > 1.0f) {
+            p.x += d.x;
+            p.y += d.y;
+            break;
+        }
+
+        p.x += d.x * best;
+        p.y += d.y * best;
+        float vn = v.x*n.x + v.y*n.y;
+        v.x -= (1.0f + restitution) * vn * n.x;
+        v.y -= (1.0f + restitution) * vn * n.y;
+        remaining *= 1.0f - best;
+        hits++;
+    }
+
+    // Push out of anything the ball-ball separation or a placement left it inside
+    for (int i = 0; i < count; i++) {
+        float r = BALL_RADIUS + near[i]->radius;
+        Vector2 q = ClosestPoint(near[i], p);
+        float dist = Distance(p, q);
+        if (dist < r && dist > 0.0001f) {
+            p.x = q.x + (p.x - q.x) / dist * r;
+            p.y = q.y + (p.y - q.y) / dist * r;
+        }
+    }
+
+    ball->position = p;
+    ball->velocity = v;
+    return hits;
+}
+
+// Pocket the ball has dropped into, or -1. A ball drops once its centre is
+// well inside a pocket, or once it is past the cushion line (which is only
+// possible through a pocket mouth).
+int PocketAt(const TableGeometry *t, Vector2 position) {
+    bool inField = position.x >= t->fieldMinX && position.x <= t->fieldMaxX &&
+                   position.y >= t->fieldMinY && position.y <= t->fieldMaxY;
+    // Every pocket sits on the top or bottom cushion line, so the middle band is drop-free
+    if (inField && position.y > t->fieldMinY + POCKET_DROP_RADIUS &&
+        position.y < t->fieldMaxY - POCKET_DROP_RADIUS) return -1;
+
+    int nearest = 0;
+    float nearestDistSq = 1e30f;
+    for (int p = 0; p < 6; p++) {
+        float dx = position.x - t->pockets[p].x;
+        float dy = position.y - t->pockets[p].y;
+        float d = dx*dx + dy*dy;
+        if (d < nearestDistSq) {
+            nearest = p;
+            nearestDistSq = d;
+        }
+    }
+
+    if (nearestDistSq < POCKET_DROP_RADIUS * POCKET_DROP_RADIUS || !inField) return nearest;
+    return -1;
+}
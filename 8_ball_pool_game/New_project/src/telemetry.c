@@ -0,0 +1,149 @@
+#include "telemetry.h"
+#include "events.h"
+#include <pthread.h>
+
+// Shot records are handed to a background writer through a small queue so the
+// game loop never waits on the log file. If the writer falls behind, records
+// are dropped and counted rather than blocking the frame.
+
+static struct {
+    FILE *file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    ShotRecord queue[TELEMETRY_QUEUE_SIZE];
+    int head;
+    int count;
+    int dropped;
+    bool running;
+} telemetry;
+
+static const char *StateName(GameState state) {
+    switch (state) {
+        case GAME_START:   return "start";
+        case GAME_PLAYING: return "playing";
+        case GAME_SCRATCH: return "scratch";
+        case GAME_WON:     return "won";
+        case GAME_LOST:    return "lost";
+    }
+    return "unknown";
+}
+
+static void WriteRecord(FILE *f, const ShotRecord *r) {
+    fprintf(f,
+            "{\"shot\":%d,\"player\":%d,\"angle\":%.4f,\"speed\":%.3f,"
+            "\"contacts\":%d,\"railHits\":%d,\"speedClamps\":%d,\"pocketed\":%d,"
+            "\"framesToRest\":%d,\"peakSpeed\":%.3f,\"peakCueSpeed\":%.3f,"
+            "\"state\":\"%s\",\"remaining\":[%d,%d]}\n",
+            r->shotNumber, r->stats.player, r->stats.shotAngle, r->stats.shotSpeed,
+            r->stats.ballContacts, r->stats.railHits, r->stats.speedClamps, r->stats.pocketEvents,
+            r->stats.framesToRest, r->stats.peakSpeed, r->stats.peakCueSpeed,
+            StateName(r->stateAfter), r->ballsRemaining[0], r->ballsRemaining[1]);
+}
+
+static void *WriterThread(void *arg) {
+    (void)arg;
+    ShotRecord batch[TELEMETRY_QUEUE_SIZE];
+
+    pthread_mutex_lock(&telemetry.lock);
+    for (;;) {
+        while (telemetry.count == 0 && telemetry.running) {
+            pthread_cond_wait(&telemetry.wake, &telemetry.lock);
+        }
+        if (telemetry.count == 0 && !telemetry.running) break;
+
+        // Copy the pending records out, then do the I/O without holding the lock
+        int n = telemetry.count;
+        for (int i = 0; i < n; i++) {
+            batch[i] = telemetry.queue[(telemetry.head + i) % TELEMETRY_QUEUE_SIZE];
+        }
+        telemetry.head = (telemetry.head + n) % TELEMETRY_QUEUE_SIZE;
+        telemetry.count = 0;
+        pthread_mutex_unlock(&telemetry.lock);
+
+        for (int i = 0; i < n; i++) WriteRecord(telemetry.file, &batch[i]);
+        fflush(telemetry.file);
+
+        pthread_mutex_lock(&telemetry.lock);
+    }
+    pthread_mutex_unlock(&telemetry.lock);
+    return NULL;
+}
+
+bool TelemetryInit(const char *path) {
+    if (telemetry.running) return true;
+
+    telemetry.file = fopen(path, "a");
+    if (!telemetry.file) {
+        fprintf(stderr, "telemetry: cannot open %s\n", path);
+        return false;
+    }
+
+    pthread_mutex_init(&telemetry.lock, NULL);
+    pthread_cond_init(&telemetry.wake, NULL);
+    telemetry.head = 0;
+    telemetry.count = 0;
+    telemetry.dropped = 0;
+    telemetry.running = true;
+
+    if (pthread_create(&telemetry.thread, NULL, WriterThread, NULL) != 0) {
+        telemetry.running = false;
+        fclose(telemetry.file);
+        telemetry.file = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Shot counters come from the physics events rather than from inside the step
+void TelemetryCountEvents(ShotStats *stats, const EventRing *events) {
+    int count = EventRingCount(events);
+    for (int k = 0; k < count; k++) {
+        const PhysicsEvent *e = EventRingAt(events, k);
+        switch (e->type) {
+            case EVENT_CONTACT: stats->ballContacts++; break;
+            case EVENT_RAIL:    stats->railHits += e->b; break;
+            case EVENT_POCKET:  stats->pocketEvents++; break;
+            default: break;
+        }
+    }
+}
+
+void TelemetryRecordShot(const Game *game) {
+    if (!telemetry.running) return;
+
+    ShotRecord r;
+    r.shotNumber = game->shotNumber;
+    r.stateAfter = game->state;
+    r.ballsRemaining[0] = game->players[0].ballsRemaining;
+    r.ballsRemaining[1] = game->players[1].ballsRemaining;
+    r.stats = game->shotStats;
+
+    pthread_mutex_lock(&telemetry.lock);
+    if (telemetry.count < TELEMETRY_QUEUE_SIZE) {
+        telemetry.queue[(telemetry.head + telemetry.count) % TELEMETRY_QUEUE_SIZE] = r;
+        telemetry.count++;
+        pthread_cond_signal(&telemetry.wake);
+    } else {
+        telemetry.dropped++;
+    }
+    pthread_mutex_unlock(&telemetry.lock);
+}
+
+void TelemetryShutdown(void) {
+    if (!telemetry.running) return;
+
+    pthread_mutex_lock(&telemetry.lock);
+    telemetry.running = false;
+    pthread_cond_signal(&telemetry.wake);
+    pthread_mutex_unlock(&telemetry.lock);
+
+    pthread_join(telemetry.thread, NULL);
+    if (telemetry.dropped > 0) {
+        fprintf(stderr, "telemetry: dropped %d shot records\n", telemetry.dropped);
+    }
+    fclose(telemetry.file);
+    telemetry.file = NULL;
+    pthread_mutex_destroy(&telemetry.lock);
+    pthread_cond_destroy(&telemetry.wake);
+}
@@ -1,4 +1,6 @@
+#define _POSIX_C_SOURCE 199309L
 #include "utils.h"
+#include <time.h>
 
 float Distance(Vector2 a, Vector2 b) {
     float dx = a.x - b.x;
@@ -6,14 +8,16 @@ float Distance(Vector2 a, Vector2 b) {
     return sqrtf(dx*dx + dy*dy);
 }
 
-void ClampBallSpeed(Ball *b, float maxSpeed) {
+bool ClampBallSpeed(Ball *b, float maxSpeed) {
     float sx = b->velocity.x;
     float sy = b->velocity.y;
     float mag = sqrtf(sx*sx + sy*sy);
     if (mag > maxSpeed) {
         b->velocity.x = (b->velocity.x / mag) * maxSpeed;
         b->velocity.y = (b->velocity.y / mag) * maxSpeed;
+        return true;
     }
+    return false;
 }
 
 bool AreBallsMoving(Game *game) {
@@ -25,3 +29,66 @@ bool AreBallsMoving(Game *game) {
     }
     return false;
 }
+
+// Monotonic wall clock in seconds, for timing outside of raylib's frame clock
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void SleepSeconds(double seconds) {
+    if (seconds <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+unsigned int RandomNext(unsigned long long *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (unsigned int)(*state >> 32);
+}
+
+float RandomFloat(unsigned long long *state) {
+    return (float)(RandomNext(state) >> 8) / (float)(1u << 24);
+}
+
+void FrameStatsReset(FrameStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void FrameStatsAdd(FrameStats *stats, double seconds) {
+    stats->count++;
+    stats->sum += seconds;
+    stats->sumSq += seconds * seconds;
+    if (seconds > stats->max) stats->max = seconds;
+
+    int bucket = (int)(seconds * 10000.0);
+    if (bucket >= FRAME_STATS_BUCKETS) bucket = FRAME_STATS_BUCKETS - 1;
+    if (bucket < 0) bucket = 0;
+    stats->histogram[bucket]++;
+}
+
+// Upper edge of the bucket that holds the p-th fraction of samples, in seconds
+double FrameStatsPercentile(const FrameStats *stats, double p) {
+    long target = (long)ceil(p * stats->count);
+    long seen = 0;
+    for (int b = 0; b < FRAME_STATS_BUCKETS; b++) {
+        seen += stats->histogram[b];
+        if (seen >= target && seen > 0) return (b + 1) / 10000.0;
+    }
+    return stats->max;
+}
+
+void FrameStatsPrint(const FrameStats *stats, const char *label) {
+    if (stats->count == 0) return;
+    double mean = stats->sum / stats->count;
+    double variance = stats->sumSq / stats->count - mean * mean;
+    if (variance < 0.0) variance = 0.0;
+    printf("%s: %ld frames, mean %.3f ms, stddev %.3f ms, p99 %.1f ms, max %.3f ms\n",
+           label, stats->count, mean * 1000.0, sqrt(variance) * 1000.0,
+           FrameStatsPercentile(stats, 0.99) * 1000.0, stats->max * 1000.0);
+}
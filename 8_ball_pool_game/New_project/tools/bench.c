@@ -0,0 +1,606 @@
+// Headless micro-benchmarks for the physics core.
+//
+//   pool_bench solver [balls] [steps] [threads]   contact solver scaling from 1 to N threads
+//   pool_bench search [turns] [threads]            self-play shot search through the shot cache
+//   pool_bench rails [ball-steps]                  cushion sweep + pocket test vs the old clamp + distance check
+//   pool_bench fidelity [positions] [stride]       screening rollouts against exact ones: cost and disagreement
+//   pool_bench kernels [shots]                     physics kernel backends: self-benchmark and whole shots
+//   pool_bench fallbacks [balls] [steps]           the solver with every allocation failing, on each backend
+
+#include "common.h"
+#include "solver.h"
+#include "utils.h"
+#include "jobs.h"
+#include "table.h"
+#include "game.h"
+#include "ai.h"
+#include "cache.h"
+#include "sim.h"
+#include "kernels.h"
+
+static unsigned int Rand(unsigned int *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static float RandRange(unsigned int *state, float lo, float hi) {
+    return lo + (hi - lo) * (Rand(state) & 0xFFFF) / 65535.0f;
+}
+
+// FNV-1a over the raw ball state, to show that results match across thread counts
+static unsigned int Checksum(const Ball *balls, int count) {
+    unsigned int h = 2166136261u;
+    const unsigned char *p = (const unsigned char *)balls;
+    for (size_t i = 0; i < sizeof(Ball) * (size_t)count; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Sandbox table: balls on a jittered grid filling roughly half the area
+static void FillSandbox(Ball *balls, int count, float *width, float *height) {
+    int cols = (int)ceilf(sqrtf(count * 2.0f));
+    int rows = (count + cols - 1) / cols;
+    float spacing = BALL_RADIUS * 2.4f;
+    *width = cols * spacing;
+    *height = rows * spacing;
+
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; i++) {
+        memset(&balls[i], 0, sizeof(Ball));
+        balls[i].position.x = (i % cols + 0.5f) * spacing + RandRange(&seed, -3.0f, 3.0f);
+        balls[i].position.y = (i / cols + 0.5f) * spacing + RandRange(&seed, -3.0f, 3.0f);
+        balls[i].velocity.x = RandRange(&seed, -8.0f, 8.0f);
+        balls[i].velocity.y = RandRange(&seed, -8.0f, 8.0f);
+        balls[i].number = i;
+    }
+}
+
+static void StepSandbox(Ball *balls, int count, float width, float height, SolverStats *stats) {
+    for (int i = 0; i < count; i++) {
+        Ball *b = &balls[i];
+        b->position.x += b->velocity.x;
+        b->position.y += b->velocity.y;
+        b->velocity.x *= FRICTION;
+        b->velocity.y *= FRICTION;
+        if (b->position.x < BALL_RADIUS)          { b->position.x = BALL_RADIUS;          b->velocity.x = -b->velocity.x * 0.86f; }
+        if (b->position.x > width - BALL_RADIUS)  { b->position.x = width - BALL_RADIUS;  b->velocity.x = -b->velocity.x * 0.86f; }
+        if (b->position.y < BALL_RADIUS)          { b->position.y = BALL_RADIUS;          b->velocity.y = -b->velocity.y * 0.86f; }
+        if (b->position.y > height - BALL_RADIUS) { b->position.y = height - BALL_RADIUS; b->velocity.y = -b->velocity.y * 0.86f; }
+    }
+    SolveContacts(balls, count, stats, NULL);
+}
+
+static int BenchSolver(int count, int steps, int cores) {
+    Ball *initial = malloc(sizeof(Ball) * count);
+    Ball *balls = malloc(sizeof(Ball) * count);
+    float width, height;
+    FillSandbox(initial, count, &width, &height);
+
+    double baseline = 0.0;
+    printf("solver: %d balls, %d steps, %.0fx%.0f table\n", count, steps, width, height);
+    printf("%8s %12s %9s %10s %8s  %-8s\n", "threads", "ms/step", "speedup", "contacts", "batches", "checksum");
+
+    for (int threads = 1; threads <= cores; threads = threads < cores && threads * 2 > cores ? cores : threads * 2) {
+        JobsInit(threads);
+        memcpy(balls, initial, sizeof(Ball) * count);
+
+        SolverStats stats = {0};
+        double start = NowSeconds();
+        for (int s = 0; s < steps; s++) StepSandbox(balls, count, width, height, &stats);
+        double elapsed = NowSeconds() - start;
+        JobsShutdown();
+
+        double msPerStep = elapsed * 1000.0 / steps;
+        if (threads == 1) baseline = msPerStep;
+        printf("%8d %12.4f %8.2fx %10d %8d  %08x\n", threads, msPerStep, baseline / msPerStep,
+               stats.contacts, stats.batches / steps, Checksum(balls, count));
+        if (threads == cores) break;
+    }
+
+    free(initial);
+    free(balls);
+    return 0;
+}
+
+// The rail handling UpdatePhysics used before the cushion geometry, kept as the baseline
+static int ClampRails(Ball *b) {
+    int hits = 0;
+    b->position.x += b->velocity.x;
+    b->position.y += b->velocity.y;
+    if (b->position.x - BALL_RADIUS < RAIL_WIDTH) {
+        b->position.x = RAIL_WIDTH + BALL_RADIUS;
+        b->velocity.x = -b->velocity.x * RAIL_RESTITUTION;
+        hits++;
+    }
+    if (b->position.x + BALL_RADIUS > TABLE_WIDTH - RAIL_WIDTH) {
+        b->position.x = TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
+        b->velocity.x = -b->velocity.x * RAIL_RESTITUTION;
+        hits++;
+    }
+    if (b->position.y - BALL_RADIUS < RAIL_WIDTH) {
+        b->position.y = RAIL_WIDTH + BALL_RADIUS;
+        b->velocity.y = -b->velocity.y * RAIL_RESTITUTION;
+        hits++;
+    }
+    if (b->position.y + BALL_RADIUS > TABLE_HEIGHT - RAIL_WIDTH) {
+        b->position.y = TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
+        b->velocity.y = -b->velocity.y * RAIL_RESTITUTION;
+        hits++;
+    }
+    return hits;
+}
+
+// The pocket test CheckPockets used alongside the clamp
+static bool OldPocketAt(Vector2 position) {
+    Vector2 pockets[6];
+    GetPocketPositions(pockets);
+    for (int p = 0; p < 6; p++) {
+        if (Distance(position, pockets[p]) < POCKET_RADIUS) return true;
+    }
+    return false;
+}
+
+// Balls rolling out under friction on the real table; stopped or pocketed
+// balls are respawned so the mix of open-table and near-cushion steps stays steady
+static int BenchRails(long ballSteps) {
+    const TableGeometry *table = GetTableGeometry();
+    enum { COUNT = 1024 };
+    static Ball initial[COUNT], balls[COUNT];
+
+    unsigned int seed = 777;
+    for (int i = 0; i < COUNT; i++) {
+        memset(&initial[i], 0, sizeof(Ball));
+        initial[i].position.x = RandRange(&seed, RAIL_WIDTH + BALL_RADIUS, TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS);
+        initial[i].position.y = RandRange(&seed, RAIL_WIDTH + BALL_RADIUS, TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS);
+        initial[i].velocity.x = RandRange(&seed, -12.0f, 12.0f);
+        initial[i].velocity.y = RandRange(&seed, -12.0f, 12.0f);
+    }
+    long rounds = ballSteps / COUNT;
+    if (rounds < 1) rounds = 1;
+
+    for (int variant = 0; variant < 2; variant++) {
+        memcpy(balls, initial, sizeof(balls));
+        long hits = 0;
+        long drops = 0;
+        double start = NowSeconds();
+        for (long r = 0; r < rounds; r++) {
+            for (int i = 0; i < COUNT; i++) {
+                Ball *b = &balls[i];
+                if (variant == 0) {
+                    hits += ClampRails(b);
+                    if (OldPocketAt(b->position)) {
+                        *b = initial[i];
+                        drops++;
+                        continue;
+                    }
+                } else {
+                    hits += SweepBall(table, b, RAIL_RESTITUTION);
+                    if (PocketAt(table, b->position) >= 0) {
+                        *b = initial[i];
+                        drops++;
+                        continue;
+                    }
+                }
+                b->velocity.x *= FRICTION;
+                b->velocity.y *= FRICTION;
+                if (fabsf(b->velocity.x) < 0.1f && fabsf(b->velocity.y) < 0.1f) *b = initial[i];
+            }
+        }
+        double elapsed = NowSeconds() - start;
+        printf("%-14s %8.2f ns/ball-step  %ld cushion hits  %ld pocket drops\n",
+               variant == 0 ? "clamp (old)" : "bvh sweep", elapsed * 1e9 / (rounds * COUNT), hits, drops);
+    }
+    return 0;
+}
+
+// Self-play through the shot search. After each real search the same table
+// is searched a few more times with float-noise jitter on every ball, the way
+// a per-frame aim preview would ask; those repeats should be cache hits.
+static int BenchSearch(int turns, int threads) {
+    JobsInit(threads);
+    if (!ShotCacheInit(SHOT_CACHE_SLOTS_LOG2)) {
+        fprintf(stderr, "could not allocate the shot cache\n");
+        return 1;
+    }
+
+    enum { REPEATS = 4 };
+    Game game;
+    InitGame(&game);
+    game.headless = true;
+    SearchStats first = { 0 }, repeat = { 0 };
+    int searches = 0, agreements = 0, games = 1;
+    unsigned int seed = 4242;
+
+    for (int turn = 0; turn < turns; turn++) {
+        if (game.state == GAME_WON || game.state == GAME_LOST) {
+            InitGame(&game);
+            game.headless = true;
+            games++;
+        }
+        if (game.state == GAME_SCRATCH) {
+            Vector2 spot;
+            if (!ChooseCuePlacement(&game, &spot, &first) || !PlaceCueBall(&game, spot)) {
+                PlaceCueBall(&game, game.cueBallPos);
+            }
+        }
+
+        ShotChoice best;
+        if (!SearchShot(&game, &best, &first)) break;
+        searches++;
+
+        for (int r = 0; r < REPEATS; r++) {
+            Game jittered = game;
+            for (int i = 0; i < MAX_BALLS; i++) {
+                jittered.balls[i].position.x += RandRange(&seed, -0.0005f, 0.0005f);
+                jittered.balls[i].position.y += RandRange(&seed, -0.0005f, 0.0005f);
+            }
+            ShotChoice again;
+            SearchShot(&jittered, &again, &repeat);
+            if (again.angle == best.angle && again.speed == best.speed) agreements++;
+        }
+
+        Game next;
+        SimulateShot(&game, best.angle, best.speed, &next, NULL);
+        game = next;
+    }
+
+    printf("%d threads, %d games, %d searches of %d shots\n",
+           JobsThreadCount(), games, searches, SEARCH_ANGLE_STEPS * SEARCH_POWER_STEPS);
+    printf("first searches:  %6d simulated %6d cached  %8.2f ms/search\n",
+           first.simulated, first.cached, 1000.0 * first.seconds / (searches > 0 ? searches : 1));
+    printf("repeat searches: %6d simulated %6d cached  %8.2f ms/search  %d/%d same choice\n",
+           repeat.simulated, repeat.cached, 1000.0 * repeat.seconds / (searches > 0 ? searches * REPEATS : 1),
+           agreements, searches * REPEATS);
+    ShotCachePrintReport(stdout);
+
+    ShotCacheShutdown();
+    JobsShutdown();
+    return 0;
+}
+
+// --- Screening fidelity ---
+
+#define FIDELITY_SHOTS (SEARCH_ANGLE_STEPS * SEARCH_POWER_STEPS)
+#define FIDELITY_STRIDES 4
+#define FIDELITY_CUTS 7
+
+static const int fidelityCuts[FIDELITY_CUTS] = { 1, 4, 8, 16, 32, 64, 128 };
+
+typedef struct {
+    const Game *game;
+    int stride;                     // 0: exact
+    Game *ends;
+    ShotOutcome *outcomes;
+    float *scores;
+} RolloutJob;
+
+// The grid shot SearchShot would run for index, at the job's fidelity
+static void RolloutOne(int index, void *ctx) {
+    RolloutJob *job = ctx;
+    float angle = (float)(index % SEARCH_ANGLE_STEPS) * (2.0f * PI / SEARCH_ANGLE_STEPS);
+    float speed = MAX_SHOT_SPEED * (float)(index / SEARCH_ANGLE_STEPS + 1) / SEARCH_POWER_STEPS;
+    ShotCacheCanonical(&angle, &speed);
+    SimulateShotCoarse(job->game, angle, speed, job->stride, &job->ends[index], &job->outcomes[index]);
+    job->scores[index] = ScoreOutcome(job->game, &job->outcomes[index]) - 0.05f * speed / MAX_SHOT_SPEED;
+}
+
+static double Rollouts(RolloutJob *job) {
+    double start = NowSeconds();
+    JobsParallelFor(FIDELITY_SHOTS, RolloutOne, job);
+    return NowSeconds() - start;
+}
+
+typedef struct {
+    double seconds;
+    long steps;
+    long shots;
+    long pocketed, scratch, result, pot;   // shots whose outcome differs from the exact one
+    double cueError, worstError;            // pixels, summed over shots
+    int found[FIDELITY_CUTS];               // positions whose exact best is in the screened top k
+    double loss[FIDELITY_CUTS];             // exact best score minus the best confirmed one
+} FidelityRow;
+
+// How far the screened ranking is from the exact one: for each cut, is the
+// exact best among the top k screened shots, and what score does confirming
+// those k exactly give up
+static void RankScreened(const float *coarse, const float *exact, FidelityRow *row) {
+    static int order[FIDELITY_SHOTS];
+    for (int i = 0; i < FIDELITY_SHOTS; i++) order[i] = i;
+    // Insertion sort on the screened score, stable, so ties keep grid order
+    for (int i = 1; i < FIDELITY_SHOTS; i++) {
+        int v = order[i], k = i;
+        while (k > 0 && coarse[order[k - 1]] < coarse[v]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = v;
+    }
+    float best = exact[0];
+    for (int i = 1; i < FIDELITY_SHOTS; i++) best = fmaxf(best, exact[i]);
+
+    float confirmed = -1e30f;
+    int cut = 0;
+    for (int k = 0; k < FIDELITY_SHOTS && cut < FIDELITY_CUTS; k++) {
+        confirmed = fmaxf(confirmed, exact[order[k]]);
+        while (cut < FIDELITY_CUTS && k + 1 == fidelityCuts[cut]) {
+            if (confirmed >= best) row->found[cut]++;
+            row->loss[cut] += best - confirmed;
+            cut++;
+        }
+    }
+}
+
+static void CompareRollouts(const RolloutJob *exact, const RolloutJob *coarse, FidelityRow *row) {
+    for (int i = 0; i < FIDELITY_SHOTS; i++) {
+        const ShotOutcome *a = &exact->outcomes[i], *b = &coarse->outcomes[i];
+        row->shots++;
+        row->steps += b->steps;
+        if (a->pocketed != b->pocketed) row->pocketed++;
+        if (a->scratch != b->scratch) row->scratch++;
+        if (a->stateAfter != b->stateAfter || a->nextPlayer != b->nextPlayer) row->result++;
+        if ((exact->scores[i] > 0.0f) != (coarse->scores[i] > 0.0f)) row->pot++;
+
+        float worst = 0.0f;
+        for (int k = 0; k < MAX_BALLS; k++) {
+            const Ball *x = &exact->ends[i].balls[k], *y = &coarse->ends[i].balls[k];
+            if (x->pocketed || y->pocketed) continue;
+            float e = Distance(x->position, y->position);
+            if (k == 0) row->cueError += e;
+            worst = fmaxf(worst, e);
+        }
+        row->worstError += worst;
+    }
+}
+
+// Self-play positions, every grid shot run exactly and at each screening
+// stride; the exact best shot (or now and then a random one) is played to
+// reach the next position
+static int BenchFidelity(int positions, int onlyStride) {
+    JobsInit(0);
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+
+    int strides[FIDELITY_STRIDES] = { 2, 4, 8, 16 };
+    int strideCount = FIDELITY_STRIDES;
+    if (onlyStride > 1) {
+        strides[0] = onlyStride;
+        strideCount = 1;
+    }
+
+    static Game ends[2][FIDELITY_SHOTS];
+    static ShotOutcome outcomes[2][FIDELITY_SHOTS];
+    static float scores[2][FIDELITY_SHOTS];
+    static FidelityRow rows[FIDELITY_STRIDES];
+    double exactSeconds = 0.0, searchLoss = 0.0;
+    long exactSteps = 0;
+    SearchStats searchStats = { 0 };
+    unsigned int seed = 2024;
+
+    Game game;
+    InitGame(&game);
+    game.headless = true;
+    for (int n = 0; n < positions; n++) {
+        if (game.state == GAME_WON || game.state == GAME_LOST) {
+            InitGame(&game);
+            game.headless = true;
+        }
+        if (game.state == GAME_SCRATCH) {
+            Vector2 spot;
+            if (!ChooseCuePlacement(&game, &spot, NULL) || !PlaceCueBall(&game, spot)) {
+                PlaceCueBall(&game, game.cueBallPos);
+            }
+        }
+
+        RolloutJob exact = { &game, 0, ends[0], outcomes[0], scores[0] };
+        exactSeconds += Rollouts(&exact);
+        for (int i = 0; i < FIDELITY_SHOTS; i++) exactSteps += outcomes[0][i].steps;
+
+        for (int s = 0; s < strideCount; s++) {
+            RolloutJob coarse = { &game, strides[s], ends[1], outcomes[1], scores[1] };
+            rows[s].seconds += Rollouts(&coarse);
+            CompareRollouts(&exact, &coarse, &rows[s]);
+            RankScreened(scores[1], scores[0], &rows[s]);
+        }
+
+        int best = 0;
+        for (int i = 1; i < FIDELITY_SHOTS; i++) {
+            if (scores[0][i] > scores[0][best]) best = i;
+        }
+
+        // The search the computer player would run, with the configured cut
+        ShotChoice screened;
+        if (SearchShotScreened(&game, SCREEN_CONFIRM_TOP, &screened, &searchStats)) {
+            searchLoss += scores[0][best] - screened.score;
+        }
+        // Mostly the best shot, sometimes a random one, so games do not repeat
+        if (Rand(&seed) % 10 < 3) best = (int)(Rand(&seed) % FIDELITY_SHOTS);
+        game = ends[0][best];
+        game.headless = true;
+        fprintf(stderr, "  position %d/%d\n", n + 1, positions);
+    }
+
+    long shots = (long)positions * FIDELITY_SHOTS;
+    printf("%d positions x %d grid shots on %d threads; COARSE_MAX_TRAVEL %.0f px\n",
+           positions, FIDELITY_SHOTS, JobsThreadCount(), (double)COARSE_MAX_TRAVEL);
+    printf("exact:      %7.2f ms/position, %5.0f steps/shot\n",
+           exactSeconds * 1000.0 / positions, (double)exactSteps / shots);
+    printf("\n%-7s %10s %8s %6s | %9s %9s %9s %9s | %9s %9s\n", "stride", "ms/pos", "speedup", "steps",
+           "pocketed", "scratch", "result", "pot", "cue px", "worst px");
+    for (int s = 0; s < strideCount; s++) {
+        const FidelityRow *r = &rows[s];
+        printf("%-7d %10.2f %7.2fx %6.0f | %8.2f%% %8.2f%% %8.2f%% %8.2f%% | %9.2f %9.2f\n",
+               strides[s], r->seconds * 1000.0 / positions, exactSeconds / r->seconds, (double)r->steps / shots,
+               100.0 * r->pocketed / shots, 100.0 * r->scratch / shots, 100.0 * r->result / shots,
+               100.0 * r->pot / shots, r->cueError / shots, r->worstError / shots);
+    }
+    printf("\nSearchShotScreened (stride %d, top %d confirmed): %.2f ms/position, %.1f exact shots, gives up %.3f\n",
+           COARSE_STRIDE, SCREEN_CONFIRM_TOP, searchStats.seconds * 1000.0 / positions,
+           (double)searchStats.simulated / positions, searchLoss / positions);
+    printf("\nexact best among the top k screened shots (mean score given up by confirming only those):\n%-7s", "stride");
+    for (int c = 0; c < FIDELITY_CUTS; c++) printf(" %12d", fidelityCuts[c]);
+    printf("\n");
+    for (int s = 0; s < strideCount; s++) {
+        printf("%-7d", strides[s]);
+        for (int c = 0; c < FIDELITY_CUTS; c++) {
+            printf(" %5.1f%% %5.2f", 100.0 * rows[s].found[c] / positions, rows[s].loss[c] / positions);
+        }
+        printf("\n");
+    }
+
+    ShotCacheShutdown();
+    JobsShutdown();
+    return 0;
+}
+
+// --- Kernel backends ---
+
+// The same random shots from the break on every backend the CPU runs, one
+// thread: time per physics step, and a checksum of every end table that has
+// to agree with scalar bit for bit
+static int BenchKernels(int shots) {
+    JobsInit(1);
+    KernelTiming timings[KERNELS_MAX];
+    int count = KernelsBenchmark(timings, KERNELS_MAX);
+    printf("self-benchmark, %d synthetic tables:\n", KERNELS_BENCH_TABLES);
+    for (int k = 0; k < count; k++) {
+        printf("  %-8s %8.3f us/step  %5.2fx  %s\n", timings[k].kernels->name, timings[k].micros,
+               timings[0].micros / timings[k].micros, timings[k].matches ? "matches scalar" : "MISMATCH");
+    }
+
+    printf("%d shots of self-play:\n", shots);
+    unsigned int reference = 0;
+    bool allMatch = true;
+    for (int k = 0; k < count; k++) {
+        KernelsUse(timings[k].kernels);
+        Game game;
+        InitGame(&game);
+        game.headless = true;
+        unsigned int seed = 777, check = 2166136261u;
+        long steps = 0;
+        double start = NowSeconds();
+        for (int shot = 0; shot < shots; shot++) {
+            if (game.state == GAME_WON || game.state == GAME_LOST) {
+                InitGame(&game);
+                game.headless = true;
+            }
+            if (game.state == GAME_SCRATCH) PlaceCueBall(&game, game.cueBallPos);
+
+            float angle = RandRange(&seed, 0.0f, 2.0f * PI);
+            float speed = RandRange(&seed, 0.2f, 1.0f) * MAX_SHOT_SPEED;
+            Game next;
+            ShotOutcome outcome;
+            SimulateShot(&game, angle, speed, &next, &outcome);
+            steps += outcome.steps;
+            check = (check ^ Checksum(next.balls, MAX_BALLS)) * 16777619u;
+            game = next;
+        }
+        double elapsed = NowSeconds() - start;
+        if (k == 0) reference = check;
+        allMatch = allMatch && check == reference;
+        printf("  %-8s %8.1f ns/step  %8ld steps  checksum %08x%s\n", timings[k].kernels->name,
+               elapsed * 1e9 / (steps > 0 ? steps : 1), steps, check, check == reference ? "" : "  MISMATCH");
+    }
+
+    JobsShutdown();
+    return allMatch ? 0 : 1;
+}
+
+// --- Out of memory ---
+
+// A sandbox bigger than the kernels' limit, stepped with the solver's heap
+// allocations failing: the gather has to find the same pairs as the sweep,
+// and solving has to cope with the pairs it has no room for. Run under a
+// sanitizer to check the fallbacks stay inside their buffers.
+static int BenchFallbacks(int count, int steps) {
+    JobsInit(1);
+    Ball *initial = malloc(sizeof(Ball) * count);
+    Ball *balls = malloc(sizeof(Ball) * count);
+    int capacity = count * 6;
+    Contact *swept = malloc(sizeof(Contact) * capacity);
+    Contact *fallback = malloc(sizeof(Contact) * capacity);
+    if (!initial || !balls || !swept || !fallback) {
+        free(initial);
+        free(balls);
+        free(swept);
+        free(fallback);
+        JobsShutdown();
+        return 1;
+    }
+    float width, height;
+    FillSandbox(initial, count, &width, &height);
+
+    const PhysicsKernels *list[KERNELS_MAX];
+    int backends = KernelsSupported(list, KERNELS_MAX);
+    bool allMatch = true;
+    printf("fallbacks: %d balls, %d steps\n", count, steps);
+    for (int k = 0; k < backends; k++) {
+        KernelsUse(list[k]);
+        memcpy(balls, initial, sizeof(Ball) * count);
+        SolverStats stats = {0};
+        int mismatches = 0, most = 0;
+        for (int s = 0; s < steps; s++) {
+            int n = GatherContacts(balls, count, swept, capacity);
+            SolverFailAllocations(true);
+            int m = GatherContacts(balls, count, fallback, capacity);
+            int stored = n < capacity ? n : capacity;
+            if (m != n || memcmp(swept, fallback, sizeof(Contact) * (size_t)stored) != 0) mismatches++;
+            if (n > most) most = n;
+            StepSandbox(balls, count, width, height, &stats);
+            SolverFailAllocations(false);
+        }
+        allMatch = allMatch && mismatches == 0;
+        printf("  %-8s %4d steps with different pairs, up to %d pairs a step, %d resolved, %d dropped\n",
+               list[k]->name, mismatches, most, stats.contacts, stats.dropped);
+    }
+
+    free(initial);
+    free(balls);
+    free(swept);
+    free(fallback);
+    JobsShutdown();
+    return allMatch ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    const char *mode = argc > 1 ? argv[1] : "solver";
+
+    if (strcmp(mode, "solver") == 0) {
+        int count = argc > 2 ? atoi(argv[2]) : 20000;
+        int steps = argc > 3 ? atoi(argv[3]) : 200;
+        int threads = argc > 4 ? atoi(argv[4]) : JobsCoreCount();
+        return BenchSolver(count, steps, threads);
+    }
+
+    if (strcmp(mode, "search") == 0) {
+        int turns = argc > 2 ? atoi(argv[2]) : 20;
+        int threads = argc > 3 ? atoi(argv[3]) : 0;
+        return BenchSearch(turns, threads);
+    }
+
+    if (strcmp(mode, "rails") == 0) {
+        long ballSteps = argc > 2 ? atol(argv[2]) : 50000000L;
+        return BenchRails(ballSteps);
+    }
+
+    if (strcmp(mode, "fidelity") == 0) {
+        int positions = argc > 2 ? atoi(argv[2]) : 30;
+        int stride = argc > 3 ? atoi(argv[3]) : 0;
+        return BenchFidelity(positions > 0 ? positions : 1, stride);
+    }
+
+    if (strcmp(mode, "kernels") == 0) {
+        int shots = argc > 2 ? atoi(argv[2]) : 200;
+        return BenchKernels(shots > 0 ? shots : 1);
+    }
+
+    if (strcmp(mode, "fallbacks") == 0) {
+        int count = argc > 2 ? atoi(argv[2]) : 200;
+        int steps = argc > 3 ? atoi(argv[3]) : 200;
+        return BenchFallbacks(count > SOLVER_SWEEP_MIN ? count : SOLVER_SWEEP_MIN + 1, steps > 0 ? steps : 1);
+    }
+
+    fprintf(stderr, "usage: %s solver [balls] [steps] [threads] | search [turns] [threads] | rails [ball-steps] | "
+                    "fidelity [positions] [stride] | kernels [shots] | fallbacks [balls] [steps]\n", argv[0]);
+    return 1;
+}
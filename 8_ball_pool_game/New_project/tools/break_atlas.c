@@ -0,0 +1,110 @@
+// Builds the break-outcome atlas: simulates a grid of break shots in
+// parallel and writes the results in the format atlas.c maps.
+//
+//   pool_break_atlas [out.bin] [cue-x steps] [cue-y steps] [angle steps] [power steps]
+
+#include "common.h"
+#include "game.h"
+#include "sim.h"
+#include "atlas.h"
+#include "jobs.h"
+#include "utils.h"
+#include <stdatomic.h>
+
+typedef struct {
+    BreakAtlasHeader header;
+    BreakRecord *records;
+    Game rack;
+    atomic_int done;
+} AtlasJob;
+
+static unsigned short QuantizeLayout(float v) {
+    int q = (int)lroundf(v * BREAK_LAYOUT_QUANT);
+    return (unsigned short)(q < 0 ? 0 : (q > 0xFFFF ? 0xFFFF : q));
+}
+
+// One job per (cue x, cue y, angle) cell; the power axis is swept inside
+static void SimulateCell(int index, void *ctx) {
+    AtlasJob *job = ctx;
+    const BreakAtlasHeader *h = &job->header;
+    int cell[4];
+    cell[2] = index % h->dims[2];
+    cell[1] = (index / h->dims[2]) % h->dims[1];
+    cell[0] = index / (h->dims[2] * h->dims[1]);
+
+    Game start = job->rack;
+    start.balls[0].position.x = BreakAtlasAxisValue(h, 0, cell[0]);
+    start.balls[0].position.y = BreakAtlasAxisValue(h, 1, cell[1]);
+    start.cueBallPos = start.balls[0].position;
+    float angle = BreakAtlasAxisValue(h, 2, cell[2]);
+
+    for (cell[3] = 0; cell[3] < h->dims[3]; cell[3]++) {
+        float power = BreakAtlasAxisValue(h, 3, cell[3]);
+        Game end;
+        ShotOutcome outcome;
+        SimulateShot(&start, angle, power * MAX_SHOT_SPEED, &end, &outcome);
+
+        BreakRecord *r = &job->records[BreakAtlasIndex(h, cell)];
+        r->pocketed = outcome.pocketed;
+        r->flags = (outcome.scratch ? BREAK_SCRATCH : 0) | (outcome.eightPocketed ? BREAK_EIGHT : 0);
+        r->ballsPocketed = 0;
+        for (int i = 1; i < MAX_BALLS; i++) {
+            if ((outcome.pocketed >> i) & 1) r->ballsPocketed++;
+        }
+        for (int i = 0; i < MAX_BALLS; i++) {
+            r->x[i] = QuantizeLayout(end.balls[i].position.x);
+            r->y[i] = QuantizeLayout(end.balls[i].position.y);
+        }
+    }
+
+    int done = atomic_fetch_add(&job->done, 1) + 1;
+    int total = h->dims[0] * h->dims[1] * h->dims[2];
+    if (done % (total / 20 + 1) == 0) fprintf(stderr, "  %3d%%\n", done * 100 / total);
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : BREAK_ATLAS_PATH;
+    int dims[4] = { 5, 9, 120, 10 };
+    for (int a = 0; a < 4 && argc > a + 2; a++) {
+        dims[a] = atoi(argv[a + 2]);
+        if (dims[a] < 1) dims[a] = 1;
+    }
+
+    // Cue anywhere behind the head string, any direction, 10%..100% power
+    float minValue[4] = { RAIL_WIDTH + BALL_RADIUS + 1.0f, RAIL_WIDTH + BALL_RADIUS + 1.0f, -PI, 0.1f };
+    float maxValue[4] = { TABLE_WIDTH * 0.25f, TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS - 1.0f, PI, 1.0f };
+
+    static AtlasJob job;
+    BreakAtlasInitHeader(&job.header, dims, minValue, maxValue);
+    job.records = calloc(job.header.recordCount, sizeof(BreakRecord));
+    InitGame(&job.rack);
+    atomic_store(&job.done, 0);
+    if (!job.records) {
+        fprintf(stderr, "break_atlas: out of memory\n");
+        return 1;
+    }
+
+    JobsInit(0);
+    fprintf(stderr, "break_atlas: %u breaks (%dx%dx%dx%d) on %d threads\n",
+            job.header.recordCount, dims[0], dims[1], dims[2], dims[3], JobsThreadCount());
+
+    double start = NowSeconds();
+    JobsParallelFor(dims[0] * dims[1] * dims[2], SimulateCell, &job);
+    double elapsed = NowSeconds() - start;
+    JobsShutdown();
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "break_atlas: cannot write %s\n", path);
+        return 1;
+    }
+    fwrite(&job.header, sizeof(job.header), 1, f);
+    fwrite(job.records, sizeof(BreakRecord), job.header.recordCount, f);
+    fclose(f);
+
+    printf("break_atlas: wrote %s, %.1f MB, %.1f s (%.0f breaks/s)\n", path,
+           (sizeof(job.header) + (double)job.header.recordCount * sizeof(BreakRecord)) / 1e6,
+           elapsed, job.header.recordCount / elapsed);
+    free(job.records);
+    return 0;
+}
@@ -0,0 +1,421 @@
+// Replay corpus tool: builds the columnar shot corpus (corpus.h) and answers
+// filter/aggregate questions over it in parallel across the job pool.
+//
+//   pool_corpus synth <out> <games> [seed] [threads]    self-play with a quick noisy player
+//   pool_corpus import <out> <script>...                games from input scripts
+//   pool_corpus query <corpus> [filters] [threads]
+//
+// Filters: --break, --player <0|1>, --scratch, --clean (no scratch), --pots,
+// --speed <min> <max>, --near <px> (cue ball within px of an object ball when
+// struck), --verify (replay every game and compare with the recorded results).
+// Columns answer everything but --near and --verify; those rebuild tables
+// through the physics, and only for games with a row the columns let through.
+//
+//   break scratch rate:    pool_corpus query games.bin --break
+//   average shots per rack: pool_corpus query games.bin
+
+#include "common.h"
+#include "game.h"
+#include "corpus.h"
+#include "placement.h"
+#include "input.h"
+#include "script.h"
+#include "rewind.h"
+#include "jobs.h"
+#include "sim.h"
+#include "utils.h"
+
+#define SYNTH_MAX_SHOTS 120         // a game still open after this many shots is cut off
+#define SYNTH_BATCH 256             // games simulated per parallel batch
+#define QUERY_CHUNK 512             // games per query job
+
+// --- synth ---
+
+typedef struct {
+    unsigned int seed;
+    unsigned int firstGame;
+    CorpusShot *rows;               // SYNTH_MAX_SHOTS per game of the batch
+    int *counts;
+} SynthJob;
+
+static unsigned int NextRandom(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static float RandomUnit(unsigned int *state) {
+    return (float)(NextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Aims at a random ball the shooter may legally hit first, with some noise
+static void ChooseSynthShot(const Game *g, unsigned int *rng, float *angle, float *speed) {
+    Vector2 cue = g->balls[0].position;
+    if (g->firstShot) {
+        Vector2 apex = g->balls[1].position;
+        *angle = atan2f(apex.y - cue.y, apex.x - cue.x) + (RandomUnit(rng) - 0.5f) * 0.04f;
+        *speed = MAX_SHOT_SPEED * (0.8f + 0.2f * RandomUnit(rng));
+        return;
+    }
+
+    const Player *me = &g->players[g->currentPlayer];
+    int targets[MAX_BALLS], count = 0;
+    for (int i = 1; i < MAX_BALLS; i++) {
+        const Ball *b = &g->balls[i];
+        if (b->pocketed || b->type == BALL_EIGHT) continue;
+        if (g->assignedTypes && ((me->type == PLAYER_SOLIDS) != (b->type == BALL_SOLID))) continue;
+        targets[count++] = i;
+    }
+    if (count == 0) targets[count++] = 8;
+
+    Vector2 target = g->balls[targets[NextRandom(rng) % (unsigned int)count]].position;
+    *angle = atan2f(target.y - cue.y, target.x - cue.x) + (RandomUnit(rng) - 0.5f) * 0.1f;
+    *speed = MAX_SHOT_SPEED * (0.3f + 0.7f * RandomUnit(rng));
+}
+
+static void PlaceSynthCue(Game *g, unsigned int *rng) {
+    if (PlaceCueBall(g, g->cueBallPos)) return;
+    for (int tries = 0; tries < 100; tries++) {
+        Vector2 spot = { RAIL_WIDTH + BALL_RADIUS + RandomUnit(rng) * (TABLE_WIDTH - 2 * (RAIL_WIDTH + BALL_RADIUS)),
+                         RAIL_WIDTH + BALL_RADIUS + RandomUnit(rng) * (TABLE_HEIGHT - 2 * (RAIL_WIDTH + BALL_RADIUS)) };
+        if (PlaceCueBall(g, spot)) return;
+    }
+}
+
+static void PlaySynthGame(int index, void *ctx) {
+    SynthJob *job = ctx;
+    CorpusShot *rows = job->rows + (size_t)index * SYNTH_MAX_SHOTS;
+    unsigned int rng = (job->seed * 2654435761u) ^ ((job->firstGame + (unsigned int)index) * 40503u + 1u);
+    if (rng == 0) rng = 1;
+
+    Game table, before;
+    InitGame(&table);
+    table.headless = true;
+
+    int count = 0;
+    while (count < SYNTH_MAX_SHOTS && table.state != GAME_WON && table.state != GAME_LOST) {
+        if (table.state == GAME_SCRATCH) PlaceSynthCue(&table, &rng);
+        if (table.state == GAME_SCRATCH) break;
+
+        float angle, speed;
+        ChooseSynthShot(&table, &rng, &angle, &speed);
+        before = table;
+        ShotOutcome outcome;
+        SimulateShot(&before, angle, speed, &table, &outcome);
+        CorpusShotStrike(&rows[count], before.currentPlayer, before.balls[0].position, angle, speed);
+        CorpusShotResult(&rows[count++], outcome.pocketed, outcome.stateAfter);
+    }
+    job->counts[index] = count;
+}
+
+static int Synth(const char *out, int games, unsigned int seed) {
+    SynthJob job = { seed, 0, NULL, NULL };
+    job.rows = malloc(sizeof(CorpusShot) * SYNTH_BATCH * SYNTH_MAX_SHOTS);
+    job.counts = malloc(sizeof(int) * SYNTH_BATCH);
+    CorpusWriter w;
+    CorpusWriterInit(&w);
+
+    double start = NowSeconds();
+    for (int first = 0; first < games; first += SYNTH_BATCH) {
+        int n = games - first < SYNTH_BATCH ? games - first : SYNTH_BATCH;
+        job.firstGame = (unsigned int)first;
+        JobsParallelFor(n, PlaySynthGame, &job);
+        for (int g = 0; g < n; g++) CorpusAddGame(&w, job.rows + (size_t)g * SYNTH_MAX_SHOTS, job.counts[g]);
+    }
+    double seconds = NowSeconds() - start;
+
+    bool ok = CorpusWriterSave(&w, out);
+    printf("synth: %u games, %u shots in %.2f s on %d threads (%.0f shots/s) -> %s\n",
+           w.gameCount, w.shotCount, seconds, JobsThreadCount(), w.shotCount / seconds, out);
+    CorpusWriterFree(&w);
+    free(job.rows);
+    free(job.counts);
+    return ok ? 0 : 1;
+}
+
+// --- import ---
+
+// Replays a script the way the game would, rewind included, and keeps one
+// row per shot. Undo rewinds shotNumber, so a row is indexed by it and the
+// undone rows are dropped; the shot played again overwrites its row. A shot is complete when it comes to
+// rest, or when the next one is struck. The strike frame already steps the
+// physics once, so the cue ball and pocketed set are taken from before it.
+static bool ImportScript(const char *path, CorpusWriter *w) {
+    InputProvider input;
+    if (!ScriptInputOpen(&input, path, false)) return false;
+    RewindInit((size_t)REWIND_BUDGET_MB * 1024 * 1024);
+
+    static Game game;
+    static CorpusShot rows[SYNTH_MAX_SHOTS * 8];
+    const int capacity = (int)(sizeof(rows) / sizeof(rows[0]));
+    InitGame(&game);
+
+    int count = 0;          // finished rows of the current game
+    int open = -1;          // row of the shot in play
+    unsigned short openMask = 0;
+
+    InputFrame in;
+    while (input.poll(&input, &in)) {
+        if (in.keyReset) {
+            CorpusAddGame(w, rows, count);
+            count = 0;
+            open = -1;
+        }
+        int lastShot = game.shotNumber;
+        GameState lastState = game.state;
+        unsigned short lastMask = PocketedMask(&game);
+        Vector2 lastCue = game.balls[0].pocketed ? game.cueBallPos : game.balls[0].position;
+        UpdateGame(&game, &in);
+        if (game.scrubbing) continue;
+
+        if (game.shotNumber < lastShot) {
+            // Undone: the table is back before shot shotNumber + 1
+            if (count > game.shotNumber) count = game.shotNumber;
+            open = -1;
+            continue;
+        }
+        if (game.shotNumber > lastShot) {
+            if (open >= 0) {
+                // The previous shot never came to rest as far as the rules know
+                CorpusShotResult(&rows[open], lastMask & ~openMask, lastState);
+                count = open + 1;
+            }
+            open = game.shotNumber - 1 < capacity ? game.shotNumber - 1 : -1;
+            if (open >= 0) {
+                if (count > open) count = open;
+                openMask = lastMask;
+                CorpusShotStrike(&rows[open], game.shotStats.player, lastCue,
+                                 game.shotStats.shotAngle, game.shotStats.shotSpeed);
+            }
+        }
+        if (open >= 0 && !game.shotPending && game.shotNumber - 1 == open) {
+            CorpusShotResult(&rows[open], PocketedMask(&game) & ~openMask, game.state);
+            count = open + 1;
+            open = -1;
+        }
+    }
+    CorpusAddGame(w, rows, count);
+    input.close(&input);
+    RewindShutdown();
+    return true;
+}
+
+// --- query ---
+
+typedef struct {
+    bool breakOnly;
+    int player;             // -1: either
+    int scratch;            // -1: either, 0: clean shots only, 1: scratches only
+    bool pots;
+    float minSpeed, maxSpeed;
+    float near;             // > 0 needs the rebuilt table
+    bool verify;
+} Query;
+
+typedef struct {
+    long shots, games;
+    long scratches, potShots, balls;
+    long states[5];
+    long replayedGames, replayedShots, mismatches;
+} QueryResult;
+
+typedef struct {
+    const Corpus *corpus;
+    const Query *query;
+    QueryResult *results;   // one per chunk
+} QueryJob;
+
+static bool ColumnsMatch(const Query *q, const Corpus *c, unsigned int row, unsigned int first) {
+    if (q->breakOnly && row != first) return false;
+    if (q->player >= 0 && c->player[row] != q->player) return false;
+    if (q->scratch >= 0 && ((c->flags[row] & CORPUS_SCRATCH) != 0) != (q->scratch == 1)) return false;
+    if (q->pots && (c->pocketed[row] & ~1u) == 0) return false;
+    return c->speed[row] >= q->minSpeed && c->speed[row] <= q->maxSpeed;
+}
+
+static bool CueNearBall(const Game *table, float near) {
+    for (int i = 1; i < MAX_BALLS; i++) {
+        if (!table->balls[i].pocketed && Distance(table->balls[0].position, table->balls[i].position) < near) return true;
+    }
+    return false;
+}
+
+static void QueryChunk(int index, void *ctx) {
+    QueryJob *job = ctx;
+    const Corpus *c = job->corpus;
+    const Query *q = job->query;
+    QueryResult *r = &job->results[index];
+    memset(r, 0, sizeof(*r));
+
+    unsigned int g0 = (unsigned int)index * QUERY_CHUNK;
+    unsigned int g1 = g0 + QUERY_CHUNK < c->gameCount ? g0 + QUERY_CHUNK : c->gameCount;
+    Game table;
+
+    for (unsigned int g = g0; g < g1; g++) {
+        unsigned int first = c->gameFirst[g], end = c->gameFirst[g + 1];
+
+        // Replay only as far as the last row the columns let through
+        unsigned int replayEnd = first;
+        if (q->verify) {
+            replayEnd = end;
+        } else if (q->near > 0.0f) {
+            for (unsigned int row = first; row < end; row++) {
+                if (ColumnsMatch(q, c, row, first)) replayEnd = row + 1;
+            }
+        }
+        if (replayEnd > first) {
+            InitGame(&table);
+            table.headless = true;
+            r->replayedGames++;
+        }
+
+        bool matched = false;
+        for (unsigned int row = first; row < end; row++) {
+            bool match = ColumnsMatch(q, c, row, first);
+            if (row < replayEnd) {
+                if (q->near > 0.0f && match) {
+                    Vector2 cue = { c->cueX[row], c->cueY[row] };
+                    Game placed = table;
+                    if (placed.state == GAME_SCRATCH) PlaceCueBall(&placed, cue);
+                    match = CueNearBall(&placed, q->near);
+                }
+                unsigned short pocketed;
+                r->replayedShots++;
+                if (!CorpusReplayShot(c, row, &table, &pocketed)) {
+                    r->mismatches++;
+                    replayEnd = row + 1;        // the rest of the game cannot be rebuilt
+                } else if (q->verify && (pocketed != c->pocketed[row] || table.state != c->state[row])) {
+                    r->mismatches++;
+                }
+            } else if (q->near > 0.0f) {
+                match = false;
+            }
+            if (!match) continue;
+
+            matched = true;
+            r->shots++;
+            if (c->flags[row] & CORPUS_SCRATCH) r->scratches++;
+            unsigned int balls = c->pocketed[row] & ~1u;
+            if (balls) r->potShots++;
+            for (; balls; balls &= balls - 1) r->balls++;
+            if (c->state[row] < 5) r->states[c->state[row]]++;
+        }
+        if (matched) r->games++;
+    }
+}
+
+static double Percent(long part, long whole) {
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+static int RunQuery(const char *path, const Query *q) {
+    Corpus corpus;
+    if (!CorpusOpen(&corpus, path)) {
+        fprintf(stderr, "corpus: cannot open %s\n", path);
+        return 1;
+    }
+
+    int chunks = (int)((corpus.gameCount + QUERY_CHUNK - 1) / QUERY_CHUNK);
+    QueryJob job = { &corpus, q, calloc((size_t)(chunks > 0 ? chunks : 1), sizeof(QueryResult)) };
+    double start = NowSeconds();
+    JobsParallelFor(chunks, QueryChunk, &job);
+
+    // Merged in chunk order, so the totals do not depend on thread timing
+    QueryResult total = { 0 };
+    for (int i = 0; i < chunks; i++) {
+        const QueryResult *r = &job.results[i];
+        total.shots += r->shots;
+        total.games += r->games;
+        total.scratches += r->scratches;
+        total.potShots += r->potShots;
+        total.balls += r->balls;
+        for (int s = 0; s < 5; s++) total.states[s] += r->states[s];
+        total.replayedGames += r->replayedGames;
+        total.replayedShots += r->replayedShots;
+        total.mismatches += r->mismatches;
+    }
+    double seconds = NowSeconds() - start;
+
+    printf("corpus: %s, %u games, %u shots, %.1f MiB mapped\n", path, corpus.gameCount, corpus.shotCount,
+           corpus.file.size / (1024.0 * 1024.0));
+    printf("query: %ld shots in %ld games, %.2f ms on %d threads (%.1f M rows/s)\n", total.shots, total.games,
+           seconds * 1000.0, JobsThreadCount(), corpus.shotCount / seconds / 1e6);
+    printf("  shots per rack  %.2f\n", total.games > 0 ? (double)total.shots / total.games : 0.0);
+    printf("  scratch rate    %.2f%%\n", Percent(total.scratches, total.shots));
+    printf("  pot rate        %.2f%%\n", Percent(total.potShots, total.shots));
+    printf("  balls per shot  %.3f\n", total.shots > 0 ? (double)total.balls / total.shots : 0.0);
+    printf("  state after     playing %.1f%%, scratch %.1f%%, won %.1f%%, lost %.1f%%\n",
+           Percent(total.states[GAME_PLAYING], total.shots), Percent(total.states[GAME_SCRATCH], total.shots),
+           Percent(total.states[GAME_WON], total.shots), Percent(total.states[GAME_LOST], total.shots));
+    if (total.replayedGames > 0) {
+        printf("  rebuilt         %ld games, %ld shots replayed through the physics, %ld mismatches\n",
+               total.replayedGames, total.replayedShots, total.mismatches);
+    }
+
+    free(job.results);
+    CorpusClose(&corpus);
+    return q->verify && total.mismatches > 0 ? 1 : 0;
+}
+
+static void Usage(const char *name) {
+    fprintf(stderr, "usage: %s synth <out> <games> [seed] [threads]\n"
+                    "       %s import <out> <script>...\n"
+                    "       %s query <corpus> [--break] [--player n] [--scratch|--clean] [--pots]\n"
+                    "                [--speed min max] [--near px] [--verify] [threads]\n",
+            name, name, name);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        Usage(argv[0]);
+        return 1;
+    }
+    const char *mode = argv[1];
+
+    if (strcmp(mode, "synth") == 0 && argc >= 4) {
+        JobsInit(argc > 5 ? atoi(argv[5]) : 0);
+        int rc = Synth(argv[2], atoi(argv[3]), argc > 4 ? (unsigned int)strtoul(argv[4], NULL, 10) : 1u);
+        JobsShutdown();
+        return rc;
+    }
+
+    if (strcmp(mode, "import") == 0 && argc >= 4) {
+        CorpusWriter w;
+        CorpusWriterInit(&w);
+        for (int i = 3; i < argc; i++) {
+            if (!ImportScript(argv[i], &w)) fprintf(stderr, "corpus: cannot read %s\n", argv[i]);
+        }
+        bool ok = CorpusWriterSave(&w, argv[2]);
+        printf("import: %u games, %u shots from %d scripts -> %s\n", w.gameCount, w.shotCount, argc - 3, argv[2]);
+        CorpusWriterFree(&w);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(mode, "query") == 0) {
+        Query q = { false, -1, -1, false, 0.0f, 1e9f, 0.0f, false };
+        int threads = 0;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--break") == 0) q.breakOnly = true;
+            else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) q.player = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--scratch") == 0) q.scratch = 1;
+            else if (strcmp(argv[i], "--clean") == 0) q.scratch = 0;
+            else if (strcmp(argv[i], "--pots") == 0) q.pots = true;
+            else if (strcmp(argv[i], "--speed") == 0 && i + 2 < argc) {
+                q.minSpeed = (float)atof(argv[++i]);
+                q.maxSpeed = (float)atof(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--near") == 0 && i + 1 < argc) q.near = (float)atof(argv[++i]);
+            else if (strcmp(argv[i], "--verify") == 0) q.verify = true;
+            else threads = atoi(argv[i]);
+        }
+        JobsInit(threads);
+        int rc = RunQuery(argv[2], &q);
+        JobsShutdown();
+        return rc;
+    }
+
+    Usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,375 @@
+// Golden-trajectory harness: runs the same shots through every physics
+// kernel, diffs each frame against the first kernel and times them all, so a
+// change to the physics is checked for behaviour as well as speed.
+//
+//   pool_golden [shots] [seed] [tolerance]        random shots, chained from one table
+//   pool_golden --script <file> [tolerance]       the shots of an input script
+//
+// Every shot starts all kernels from the same table, so a difference in one
+// shot does not spill into the next. Kernels are listed in kernels[]; a new
+// optimized kernel only needs a GoldenKernel.
+
+#include "common.h"
+#include "game.h"
+#include "input.h"
+#include "script.h"
+#include "rewind.h"
+#include "utils.h"
+#include "golden.h"
+
+#define GOLDEN_MAX_FRAMES 4000          // a shot that runs longer is cut off
+#define GOLDEN_REPORT_SHOTS 8           // divergent shots described in detail, per kernel
+#define GOLDEN_TIMING_PASSES 3          // best of, for the timing table
+
+// --- The current game as a kernel ---
+
+static Game current;
+
+static void CurrentLoad(const GoldenState *s) {
+    InitGame(&current);
+    current.headless = true;
+    for (int i = 0; i < MAX_BALLS; i++) {
+        current.balls[i].position = s->position[i];
+        current.balls[i].velocity = s->velocity[i];
+        current.balls[i].pocketed = s->pocketed[i];
+    }
+    current.cueBallPos = s->cueBallPos;
+    current.state = (GameState)s->state;
+    current.currentPlayer = s->currentPlayer;
+    for (int p = 0; p < 2; p++) {
+        current.players[p].type = (PlayerType)s->playerType[p];
+        current.players[p].ballsRemaining = s->ballsRemaining[p];
+    }
+    current.firstShot = s->firstShot;
+    current.assignedTypes = s->typesAssigned;
+}
+
+static void CurrentShoot(float angle, float speed) {
+    TakeShot(&current, angle, speed);
+}
+
+static void CurrentStep(void) {
+    StepSimulation(&current);
+}
+
+static bool CurrentMoving(void) {
+    if (current.state != GAME_PLAYING && current.state != GAME_SCRATCH) return false;
+    return current.ballsMoving || AreBallsMoving(&current);
+}
+
+static void CurrentSave(GoldenState *s) {
+    for (int i = 0; i < MAX_BALLS; i++) {
+        s->position[i] = current.balls[i].position;
+        s->velocity[i] = current.balls[i].velocity;
+        s->pocketed[i] = current.balls[i].pocketed;
+    }
+    s->cueBallPos = current.cueBallPos;
+    s->state = (int)current.state;
+    s->currentPlayer = current.currentPlayer;
+    for (int p = 0; p < 2; p++) {
+        s->playerType[p] = (int)current.players[p].type;
+        s->ballsRemaining[p] = current.players[p].ballsRemaining;
+    }
+    s->firstShot = current.firstShot;
+    s->typesAssigned = current.assignedTypes;
+}
+
+static const GoldenKernel currentKernel = {
+    "current", CurrentLoad, CurrentShoot, CurrentStep, CurrentMoving, CurrentSave
+};
+
+// The first kernel is the reference the others are diffed against
+static const GoldenKernel *kernels[] = { &currentKernel, &previousKernel };
+#define KERNEL_COUNT ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+// --- Shot lists ---
+
+typedef struct {
+    GoldenState start;
+    float angle;
+    float speed;
+} GoldenShot;
+
+typedef struct {
+    GoldenShot *shots;
+    int count;
+    int capacity;
+} ShotList;
+
+static bool ShotListAdd(ShotList *list, const GoldenState *start, float angle, float speed) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        GoldenShot *grown = realloc(list->shots, sizeof(GoldenShot) * (size_t)capacity);
+        if (!grown) return false;
+        list->shots = grown;
+        list->capacity = capacity;
+    }
+    list->shots[list->count++] = (GoldenShot){ *start, angle, speed };
+    return true;
+}
+
+// Makes a finished table playable again the way the game would: a new rack
+// after a won or lost game, the cue ball back on its spot after a scratch
+static void Playable(GoldenState *s) {
+    if (s->state == GAME_WON || s->state == GAME_LOST) {
+        InitGame(&current);
+        CurrentSave(s);
+    }
+    if (s->state == GAME_SCRATCH) {
+        s->position[0] = s->cueBallPos;
+        s->velocity[0] = (Vector2){ 0, 0 };
+        s->pocketed[0] = false;
+        s->state = GAME_PLAYING;
+    }
+}
+
+static unsigned int Rand(unsigned int *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Each shot is played on the reference kernel to find where the next starts
+static void RandomShots(ShotList *list, int count, unsigned int seed) {
+    GoldenState s;
+    InitGame(&current);
+    CurrentSave(&s);
+    for (int n = 0; n < count; n++) {
+        Playable(&s);
+        float angle = (Rand(&seed) & 0xFFFF) / 65536.0f * 2.0f * PI;
+        float speed = 4.0f + (Rand(&seed) & 0xFFFF) / 65535.0f * (MAX_SHOT_SPEED - 4.0f);
+        ShotListAdd(list, &s, angle, speed);
+
+        CurrentLoad(&s);
+        CurrentShoot(angle, speed);
+        for (int f = 0; f < GOLDEN_MAX_FRAMES && CurrentMoving(); f++) CurrentStep();
+        CurrentSave(&s);
+    }
+}
+
+// Replays the script on the game and keeps the table as it was just before
+// each shot, together with the shot itself
+static bool ScriptShots(ShotList *list, const char *path) {
+    InputProvider input;
+    if (!ScriptInputOpen(&input, path, false)) return false;
+    RewindInit((size_t)REWIND_BUDGET_MB * 1024 * 1024);
+
+    static Game game, before;
+    InitGame(&game);
+    InputFrame frame;
+    while (input.poll(&input, &frame)) {
+        before = game;
+        UpdateGame(&game, &frame);
+        if (!before.shotPending && game.shotPending && !game.scrubbing) {
+            current = before;
+            GoldenState s;
+            CurrentSave(&s);
+            ShotListAdd(list, &s, game.shotStats.shotAngle, game.shotStats.shotSpeed);
+        }
+    }
+    input.close(&input);
+    RewindShutdown();
+    return list->count > 0;
+}
+
+// --- Comparison ---
+
+typedef struct {
+    int shots;
+    int within;             // every frame within tolerance and the same rules outcome
+    int positionDiffs;
+    int pocketDiffs;
+    int ruleDiffs;
+    int lengthDiffs;        // the shot ran a different number of frames
+    float maxError;
+    long divergenceFrames;  // sum over diverging shots of the first frame out of tolerance
+    int reported;
+} KernelDiff;
+
+static float MaxPositionError(const GoldenState *a, const GoldenState *b, int *ball) {
+    float worst = 0.0f;
+    for (int i = 0; i < GOLDEN_BALLS; i++) {
+        if (a->pocketed[i] || b->pocketed[i]) continue;
+        float e = Distance(a->position[i], b->position[i]);
+        if (e > worst) {
+            worst = e;
+            *ball = i;
+        }
+    }
+    return worst;
+}
+
+static unsigned int PocketMask(const GoldenState *s) {
+    unsigned int mask = 0;
+    for (int i = 0; i < GOLDEN_BALLS; i++) if (s->pocketed[i]) mask |= 1u << i;
+    return mask;
+}
+
+static bool SameRules(const GoldenState *a, const GoldenState *b) {
+    return a->state == b->state && a->currentPlayer == b->currentPlayer &&
+           a->playerType[0] == b->playerType[0] && a->playerType[1] == b->playerType[1] &&
+           a->ballsRemaining[0] == b->ballsRemaining[0] && a->ballsRemaining[1] == b->ballsRemaining[1] &&
+           a->typesAssigned == b->typesAssigned;
+}
+
+static const char *stateNames[] = { "start", "playing", "scratch", "won", "lost" };
+static const char *typeNames[] = { "none", "solids", "stripes" };
+
+static void DescribeRules(const GoldenState *s, char *out, size_t size) {
+    snprintf(out, size, "%s, player %d to play, %s/%s, %d/%d left", stateNames[s->state], s->currentPlayer + 1,
+             typeNames[s->playerType[0]], typeNames[s->playerType[1]], s->ballsRemaining[0], s->ballsRemaining[1]);
+}
+
+// Steps every kernel through one shot in lockstep, comparing each frame with
+// the reference. Each kernel keeps its own table between frames; kernels
+// that stop early hold their last frame.
+static void CompareShot(int index, const GoldenShot *shot, float tolerance, KernelDiff *diffs) {
+    static GoldenState frames[KERNEL_COUNT];
+    int firstOff[KERNEL_COUNT], offBall[KERNEL_COUNT], length[KERNEL_COUNT];
+    float worst[KERNEL_COUNT];
+
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        firstOff[k] = -1;
+        offBall[k] = 0;
+        length[k] = 0;
+        worst[k] = 0.0f;
+    }
+
+    bool running[KERNEL_COUNT];
+    for (int frame = 0; frame < GOLDEN_MAX_FRAMES; frame++) {
+        bool any = false;
+        for (int k = 0; k < KERNEL_COUNT; k++) {
+            const GoldenKernel *kernel = kernels[k];
+            if (frame == 0) {
+                kernel->load(&shot->start);
+                kernel->shoot(shot->angle, shot->speed);
+                running[k] = true;
+            }
+            if (running[k]) {
+                kernel->step();
+                length[k] = frame + 1;
+                running[k] = kernel->moving();
+            }
+            kernel->save(&frames[k]);
+            any |= running[k];
+        }
+
+        for (int k = 1; k < KERNEL_COUNT; k++) {
+            int ball = 0;
+            float e = MaxPositionError(&frames[0], &frames[k], &ball);
+            if (e > worst[k]) worst[k] = e;
+            if (firstOff[k] < 0 && (e > tolerance || PocketMask(&frames[0]) != PocketMask(&frames[k]))) {
+                firstOff[k] = frame;
+                offBall[k] = ball;
+            }
+        }
+        if (!any) break;
+    }
+
+    for (int k = 1; k < KERNEL_COUNT; k++) {
+        KernelDiff *d = &diffs[k];
+        bool pockets = PocketMask(&frames[0]) != PocketMask(&frames[k]);
+        bool rules = !SameRules(&frames[0], &frames[k]);
+        bool lengthOff = length[0] != length[k];
+
+        d->shots++;
+        if (worst[k] > d->maxError) d->maxError = worst[k];
+        if (firstOff[k] >= 0) {
+            d->positionDiffs++;
+            d->divergenceFrames += firstOff[k];
+        }
+        d->pocketDiffs += pockets;
+        d->ruleDiffs += rules;
+        d->lengthDiffs += lengthOff;
+        if (firstOff[k] < 0 && !rules && !lengthOff) {
+            d->within++;
+            continue;
+        }
+
+        if (d->reported++ >= GOLDEN_REPORT_SHOTS) continue;
+        printf("  %s shot %d (angle %.3f, speed %.2f):", kernels[k]->name, index + 1, shot->angle, shot->speed);
+        if (firstOff[k] >= 0) printf(" off from frame %d (ball %d), worst %.2f px;", firstOff[k], offBall[k], worst[k]);
+        if (lengthOff) printf(" %d frames vs %d;", length[k], length[0]);
+        if (pockets) printf(" pocketed %04x vs %04x;", PocketMask(&frames[k]), PocketMask(&frames[0]));
+        printf("\n");
+        if (rules) {
+            char mine[96], reference[96];
+            DescribeRules(&frames[k], mine, sizeof(mine));
+            DescribeRules(&frames[0], reference, sizeof(reference));
+            printf("    rules:     %s\n    reference: %s\n", mine, reference);
+        }
+    }
+}
+
+// --- Timing ---
+
+// Each kernel alone, whole shots at a time: only load and shoot sit outside the clock
+static void TimeKernel(const GoldenKernel *kernel, const ShotList *list, double *nsPerFrame, double *usPerShot) {
+    double best = 1e30;
+    long frames = 0;
+    for (int pass = 0; pass < GOLDEN_TIMING_PASSES; pass++) {
+        double seconds = 0.0;
+        frames = 0;
+        for (int n = 0; n < list->count; n++) {
+            kernel->load(&list->shots[n].start);
+            kernel->shoot(list->shots[n].angle, list->shots[n].speed);
+            double start = NowSeconds();
+            int f = 0;
+            do {
+                kernel->step();
+                f++;
+            } while (f < GOLDEN_MAX_FRAMES && kernel->moving());
+            seconds += NowSeconds() - start;
+            frames += f;
+        }
+        if (seconds < best) best = seconds;
+    }
+    *nsPerFrame = frames ? best / frames * 1e9 : 0.0;
+    *usPerShot = list->count ? best / list->count * 1e6 : 0.0;
+}
+
+int main(int argc, char **argv) {
+    ShotList list = { 0 };
+    float tolerance = 0.5f;
+    if (argc > 2 && strcmp(argv[1], "--script") == 0) {
+        if (!ScriptShots(&list, argv[2])) {
+            fprintf(stderr, "golden: no shots in %s\n", argv[2]);
+            return 1;
+        }
+        if (argc > 3) tolerance = (float)atof(argv[3]);
+    } else {
+        int count = argc > 1 ? atoi(argv[1]) : 200;
+        unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1u;
+        if (argc > 3) tolerance = (float)atof(argv[3]);
+        if (count <= 0) {
+            fprintf(stderr, "usage: %s [shots] [seed] [tolerance] | --script <file> [tolerance]\n", argv[0]);
+            return 1;
+        }
+        RandomShots(&list, count, seed);
+    }
+
+    printf("golden: %d shots, tolerance %.2f px, reference %s\n", list.count, tolerance, kernels[0]->name);
+    KernelDiff diffs[KERNEL_COUNT];
+    memset(diffs, 0, sizeof(diffs));
+    for (int n = 0; n < list.count; n++) CompareShot(n, &list.shots[n], tolerance, diffs);
+
+    printf("%-10s %8s %8s %8s %8s %8s %10s %12s %10s %10s\n", "kernel", "within", "paths", "pockets",
+           "rules", "lengths", "max px", "diverge at", "ns/frame", "us/shot");
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        double nsPerFrame, usPerShot;
+        TimeKernel(kernels[k], &list, &nsPerFrame, &usPerShot);
+        if (k == 0) {
+            printf("%-10s %8s %8s %8s %8s %8s %10s %12s %10.1f %10.2f\n", kernels[k]->name, "-", "-", "-", "-", "-",
+                   "-", "-", nsPerFrame, usPerShot);
+            continue;
+        }
+        const KernelDiff *d = &diffs[k];
+        char diverge[16] = "-";
+        if (d->positionDiffs) snprintf(diverge, sizeof(diverge), "%.1f", (double)d->divergenceFrames / d->positionDiffs);
+        printf("%-10s %7.1f%% %8d %8d %8d %8d %10.2f %12s %10.1f %10.2f\n", kernels[k]->name,
+               100.0 * d->within / d->shots, d->positionDiffs, d->pocketDiffs, d->ruleDiffs, d->lengthDiffs,
+               d->maxError, diverge, nsPerFrame, usPerShot);
+    }
+
+    free(list.shots);
+    return 0;
+}
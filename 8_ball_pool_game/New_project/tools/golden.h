@@ -0,0 +1,39 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+// Shared by pool_golden and the Previous_project adapter. It cannot include
+// common.h: both versions of the game define their own Game and Ball.
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#define GOLDEN_BALLS 16
+
+// A table between frames, in terms both versions understand. States and
+// player types use the enum order the two versions share.
+typedef struct {
+    Vector2 position[GOLDEN_BALLS];
+    Vector2 velocity[GOLDEN_BALLS];
+    bool pocketed[GOLDEN_BALLS];
+    Vector2 cueBallPos;
+    int state;
+    int currentPlayer;
+    int playerType[2];
+    int ballsRemaining[2];
+    bool firstShot;
+    bool typesAssigned;
+} GoldenState;
+
+// One physics implementation under test, holding a single table
+typedef struct {
+    const char *name;
+    void (*load)(const GoldenState *state);
+    void (*shoot)(float angle, float speed);
+    void (*step)(void);             // one frame: physics plus the rules that run with it
+    bool (*moving)(void);           // false once the shot is over
+    void (*save)(GoldenState *state);
+} GoldenKernel;
+
+extern const GoldenKernel previousKernel;
+
+#endif // GOLDEN_H
@@ -0,0 +1,91 @@
+// Previous_project/main.c compiled unchanged behind a GoldenKernel, so the
+// golden harness steps the old physics next to the new. Only the names that
+// would collide with the new game at link time are renamed.
+
+#define main PreviousMain
+#define ApplyScratch PreviousApplyScratch
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"     // DrawGm's aim angle
+#endif
+#include "../../Previous_project/main.c"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#undef main
+#undef ApplyScratch
+
+#include "golden.h"
+
+static Game previous;
+
+static void PreviousLoad(const GoldenState *s) {
+    InitGm(&previous);
+    for (int i = 0; i < MAX_BL; i++) {
+        previous.bls[i].pos = s->position[i];
+        previous.bls[i].vel = s->velocity[i];
+        previous.bls[i].pktd = s->pocketed[i];
+    }
+    previous.cueBPos = s->cueBallPos;
+    previous.state = (GmState)s->state;
+    previous.curPlr = s->currentPlayer;
+    for (int p = 0; p < 2; p++) {
+        previous.plrs[p].typ = (PlrType)s->playerType[p];
+        previous.plrs[p].blsLeft = s->ballsRemaining[p];
+    }
+    previous.frstShot = s->firstShot;
+    previous.typAssigned = s->typesAssigned;
+    previous.blsMoving = false;
+}
+
+// The release branch of HndlInput, given the shot instead of the mouse
+static void PreviousShoot(float angle, float speed) {
+    if (speed > MAX_SHT_SPD) speed = MAX_SHT_SPD;
+    previous.bls[0].vel.x = cosf(angle) * speed;
+    previous.bls[0].vel.y = sinf(angle) * speed;
+    previous.state = GM_PLAY;
+    previous.frstShot = false;
+}
+
+// UpdateGm without the input and stick recoil
+static void PreviousStep(void) {
+    if (previous.state != GM_PLAY && previous.state != GM_SCRATCH) return;
+    UpdatePhys(&previous);
+
+    if (!previous.blsMoving && BlsMoving(&previous)) previous.blsMoving = true;
+    if (previous.blsMoving && !BlsMoving(&previous)) {
+        previous.blsMoving = false;
+        if (previous.state == GM_PLAY) {
+            ChkWinCond(&previous);
+            if (previous.state != GM_WIN && previous.state != GM_LOSE) NxtTurn(&previous);
+        }
+    }
+}
+
+static bool PreviousMoving(void) {
+    if (previous.state != GM_PLAY && previous.state != GM_SCRATCH) return false;
+    return previous.blsMoving || BlsMoving(&previous);
+}
+
+static void PreviousSave(GoldenState *s) {
+    for (int i = 0; i < MAX_BL; i++) {
+        s->position[i] = previous.bls[i].pos;
+        s->velocity[i] = previous.bls[i].vel;
+        s->pocketed[i] = previous.bls[i].pktd;
+    }
+    s->cueBallPos = previous.cueBPos;
+    s->state = (int)previous.state;
+    s->currentPlayer = previous.curPlr;
+    for (int p = 0; p < 2; p++) {
+        s->playerType[p] = (int)previous.plrs[p].typ;
+        s->ballsRemaining[p] = previous.plrs[p].blsLeft;
+    }
+    s->firstShot = previous.frstShot;
+    s->typesAssigned = previous.typAssigned;
+}
+
+const GoldenKernel previousKernel = {
+    "previous", PreviousLoad, PreviousShoot, PreviousStep, PreviousMoving, PreviousSave
+};
@@ -0,0 +1,216 @@
+// Offline highlight clips: replays an input script headlessly, picks out one
+// shot and renders its frames on the CPU, in parallel across the job pool.
+// Needs no GPU and no window.
+//
+//   pool_highlight <script> <shot> <out> [png|raw] [threads]
+//
+// png writes <out>_0000.png, <out>_0001.png, ...; raw writes every frame to
+// <out>.rgba back to back, e.g. for
+//   ffmpeg -f rawvideo -pix_fmt rgba -s 800x400 -r 60 -i out.rgba out.mp4
+
+#include "common.h"
+#include "game.h"
+#include "input.h"
+#include "script.h"
+#include "rewind.h"
+#include "raster.h"
+#include "jobs.h"
+#include "utils.h"
+
+#define HIGHLIGHT_LEAD_FRAMES 30        // before the strike, while the shot is lined up
+#define HIGHLIGHT_TAIL_FRAMES 30        // after the balls come to rest
+
+// --- Capture ---
+
+typedef struct {
+    Game *frames;
+    int count;
+    int capacity;
+} Clip;
+
+static bool ClipAdd(Clip *clip, const Game *game) {
+    if (clip->count == clip->capacity) {
+        int capacity = clip->capacity ? clip->capacity * 2 : 512;
+        Game *grown = realloc(clip->frames, sizeof(Game) * (size_t)capacity);
+        if (!grown) return false;
+        clip->frames = grown;
+        clip->capacity = capacity;
+    }
+    clip->frames[clip->count++] = *game;
+    return true;
+}
+
+// Shots are counted from 1 in the order they are struck, as pool_soak counts
+// them; the script is replayed with rewind, so an undone shot and the one
+// struck again after it count as two
+static bool CaptureShot(const char *path, int shot, Clip *clip) {
+    InputProvider input;
+    if (!ScriptInputOpen(&input, path, false)) return false;
+    RewindInit((size_t)REWIND_BUDGET_MB * 1024 * 1024);
+
+    static Game game;
+    static Game lead[HIGHLIGHT_LEAD_FRAMES];
+    InitGame(&game);
+
+    long frame = 0;
+    int shots = 0;
+    int tail = -1;          // frames left to capture once at rest; -1 before the shot
+    InputFrame in;
+    while (input.poll(&input, &in)) {
+        bool wasPending = game.shotPending;
+        UpdateGame(&game, &in);
+        frame++;
+
+        if (!wasPending && game.shotPending && !game.scrubbing && ++shots == shot) {
+            long first = frame > HIGHLIGHT_LEAD_FRAMES ? frame - HIGHLIGHT_LEAD_FRAMES : 0;
+            for (long f = first; f < frame - 1; f++) ClipAdd(clip, &lead[f % HIGHLIGHT_LEAD_FRAMES]);
+            tail = HIGHLIGHT_TAIL_FRAMES;
+        }
+        if (shots == shot && tail >= 0) {
+            if (!ClipAdd(clip, &game)) break;
+            bool done = (!game.shotPending && !game.ballsMoving) ||
+                        game.state == GAME_WON || game.state == GAME_LOST;
+            if (done && tail-- == 0) break;
+        }
+        lead[(frame - 1) % HIGHLIGHT_LEAD_FRAMES] = game;
+    }
+    input.close(&input);
+    RewindShutdown();
+    return clip->count > 0;
+}
+
+// --- Rendering ---
+
+typedef struct {
+    const Game *frames;
+    int first;              // clip frame of job index 0
+    Canvas *canvases;       // one per job index (raw) or NULL (png: each job owns one)
+    const char *out;
+    double *rasterSeconds;  // per clip frame
+    double *encodeSeconds;  // png: per clip frame; raw: per batch, at its first frame
+    _Atomic int failed;
+} RenderJob;
+
+static void RenderPng(int index, void *ctx) {
+    RenderJob *job = ctx;
+    int f = job->first + index;
+
+    Canvas canvas;
+    if (!CanvasInit(&canvas, TABLE_WIDTH, TABLE_HEIGHT)) {
+        job->failed++;
+        return;
+    }
+    double start = NowSeconds();
+    RasterDrawFrame(&canvas, &job->frames[f]);
+    double drawn = NowSeconds();
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s_%04d.png", job->out, f);
+    Image image = { canvas.pixels, canvas.width, canvas.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    if (!ExportImage(image, path)) job->failed++;
+
+    job->rasterSeconds[f] = drawn - start;
+    job->encodeSeconds[f] = NowSeconds() - drawn;
+    CanvasFree(&canvas);
+}
+
+static void RenderRaw(int index, void *ctx) {
+    RenderJob *job = ctx;
+    int f = job->first + index;
+    double start = NowSeconds();
+    RasterDrawFrame(&job->canvases[index], &job->frames[f]);
+    job->rasterSeconds[f] = NowSeconds() - start;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <script> <shot> <out> [png|raw] [threads]\n", argv[0]);
+        return 1;
+    }
+    const char *script = argv[1];
+    int shot = atoi(argv[2]);
+    const char *out = argv[3];
+    bool raw = argc > 4 && strcmp(argv[4], "raw") == 0;
+    JobsInit(argc > 5 ? atoi(argv[5]) : 0);
+    int threads = JobsThreadCount();
+
+    Clip clip = { 0 };
+    if (!CaptureShot(script, shot, &clip)) {
+        fprintf(stderr, "highlight: no shot %d in %s\n", shot, script);
+        free(clip.frames);
+        JobsShutdown();
+        return 1;
+    }
+
+    RenderJob job = { clip.frames, 0, NULL, out, NULL, NULL, 0 };
+    job.rasterSeconds = calloc((size_t)clip.count, sizeof(double));
+    job.encodeSeconds = calloc((size_t)clip.count, sizeof(double));
+    if (!job.rasterSeconds || !job.encodeSeconds) {
+        fprintf(stderr, "highlight: out of memory\n");
+        free(job.rasterSeconds);
+        free(job.encodeSeconds);
+        free(clip.frames);
+        JobsShutdown();
+        return 1;
+    }
+
+    double start = NowSeconds();
+    if (!raw) {
+        JobsParallelFor(clip.count, RenderPng, &job);
+    } else {
+        char path[512];
+        snprintf(path, sizeof(path), "%s.rgba", out);
+        FILE *f = fopen(path, "wb");
+
+        // Frames are rendered a batch at a time and written in order
+        int batch = threads * 4;
+        job.canvases = f ? calloc((size_t)batch, sizeof(Canvas)) : NULL;
+        bool ready = job.canvases != NULL;
+        for (int i = 0; ready && i < batch; i++) ready = CanvasInit(&job.canvases[i], TABLE_WIDTH, TABLE_HEIGHT);
+        if (!ready) {
+            if (f) fprintf(stderr, "highlight: out of memory\n");
+            else fprintf(stderr, "highlight: cannot write %s\n", path);
+            for (int i = 0; job.canvases && i < batch; i++) CanvasFree(&job.canvases[i]);
+            free(job.canvases);
+            if (f) fclose(f);
+            free(job.rasterSeconds);
+            free(job.encodeSeconds);
+            free(clip.frames);
+            JobsShutdown();
+            return 1;
+        }
+        for (job.first = 0; job.first < clip.count; job.first += batch) {
+            int count = clip.count - job.first < batch ? clip.count - job.first : batch;
+            JobsParallelFor(count, RenderRaw, &job);
+            double written = NowSeconds();
+            for (int i = 0; i < count; i++) {
+                size_t bytes = sizeof(Color) * (size_t)TABLE_WIDTH * TABLE_HEIGHT;
+                if (fwrite(job.canvases[i].pixels, 1, bytes, f) != bytes) job.failed++;
+            }
+            job.encodeSeconds[job.first] = NowSeconds() - written;
+        }
+        for (int i = 0; i < batch; i++) CanvasFree(&job.canvases[i]);
+        free(job.canvases);
+        fclose(f);
+    }
+    double seconds = NowSeconds() - start;
+
+    double raster = 0.0, encode = 0.0;
+    for (int i = 0; i < clip.count; i++) {
+        raster += job.rasterSeconds[i];
+        encode += job.encodeSeconds[i];
+    }
+    printf("highlight: shot %d, %d frames %dx%d to %s%s\n", shot, clip.count, TABLE_WIDTH, TABLE_HEIGHT,
+           out, raw ? ".rgba" : "_####.png");
+    printf("%.3f s on %d threads: %.1f fps, %.1f fps per core "
+           "(raster %.2f ms/frame, %s %.2f ms/frame)\n",
+           seconds, threads, clip.count / seconds, clip.count / seconds / threads,
+           raster / clip.count * 1000.0, raw ? "write" : "png", encode / clip.count * 1000.0);
+    if (job.failed) fprintf(stderr, "highlight: %d frames failed\n", (int)job.failed);
+
+    free(job.rasterSeconds);
+    free(job.encodeSeconds);
+    free(clip.frames);
+    JobsShutdown();
+    return job.failed ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+// Builds and measures the solved-layout library that layouts.c searches:
+// self-play positions, each solved by the full shot search, written in k-d
+// tree order.
+//
+//   pool_layouts build [out.bin] [positions]            self-play, solve, index, write
+//   pool_layouts bench [layouts.bin] [layouts] [queries]
+//       index build time, query latency and memory over a synthetic library
+//       of the given size (jittered copies of the file's layouts), then, with
+//       a file, how the nearest layouts' shots play on fresh positions
+
+#include "common.h"
+#include "game.h"
+#include "sim.h"
+#include "ai.h"
+#include "cache.h"
+#include "layouts.h"
+#include "jobs.h"
+#include "utils.h"
+
+#define SELFPLAY_GREEDY 0.7f        // share of best shots in self-play; the rest are random
+#define BENCH_JITTER 12.0f          // pixels each synthetic layout's balls move from their source
+
+static unsigned long long rngState = 0x853C49E6748FEA9Bull;
+
+// --- Self-play ---
+
+// Mid-game positions (the break is left to the break atlas), each with the
+// full search's best shot; play goes on with that shot or, now and then, a
+// random one, so the library also covers the tables a miss leaves
+static int SolvePositions(Game *games, ShotChoice *solved, int count, unsigned long long seed) {
+    static SelfPlay play;
+    SelfPlayInit(&play, seed, SELFPLAY_GREEDY);
+    double start = NowSeconds();
+    int n = 0;
+    while (n < count) {
+        const Game *game = SelfPlayPosition(&play);
+        ShotChoice best;
+        if (!SearchShot(game, &best, NULL)) {
+            SelfPlayRestart(&play);
+            continue;
+        }
+        if (game->state == GAME_PLAYING) {
+            games[n] = *game;
+            solved[n] = best;
+            n++;
+            if (n % (count / 20 + 1) == 0) fprintf(stderr, "  %3d%% (%.1f s)\n", n * 100 / count, NowSeconds() - start);
+        }
+        SelfPlayShot(&play, best.angle, best.speed);
+    }
+    ShotCacheClear();
+    return n;
+}
+
+static void FillRecord(LayoutRecord *r, const Game *game, const ShotChoice *best) {
+    bool flipX, flipY;
+    memset(r, 0, sizeof(*r));
+    LayoutKey(game, r->key, &flipX, &flipY);
+    r->angle = LayoutMirrorAngle(best->angle, flipX, flipY);
+    r->speed = best->speed;
+    r->score = best->score;
+    r->type = (unsigned char)game->players[game->currentPlayer].type;
+}
+
+static int Build(const char *path, int positions) {
+    Game *games = malloc(sizeof(Game) * (size_t)positions);
+    ShotChoice *solved = malloc(sizeof(ShotChoice) * (size_t)positions);
+    LayoutRecord *records = malloc(sizeof(LayoutRecord) * (size_t)positions);
+    if (!games || !solved || !records) return 1;
+
+    fprintf(stderr, "solving %d self-play positions on %d threads\n", positions, JobsThreadCount());
+    int count = SolvePositions(games, solved, positions, 0x2545F4914F6CDD1Dull);
+    for (int i = 0; i < count; i++) FillRecord(&records[i], &games[i], &solved[i]);
+    free(games);
+    free(solved);
+
+    LayoutIndex index;
+    double start = NowSeconds();
+    if (!LayoutIndexBuild(&index, records, count)) return 1;
+    double seconds = NowSeconds() - start;
+    bool ok = LayoutIndexWrite(&index, path);
+    if (ok) {
+        printf("wrote %s: %d layouts (%u open, %u solids, %u stripes), %zu bytes, indexed in %.1f ms\n",
+               path, count,
+               index.header->typeStart[1] - index.header->typeStart[0],
+               index.header->typeStart[2] - index.header->typeStart[1],
+               index.header->typeStart[3] - index.header->typeStart[2],
+               LayoutIndexBytes(&index), seconds * 1000.0);
+    } else {
+        fprintf(stderr, "layouts: cannot write %s\n", path);
+    }
+    LayoutIndexClose(&index);
+    return ok ? 0 : 1;
+}
+
+// --- Benchmarks ---
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static unsigned short Jitter(unsigned short v, float limit) {
+    if (v == 0) return 0;               // pocketed stays pocketed
+    float moved = v + (RandomFloat(&rngState) * 2.0f - 1.0f) * BENCH_JITTER * LAYOUT_QUANT;
+    return (unsigned short)fmaxf(1.0f, fminf(moved, limit));
+}
+
+// A library of count layouts near the file's ones, or uniform over the
+// cloth without a file, with a random ball pocketed now and then
+static void Synthesize(LayoutRecord *out, int count, const LayoutIndex *source) {
+    int sourceCount = source ? (int)source->header->recordCount : 0;
+    for (int i = 0; i < count; i++) {
+        LayoutRecord *r = &out[i];
+        if (sourceCount > 0) {
+            *r = source->records[RandomNext(&rngState) % (unsigned int)sourceCount];
+        } else {
+            memset(r, 0, sizeof(*r));
+            for (int b = 0; b < MAX_BALLS; b++) {
+                r->key[2 * b]     = (unsigned short)(1 + RandomFloat(&rngState) * TABLE_WIDTH * LAYOUT_QUANT);
+                r->key[2 * b + 1] = (unsigned short)(1 + RandomFloat(&rngState) * TABLE_HEIGHT * LAYOUT_QUANT);
+            }
+            r->type = (unsigned char)(RandomNext(&rngState) % LAYOUT_TYPES);
+        }
+        for (int b = 0; b < MAX_BALLS; b++) {
+            r->key[2 * b]     = Jitter(r->key[2 * b], TABLE_WIDTH * LAYOUT_QUANT);
+            r->key[2 * b + 1] = Jitter(r->key[2 * b + 1], TABLE_HEIGHT * LAYOUT_QUANT);
+        }
+        int extra = 1 + (int)(RandomNext(&rngState) % (MAX_BALLS - 1));
+        if (RandomNext(&rngState) % 4 == 0) r->key[2 * extra] = r->key[2 * extra + 1] = 0;
+    }
+}
+
+static unsigned long long BruteNearest(const LayoutIndex *index, const unsigned short *key, int type) {
+    unsigned long long best = ~0ull;
+    for (unsigned int i = index->header->typeStart[type]; i < index->header->typeStart[type + 1]; i++) {
+        unsigned long long sum = 0;
+        for (int d = 0; d < LAYOUT_DIMS; d++) {
+            long long diff = (long long)key[d] - index->records[i].key[d];
+            sum += (unsigned long long)(diff * diff);
+        }
+        if (sum < best) best = sum;
+    }
+    return best;
+}
+
+// Build time, memory and query latency at size, the tree against a linear scan
+static void BenchScale(const LayoutIndex *source, int size, int queries) {
+    LayoutRecord *records = malloc(sizeof(LayoutRecord) * (size_t)size);
+    LayoutRecord *probes = malloc(sizeof(LayoutRecord) * (size_t)queries);
+    double *micros = malloc(sizeof(double) * (size_t)queries);
+    if (!records || !probes || !micros) {
+        free(records);
+        free(probes);
+        free(micros);
+        return;
+    }
+    rngState = 0x853C49E6748FEA9Bull;
+    Synthesize(records, size, source);
+    Synthesize(probes, queries, source);
+
+    LayoutIndex index;
+    double start = NowSeconds();
+    if (!LayoutIndexBuild(&index, records, size)) {
+        free(probes);
+        free(micros);
+        return;
+    }
+    double buildSeconds = NowSeconds() - start;
+    size_t bytes = LayoutIndexBytes(&index);
+
+    // The linear scan is the reference, on a subset since it is slow
+    int scanned = queries < 200 ? queries : 200;
+    unsigned long long *brute = malloc(sizeof(unsigned long long) * (size_t)scanned);
+    if (!brute) {
+        LayoutIndexClose(&index);
+        free(probes);
+        free(micros);
+        return;
+    }
+    start = NowSeconds();
+    for (int q = 0; q < scanned; q++) brute[q] = BruteNearest(&index, probes[q].key, probes[q].type);
+    double scanMicros = (NowSeconds() - start) * 1e6 / scanned;
+
+    printf("%d layouts (%s): build %.0f ms, %.1f MB (%.1f MB per million); linear scan %.1f us\n",
+           size, source ? "jittered library" : "uniform", buildSeconds * 1000.0,
+           bytes / 1048576.0, bytes / 1048576.0 * 1e6 / size, scanMicros);
+
+    int budgets[2] = { 0, LAYOUT_MAX_VISITS };
+    for (int b = 0; b < 2; b++) {
+        LayoutQueryStats stats = { 0 };
+        int exact = 0;
+        double ratio = 0.0;
+        for (int q = 0; q < queries; q++) {
+            LayoutMatch match;
+            start = NowSeconds();
+            int found = LayoutIndexNearestKey(&index, probes[q].key, probes[q].type, &match, 1, budgets[b], &stats);
+            micros[q] = (NowSeconds() - start) * 1e6;
+            if (q >= scanned || found == 0) continue;
+            float truth = sqrtf((float)brute[q]) / LAYOUT_QUANT;
+            if (match.distance <= truth + 1e-3f) exact++;
+            ratio += truth > 0.0f ? match.distance / truth : 1.0f;
+        }
+        qsort(micros, (size_t)queries, sizeof(double), CompareDoubles);
+        double sum = 0.0;
+        for (int q = 0; q < queries; q++) sum += micros[q];
+        char label[32];
+        if (budgets[b] == 0) snprintf(label, sizeof(label), "exact");
+        else snprintf(label, sizeof(label), "%d visits", budgets[b]);
+        printf("  %-12s mean %7.1f us, median %7.1f us, p99 %7.1f us; %6.0f nodes; true nearest %d/%d, %.3fx its distance\n",
+               label, sum / queries, micros[queries / 2], micros[queries * 99 / 100],
+               (double)stats.visited / queries, exact, scanned, ratio / scanned);
+    }
+    free(brute);
+
+    LayoutIndexClose(&index);
+    free(probes);
+    free(micros);
+}
+
+// Fresh positions: the nearest layouts' shots, verified on the live table,
+// against the live table's own full search
+static void BenchPlay(int queries) {
+    Game *games = malloc(sizeof(Game) * (size_t)queries);
+    ShotChoice *solved = malloc(sizeof(ShotChoice) * (size_t)queries);
+    if (!games || !solved) {
+        free(games);
+        free(solved);
+        return;
+    }
+    fprintf(stderr, "solving %d fresh positions\n", queries);
+    int count = SolvePositions(games, solved, queries, 0xA0761D6478BD642Full);
+
+    double distance = 0.0, seconds = 0.0, borrowedScore = 0.0, searchScore = 0.0;
+    int borrowedPots = 0, searchPots = 0, matched = 0;
+    for (int i = 0; i < count; i++) {
+        LayoutMatch match;
+        if (LayoutIndexNearest(GetLayoutIndex(), &games[i], &match, 1, NULL) > 0) {
+            distance += match.distance;
+            matched++;
+        }
+
+        ShotChoice choice;
+        SearchStats stats = { 0 };
+        SearchShotLayouts(&games[i], &choice, &stats);
+        seconds += stats.seconds;
+        borrowedScore += choice.score;
+        borrowedPots += choice.score > 0.0f;
+        searchScore += solved[i].score;
+        searchPots += solved[i].score > 0.0f;
+    }
+    if (count == 0) {
+        printf("no fresh positions solved\n");
+        free(games);
+        free(solved);
+        return;
+    }
+    if (matched > 0) printf("%d fresh positions: nearest layout %.1f px away on average\n", count, distance / matched);
+    else printf("%d fresh positions: no layout of the shooter's type in the library\n", count);
+    printf("  %d nearest shots, verified: %.2f ms, mean score %.2f, clean pot %.1f%%\n",
+           LAYOUT_NEIGHBOURS, seconds * 1000.0 / count, borrowedScore / count, 100.0 * borrowedPots / count);
+    printf("  full search:               mean score %.2f, clean pot %.1f%%\n",
+           searchScore / count, 100.0 * searchPots / count);
+    free(games);
+    free(solved);
+}
+
+int main(int argc, char **argv) {
+    const char *mode = argc > 1 ? argv[1] : "";
+    const char *path = argc > 2 ? argv[2] : LAYOUT_INDEX_PATH;
+    JobsInit(0);
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+
+    int result = 2;
+    if (strcmp(mode, "build") == 0) {
+        result = Build(path, argc > 3 ? atoi(argv[3]) : 2000);
+    } else if (strcmp(mode, "bench") == 0) {
+        bool loaded = LayoutIndexLoadDefault(path);
+        if (!loaded) fprintf(stderr, "layouts: no library at %s; benchmarking uniform layouts only\n", path);
+        int size = argc > 3 ? atoi(argv[3]) : 1000000;
+        int queries = argc > 4 ? atoi(argv[4]) : 1000;
+        BenchScale(GetLayoutIndex(), size > 0 ? size : 1, queries > 0 ? queries : 1);
+        if (loaded) BenchPlay(queries < 100 ? queries : 100);
+        result = 0;
+    } else {
+        fprintf(stderr, "usage: %s build [out.bin] [positions] | bench [layouts.bin] [layouts] [queries]\n", argv[0]);
+    }
+    ShotCacheShutdown();
+    JobsShutdown();
+    return result;
+}
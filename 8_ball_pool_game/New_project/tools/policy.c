@@ -0,0 +1,512 @@
+// Trains the learned shot policy that policy.c runs: positions come from
+// self-play, each labelled by scoring every shot of the search grid, and a
+// small float network is fitted to the softened scores, then quantized to
+// int8 and written in the format PolicyOpen maps.
+//
+//   pool_policy train [out.bin] [positions] [epochs]   self-play, label, fit, quantize, write
+//   pool_policy eval [weights.bin] [positions]          decision time and agreement with the full search
+
+#include "common.h"
+#include "game.h"
+#include "sim.h"
+#include "ai.h"
+#include "cache.h"
+#include "placement.h"
+#include "policy.h"
+#include "jobs.h"
+#include "utils.h"
+#include <stdatomic.h>
+
+#define TRAIN_TEMPERATURE 0.25f     // score units per e-fold of target probability
+#define TRAIN_SCORE_CLAMP 10.0f     // a won game is not worth more than a few pots
+#define TRAIN_BATCH 32
+#define TRAIN_RATE 1e-3f
+#define TRAIN_GREEDY 0.7f           // self-play share of best shots; the rest are random
+#define TRAIN_LAYERS 3
+
+static const int layerWidths[TRAIN_LAYERS + 1] = { POLICY_INPUTS, POLICY_HIDDEN, POLICY_HIDDEN, POLICY_OUTPUTS };
+
+// --- Positions ---
+
+typedef struct {
+    int count;
+    Game *games;
+    float (*features)[POLICY_INPUTS];
+    float (*scores)[POLICY_OUTPUTS];
+} Dataset;
+
+static unsigned long long rngState = 0x94D049BB133111EBull;
+
+typedef struct {
+    const Game *game;
+    unsigned long long stateHash;
+    float *scores;
+    atomic_int simulated;
+} LabelJob;
+
+// The same shot, cache bucket and score as SearchShot's grid
+static void LabelOne(int index, void *ctx) {
+    LabelJob *job = ctx;
+    float angle = (float)(index % SEARCH_ANGLE_STEPS) * (2.0f * PI / SEARCH_ANGLE_STEPS);
+    float speed = MAX_SHOT_SPEED * (float)(index / SEARCH_ANGLE_STEPS + 1) / SEARCH_POWER_STEPS;
+    ShotCacheCanonical(&angle, &speed);
+
+    ShotOutcome outcome;
+    unsigned long long key = ShotCacheKey(job->stateHash, angle, speed);
+    if (!ShotCacheLookup(key, &outcome)) {
+        SimulateShot(job->game, angle, speed, NULL, &outcome);
+        ShotCacheStore(key, &outcome);
+        atomic_fetch_add(&job->simulated, 1);
+    }
+    job->scores[index] = ScoreOutcome(job->game, &outcome) - 0.05f * speed / MAX_SHOT_SPEED;
+}
+
+static void Label(const Game *game, float scores[POLICY_OUTPUTS]) {
+    LabelJob job = { game, StateHash(game), scores, 0 };
+    JobsParallelFor(POLICY_OUTPUTS, LabelOne, &job);
+}
+
+static int BestIndex(const float *scores) {
+    int best = 0;
+    for (int i = 1; i < POLICY_OUTPUTS; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    return best;
+}
+
+// Self-play that mostly takes the best grid shot, so positions look like
+// the ones the computer player meets, with enough random shots to cover the
+// misses a human leaves behind
+static bool Generate(Dataset *data, int count, unsigned long long seed) {
+    data->count = 0;
+    data->games = malloc(sizeof(Game) * (size_t)count);
+    data->features = malloc(sizeof(*data->features) * (size_t)count);
+    data->scores = malloc(sizeof(*data->scores) * (size_t)count);
+    if (!data->games || !data->features || !data->scores) return false;
+
+    static SelfPlay play;
+    SelfPlayInit(&play, seed, TRAIN_GREEDY);
+    double start = NowSeconds();
+    while (data->count < count) {
+        const Game *game = SelfPlayPosition(&play);
+        int n = data->count++;
+        data->games[n] = *game;
+        PolicyEncode(game, data->features[n]);
+        Label(game, data->scores[n]);
+
+        int index = BestIndex(data->scores[n]);
+        float angle = (float)(index % SEARCH_ANGLE_STEPS) * (2.0f * PI / SEARCH_ANGLE_STEPS);
+        float speed = MAX_SHOT_SPEED * (float)(index / SEARCH_ANGLE_STEPS + 1) / SEARCH_POWER_STEPS;
+        ShotCacheCanonical(&angle, &speed);
+        SelfPlayShot(&play, angle, speed);
+
+        if (data->count % (count / 20 + 1) == 0) {
+            fprintf(stderr, "  %3d%% (%.1f s)\n", data->count * 100 / count, NowSeconds() - start);
+        }
+    }
+    ShotCacheClear();
+    return true;
+}
+
+static void FreeDataset(Dataset *data) {
+    free(data->games);
+    free(data->features);
+    free(data->scores);
+    memset(data, 0, sizeof(*data));
+}
+
+// The table is symmetric about both centre lines: flipping y maps angle a to
+// -a, flipping x maps it to pi - a, and the rules do not care
+static int MirrorIndex(int index, bool flipX, bool flipY) {
+    int a = index % SEARCH_ANGLE_STEPS, p = index / SEARCH_ANGLE_STEPS;
+    if (flipY) a = (SEARCH_ANGLE_STEPS - a) % SEARCH_ANGLE_STEPS;
+    if (flipX) a = (SEARCH_ANGLE_STEPS / 2 - a + SEARCH_ANGLE_STEPS) % SEARCH_ANGLE_STEPS;
+    return p * SEARCH_ANGLE_STEPS + a;
+}
+
+static void Mirror(const float *features, const float *scores, int variant, float *outFeatures, float *outScores) {
+    bool flipX = variant & 1, flipY = variant & 2;
+    memcpy(outFeatures, features, sizeof(float) * POLICY_INPUTS);
+    for (int i = 0; i < MAX_BALLS; i++) {
+        if (flipX) outFeatures[3 * i] = -outFeatures[3 * i] + 0.0f;
+        if (flipY) outFeatures[3 * i + 1] = -outFeatures[3 * i + 1] + 0.0f;
+    }
+    for (int i = 0; i < POLICY_OUTPUTS; i++) outScores[MirrorIndex(i, flipX, flipY)] = scores[i];
+}
+
+// --- Float network ---
+
+typedef struct {
+    int inputs, outputs;
+    float *w, *b;                   // w[outputs][inputs]
+    float *gw, *gb;
+    float *mw, *vw, *mb, *vb;       // Adam moments
+} Dense;
+
+typedef struct {
+    Dense layers[TRAIN_LAYERS];
+    float *act[TRAIN_LAYERS + 1];   // act[0] is the input
+    float *delta[TRAIN_LAYERS + 1];
+    long step;
+} Network;
+
+static float RandomNormal(void) {
+    float u = RandomFloat(&rngState) + 1e-7f, v = RandomFloat(&rngState);
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * PI * v);
+}
+
+static void NetworkInit(Network *net) {
+    memset(net, 0, sizeof(*net));
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        Dense *d = &net->layers[l];
+        d->inputs = layerWidths[l];
+        d->outputs = layerWidths[l + 1];
+        size_t n = (size_t)d->inputs * d->outputs;
+        d->w = malloc(sizeof(float) * n);
+        d->gw = calloc(n, sizeof(float));
+        d->mw = calloc(n, sizeof(float));
+        d->vw = calloc(n, sizeof(float));
+        d->b = calloc(d->outputs, sizeof(float));
+        d->gb = calloc(d->outputs, sizeof(float));
+        d->mb = calloc(d->outputs, sizeof(float));
+        d->vb = calloc(d->outputs, sizeof(float));
+        float spread = sqrtf(2.0f / d->inputs);
+        for (size_t i = 0; i < n; i++) d->w[i] = RandomNormal() * spread;
+    }
+    for (int l = 0; l <= TRAIN_LAYERS; l++) {
+        net->act[l] = calloc(layerWidths[l], sizeof(float));
+        net->delta[l] = calloc(layerWidths[l], sizeof(float));
+    }
+}
+
+static void NetworkFree(Network *net) {
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        Dense *d = &net->layers[l];
+        free(d->w); free(d->gw); free(d->mw); free(d->vw);
+        free(d->b); free(d->gb); free(d->mb); free(d->vb);
+    }
+    for (int l = 0; l <= TRAIN_LAYERS; l++) {
+        free(net->act[l]);
+        free(net->delta[l]);
+    }
+}
+
+static const float *NetworkForward(Network *net, const float *features) {
+    memcpy(net->act[0], features, sizeof(float) * POLICY_INPUTS);
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        const Dense *d = &net->layers[l];
+        const float *x = net->act[l];
+        float *y = net->act[l + 1];
+        for (int o = 0; o < d->outputs; o++) {
+            const float *w = d->w + (size_t)o * d->inputs;
+            float sum = d->b[o];
+            for (int i = 0; i < d->inputs; i++) sum += w[i] * x[i];
+            y[o] = l + 1 < TRAIN_LAYERS && sum < 0.0f ? 0.0f : sum;
+        }
+    }
+    return net->act[TRAIN_LAYERS];
+}
+
+// Softmax cross-entropy against target probabilities; accumulates gradients
+// and returns the loss
+static float NetworkBackward(Network *net, const float *target) {
+    const float *logits = net->act[TRAIN_LAYERS];
+    float *delta = net->delta[TRAIN_LAYERS];
+    float top = logits[0];
+    for (int o = 1; o < POLICY_OUTPUTS; o++) top = fmaxf(top, logits[o]);
+    float sum = 0.0f;
+    for (int o = 0; o < POLICY_OUTPUTS; o++) sum += expf(logits[o] - top);
+    float loss = 0.0f;
+    for (int o = 0; o < POLICY_OUTPUTS; o++) {
+        float logp = logits[o] - top - logf(sum);
+        delta[o] = expf(logp) - target[o];
+        loss -= target[o] * logp;
+    }
+
+    for (int l = TRAIN_LAYERS - 1; l >= 0; l--) {
+        Dense *d = &net->layers[l];
+        const float *x = net->act[l];
+        const float *dy = net->delta[l + 1];
+        float *dx = net->delta[l];
+        memset(dx, 0, sizeof(float) * d->inputs);
+        for (int o = 0; o < d->outputs; o++) {
+            if (dy[o] == 0.0f) continue;
+            const float *w = d->w + (size_t)o * d->inputs;
+            float *gw = d->gw + (size_t)o * d->inputs;
+            d->gb[o] += dy[o];
+            for (int i = 0; i < d->inputs; i++) {
+                gw[i] += dy[o] * x[i];
+                dx[i] += dy[o] * w[i];
+            }
+        }
+        // Through the ReLU that produced this layer's input
+        if (l > 0) {
+            for (int i = 0; i < d->inputs; i++) {
+                if (x[i] <= 0.0f) dx[i] = 0.0f;
+            }
+        }
+    }
+    return loss;
+}
+
+static void AdamStep(float *p, float *g, float *m, float *v, size_t n, float rate, float scale) {
+    for (size_t i = 0; i < n; i++) {
+        float grad = g[i] * scale;
+        m[i] = 0.9f * m[i] + 0.1f * grad;
+        v[i] = 0.999f * v[i] + 0.001f * grad * grad;
+        p[i] -= rate * m[i] / (sqrtf(v[i]) + 1e-8f);
+        g[i] = 0.0f;
+    }
+}
+
+static void NetworkUpdate(Network *net, int batch) {
+    net->step++;
+    float rate = TRAIN_RATE * sqrtf(1.0f - powf(0.999f, (float)net->step)) / (1.0f - powf(0.9f, (float)net->step));
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        Dense *d = &net->layers[l];
+        AdamStep(d->w, d->gw, d->mw, d->vw, (size_t)d->inputs * d->outputs, rate, 1.0f / batch);
+        AdamStep(d->b, d->gb, d->mb, d->vb, d->outputs, rate, 1.0f / batch);
+    }
+}
+
+static void Targets(const float *scores, float *target) {
+    float top = -TRAIN_SCORE_CLAMP;
+    for (int o = 0; o < POLICY_OUTPUTS; o++) top = fmaxf(top, fminf(scores[o], TRAIN_SCORE_CLAMP));
+    float sum = 0.0f;
+    for (int o = 0; o < POLICY_OUTPUTS; o++) {
+        float s = fmaxf(fminf(scores[o], TRAIN_SCORE_CLAMP), -TRAIN_SCORE_CLAMP);
+        target[o] = expf((s - top) / TRAIN_TEMPERATURE);
+        sum += target[o];
+    }
+    for (int o = 0; o < POLICY_OUTPUTS; o++) target[o] /= sum;
+}
+
+static void Train(Network *net, const Dataset *data, int epochs) {
+    int samples = data->count * 4;     // every position in all four mirrorings
+    int *order = malloc(sizeof(int) * samples);
+    for (int i = 0; i < samples; i++) order[i] = i;
+    float features[POLICY_INPUTS], scores[POLICY_OUTPUTS], target[POLICY_OUTPUTS];
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        for (int i = samples - 1; i > 0; i--) {
+            int j = (int)(RandomNext(&rngState) % (unsigned int)(i + 1));
+            int t = order[i]; order[i] = order[j]; order[j] = t;
+        }
+        double start = NowSeconds();
+        float loss = 0.0f;
+        int top1 = 0;
+        for (int s = 0; s < samples; s++) {
+            int n = order[s] / 4;
+            Mirror(data->features[n], data->scores[n], order[s] % 4, features, scores);
+            Targets(scores, target);
+            const float *logits = NetworkForward(net, features);
+            if (BestIndex(logits) == BestIndex(scores)) top1++;
+            loss += NetworkBackward(net, target);
+            if ((s + 1) % TRAIN_BATCH == 0 || s + 1 == samples) NetworkUpdate(net, (s % TRAIN_BATCH) + 1);
+        }
+        fprintf(stderr, "  epoch %3d: loss %.3f, top-1 %.1f%%, %.1f s\n",
+                epoch, loss / samples, 100.0 * top1 / samples, NowSeconds() - start);
+    }
+    free(order);
+}
+
+// --- Quantizing and writing ---
+
+static size_t AlignUp(size_t n) {
+    return (n + POLICY_ALIGN - 1) / POLICY_ALIGN * POLICY_ALIGN;
+}
+
+// Weights get a step per output row; each hidden layer's activations one
+// step, from the largest value seen over the training positions
+static bool WriteModel(Network *net, const Dataset *data, const char *path) {
+    float activationMax[TRAIN_LAYERS] = { 1.0f };
+    for (int n = 0; n < data->count; n++) {
+        NetworkForward(net, data->features[n]);
+        for (int l = 1; l < TRAIN_LAYERS; l++) {
+            for (int i = 0; i < layerWidths[l]; i++) activationMax[l] = fmaxf(activationMax[l], net->act[l][i]);
+        }
+    }
+
+    PolicyHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "POOLMLP1", 8);
+    h.version = POLICY_VERSION;
+    h.specHash = TableSpecHash();
+    h.layerCount = TRAIN_LAYERS;
+    h.samples = (unsigned int)data->count;
+    size_t offset = AlignUp(sizeof(h));
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        PolicyLayerInfo *info = &h.layers[l];
+        info->inputs = (unsigned int)AlignUp(layerWidths[l]);
+        info->outputs = (unsigned int)layerWidths[l + 1];
+        info->relu = l + 1 < TRAIN_LAYERS;
+        info->inputScale = (activationMax[l] > 0.0f ? activationMax[l] : 1.0f) / 127.0f;
+        info->offset = offset;
+        offset = AlignUp(offset + (size_t)info->outputs * (2 * sizeof(float) + info->inputs));
+    }
+
+    char *blob = calloc(1, offset);
+    if (!blob) return false;
+    memcpy(blob, &h, sizeof(h));
+    for (int l = 0; l < TRAIN_LAYERS; l++) {
+        const PolicyLayerInfo *info = &h.layers[l];
+        const Dense *d = &net->layers[l];
+        float *scales = (float *)(blob + info->offset);
+        float *bias = scales + info->outputs;
+        signed char *weights = (signed char *)(bias + info->outputs);
+        for (int o = 0; o < d->outputs; o++) {
+            const float *w = d->w + (size_t)o * d->inputs;
+            float top = 0.0f;
+            for (int i = 0; i < d->inputs; i++) top = fmaxf(top, fabsf(w[i]));
+            float step = top > 0.0f ? top / 127.0f : 1.0f;
+            signed char *row = weights + (size_t)o * info->inputs;
+            for (int i = 0; i < d->inputs; i++) row[i] = (signed char)lroundf(w[i] / step);
+            scales[o] = step * info->inputScale;
+            bias[o] = d->b[o];
+        }
+    }
+
+    char temp[520];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *f = fopen(temp, "wb");
+    bool ok = f && fwrite(blob, offset, 1, f) == 1;
+    if (f && fclose(f) != 0) ok = false;
+    ok = ok && FileReplace(temp, path);
+    if (!ok) remove(temp);
+    free(blob);
+    if (ok) printf("wrote %s: %zu bytes, %d positions\n", path, offset, data->count);
+    return ok;
+}
+
+// How often quantizing moved the favourite, over the training positions
+static void CompareQuantized(Network *net, const Dataset *data, const char *path) {
+    PolicyModel model;
+    if (!PolicyOpen(&model, path)) return;
+    float logits[POLICY_OUTPUTS];
+    int same = 0;
+    for (int n = 0; n < data->count; n++) {
+        PolicyForward(&model, data->features[n], logits);
+        if (BestIndex(logits) == BestIndex(NetworkForward(net, data->features[n]))) same++;
+    }
+    printf("int8 and float agree on the favourite in %.1f%% of %d positions\n", 100.0 * same / data->count, data->count);
+    PolicyClose(&model);
+}
+
+static int TrainMain(const char *path, int positions, int epochs) {
+    Dataset data;
+    fprintf(stderr, "labelling %d self-play positions (%d grid shots each) on %d threads\n",
+            positions, POLICY_OUTPUTS, JobsThreadCount());
+    if (!Generate(&data, positions, 0x9E3779B97F4A7C15ull)) return 1;
+
+    static Network net;
+    NetworkInit(&net);
+    fprintf(stderr, "training %d-%d-%d-%d for %d epochs\n",
+            layerWidths[0], layerWidths[1], layerWidths[2], layerWidths[3], epochs);
+    Train(&net, &data, epochs);
+
+    bool ok = WriteModel(&net, &data, path);
+    if (ok) CompareQuantized(&net, &data, path);
+    NetworkFree(&net);
+    FreeDataset(&data);
+    return ok ? 0 : 1;
+}
+
+// --- Evaluating ---
+
+static int CompareScores(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Fresh positions: the full search's best against the policy's favourite
+// and against the best of its verified short list
+static int EvalMain(const char *path, int positions) {
+    PolicyModel model;
+    if (!PolicyOpen(&model, path)) {
+        fprintf(stderr, "policy: cannot load %s\n", path);
+        return 1;
+    }
+    if (!PolicyLoadDefault(path)) {
+        fprintf(stderr, "policy: cannot load %s\n", path);
+        PolicyClose(&model);
+        return 1;
+    }
+    Dataset data = { 0 };
+    fprintf(stderr, "labelling %d evaluation positions\n", positions);
+    double *micros = malloc(sizeof(double) * positions);
+    if (!micros || !Generate(&data, positions, 0xD1B54A32D192ED03ull)) {
+        free(micros);
+        FreeDataset(&data);
+        PolicyClose(&model);
+        return 1;
+    }
+    int inList = 0, topMatch = 0, fullPots = 0, topPots = 0, listPots = 0;
+    double fullScore = 0.0, topScore = 0.0, listScore = 0.0, verifySeconds = 0.0;
+    for (int n = 0; n < data.count; n++) {
+        const Game *game = &data.games[n];
+        PolicyShot shots[POLICY_SHORTLIST];
+        double start = NowSeconds();
+        int count = PolicyShortlist(&model, game, shots, POLICY_SHORTLIST);
+        micros[n] = (NowSeconds() - start) * 1e6;
+
+        // The whole decision as the computer player makes it, simulations included
+        ShotChoice choice;
+        SearchStats stats = { 0 };
+        SearchShotPolicy(game, &choice, &stats);
+        verifySeconds += stats.seconds;
+
+        const float *scores = data.scores[n];
+        int best = BestIndex(scores);
+        float listBest = scores[shots[0].index];
+        for (int k = 0; k < count; k++) {
+            if (shots[k].index == best) inList++;
+            listBest = fmaxf(listBest, scores[shots[k].index]);
+        }
+        if (shots[0].index == best) topMatch++;
+        fullScore += scores[best];
+        topScore += scores[shots[0].index];
+        listScore += listBest;
+        fullPots += scores[best] > 0.0f;
+        topPots += scores[shots[0].index] > 0.0f;
+        listPots += listBest > 0.0f;
+    }
+
+    qsort(micros, positions, sizeof(double), CompareScores);
+    double sum = 0.0;
+    for (int n = 0; n < positions; n++) sum += micros[n];
+    printf("policy %s: %u training positions, %s kernel\n", path, model.header->samples, PolicyKernelName());
+    printf("decision: mean %.1f us, median %.1f us, p99 %.1f us, max %.1f us\n",
+           sum / positions, micros[positions / 2], micros[positions * 99 / 100], micros[positions - 1]);
+    printf("with the short list simulated: mean %.2f ms\n", verifySeconds * 1000.0 / positions);
+    printf("search's best shot is the favourite in %.1f%%, in the top %d in %.1f%%\n",
+           100.0 * topMatch / positions, POLICY_SHORTLIST, 100.0 * inList / positions);
+    printf("%-22s %10s %10s\n", "", "mean score", "clean pot");
+    printf("%-22s %10.2f %9.1f%%\n", "full search", fullScore / positions, 100.0 * fullPots / positions);
+    printf("%-22s %10.2f %9.1f%%\n", "policy favourite", topScore / positions, 100.0 * topPots / positions);
+    printf("%-22s %10.2f %9.1f%%\n", "policy short list", listScore / positions, 100.0 * listPots / positions);
+
+    free(micros);
+    FreeDataset(&data);
+    PolicyClose(&model);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *mode = argc > 1 ? argv[1] : "";
+    const char *path = argc > 2 ? argv[2] : POLICY_PATH;
+    JobsInit(0);
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+
+    int result = 2;
+    if (strcmp(mode, "train") == 0) {
+        result = TrainMain(path, argc > 3 ? atoi(argv[3]) : 2000, argc > 4 ? atoi(argv[4]) : 20);
+    } else if (strcmp(mode, "eval") == 0) {
+        int positions = argc > 3 ? atoi(argv[3]) : 200;
+        result = EvalMain(path, positions > 0 ? positions : 1);
+    } else {
+        fprintf(stderr, "usage: %s train [out.bin] [positions] [epochs] | eval [weights.bin] [positions]\n", argv[0]);
+    }
+    ShotCacheShutdown();
+    JobsShutdown();
+    return result;
+}
@@ -0,0 +1,289 @@
+// Unattended soak runs: whole games driven by an input script at uncapped
+// speed, with no window, reporting frame times and memory as they go.
+//
+//   pool_soak record <script> [shots] [policy.bin] [layouts.bin]
+//                                         write a self-play script; the computer aims every shot,
+//                                         from a solved layout's pot or the policy's short list
+//                                         when given ("-" skips the policy)
+//   pool_soak run <script> [minutes]      loop the script, printing stats every minute (0: one pass)
+
+#include "common.h"
+#include "game.h"
+#include "input.h"
+#include "script.h"
+#include "utils.h"
+#include "jobs.h"
+#include "ai.h"
+#include "policy.h"
+#include "layouts.h"
+#include "cache.h"
+#include "odds.h"
+#include "rewind.h"
+#include "procmem.h"
+
+#define SOAK_REPORT_SECONDS 60.0
+#define SOAK_HITCH_SECONDS 0.001        // frames slower than this are counted separately
+
+// --- Recording a self-play script ---
+
+typedef struct {
+    Game game;
+    ScriptRecorder recorder;
+    InputFrame input;       // carries the mouse between frames
+    long frames;
+} Driver;
+
+static void Feed(Driver *d) {
+    d->input.time = NowSeconds();
+    ScriptRecorderAdd(&d->recorder, &d->input);
+    UpdateGame(&d->game, &d->input);
+    d->frames++;
+
+    // Edges last one frame; the mouse position and button stay
+    bool down = d->input.mouseDown;
+    Vector2 mouse = d->input.mouse;
+    memset(&d->input, 0, sizeof(d->input));
+    d->input.mouseDown = down;
+    d->input.mouse = mouse;
+}
+
+static void WaitForRest(Driver *d) {
+    while ((d->game.shotPending || d->game.ballsMoving) &&
+           d->game.state != GAME_WON && d->game.state != GAME_LOST) {
+        Feed(d);
+    }
+}
+
+static void Click(Driver *d, Vector2 at) {
+    d->input.mouse = at;
+    d->input.mousePressed = true;
+    d->input.mouseDown = true;
+    Feed(d);
+    d->input.mouseReleased = true;
+    d->input.mouseDown = false;
+    Feed(d);
+}
+
+// Press on the cue ball, pull back to the point that GetAim turns into the
+// chosen shot, release
+static void Strike(Driver *d, float angle, float speed) {
+    Vector2 cue = d->game.balls[0].position;
+    float pull = speed / MAX_SHOT_SPEED * MAX_POWER_PIXELS;
+
+    d->input.mouse = cue;
+    d->input.mousePressed = true;
+    d->input.mouseDown = true;
+    Feed(d);
+    d->input.mouse = (Vector2){ cue.x + cosf(angle) * pull, cue.y + sinf(angle) * pull };
+    Feed(d);
+    d->input.mouseReleased = true;
+    d->input.mouseDown = false;
+    Feed(d);
+}
+
+// Besides plain shots the script exercises the other inputs: every 5th shot
+// is scrubbed back and resumed mid-flight, every 7th is undone and replayed
+static int Record(const char *path, int shots, const char *policyPath, const char *layoutsPath) {
+    static Driver d;
+    InitGame(&d.game);
+    if (!ScriptRecorderOpen(&d.recorder, path)) {
+        fprintf(stderr, "soak: cannot write %s\n", path);
+        return 1;
+    }
+    JobsInit(JobsCoreCount());
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+    RewindInit((size_t)REWIND_BUDGET_MB * 1024 * 1024);
+    if (policyPath && strcmp(policyPath, "-") != 0 && !PolicyLoadDefault(policyPath)) {
+        fprintf(stderr, "soak: cannot load policy %s; searching every shot\n", policyPath);
+    }
+    if (layoutsPath && !LayoutIndexLoadDefault(layoutsPath)) {
+        fprintf(stderr, "soak: cannot load layouts %s\n", layoutsPath);
+    }
+
+    int games = 1;
+    for (int shot = 1; shot <= shots; shot++) {
+        if (d.game.state == GAME_WON || d.game.state == GAME_LOST) {
+            d.input.keyReset = true;
+            Feed(&d);
+            games++;
+        }
+        if (d.game.state == GAME_SCRATCH) {
+            Vector2 spot;
+            if (!ChooseCuePlacement(&d.game, &spot, NULL)) spot = d.game.cueBallPos;
+            Click(&d, spot);
+        }
+
+        // A solved layout's shot or the policy's best only if it pots here; otherwise the grid
+        ShotChoice choice;
+        bool found = d.game.state != GAME_SCRATCH && SearchShotLayouts(&d.game, &choice, NULL) && choice.score > 0.0f;
+        if (!found && d.game.state != GAME_SCRATCH) {
+            found = SearchShotPolicy(&d.game, &choice, NULL) && choice.score > 0.0f;
+        }
+        if (!found && d.game.state != GAME_SCRATCH) found = SearchShot(&d.game, &choice, NULL);
+        if (!found) {
+            d.input.keyReset = true;
+            Feed(&d);
+            games++;
+            continue;
+        }
+        Strike(&d, choice.angle, choice.speed);
+
+        if (shot % 5 == 0) {
+            WaitForRest(&d);
+            d.input.scrubFrames = -40;
+            Feed(&d);
+            d.input.scrubFrames = 15;
+            Feed(&d);
+            d.input.keyResume = true;
+            Feed(&d);
+        }
+        WaitForRest(&d);
+
+        if (shot % 7 == 0 && d.game.state != GAME_WON && d.game.state != GAME_LOST) {
+            d.input.keyUndo = true;
+            Feed(&d);
+            Strike(&d, choice.angle, choice.speed);
+            WaitForRest(&d);
+        }
+    }
+    ScriptRecorderClose(&d.recorder);
+
+    printf("recorded %d shots over %d games in %ld frames to %s\n", shots, games, d.frames, path);
+    RewindShutdown();
+    ShotCacheShutdown();
+    JobsShutdown();
+    return 0;
+}
+
+// --- Soak run ---
+
+typedef struct {
+    long frames;
+    long hitches;
+    long games;
+    long shots;
+} SoakCounts;
+
+static void PrintMemory(const char *label, size_t resident, size_t peak) {
+    printf("%s: rss %.1f MiB, peak %.1f MiB\n", label, resident / 1048576.0, peak / 1048576.0);
+}
+
+static void PrintProgress(double elapsed, const SoakCounts *total, const SoakCounts *interval,
+                          const FrameStats *stats, double intervalSeconds) {
+    size_t resident = 0, peak = 0;
+    ProcessMemory(&resident, &peak);
+    printf("%7.1f min: %ld frames (%.0f fps), %ld games, %ld shots, mean %.1f us, max %.2f ms, "
+           "%ld over 1 ms, rss %.1f MiB\n",
+           elapsed / 60.0, total->frames, interval->frames / intervalSeconds, total->games, total->shots,
+           stats->count ? stats->sum / stats->count * 1e6 : 0.0, stats->max * 1000.0,
+           interval->hitches, resident / 1048576.0);
+    fflush(stdout);
+}
+
+static int Run(const char *path, double minutes) {
+    InputProvider input;
+    if (!ScriptInputOpen(&input, path, minutes > 0.0)) {
+        fprintf(stderr, "soak: cannot read script %s\n", path);
+        return 1;
+    }
+
+    // The same background work as a windowed game, minus the window
+    int cores = JobsCoreCount();
+    JobsInit(cores > 2 ? cores - 2 : 1);
+    ShotCacheInit(SHOT_CACHE_SLOTS_LOG2);
+    ShotOddsStart();
+    RewindInit((size_t)REWIND_BUDGET_MB * 1024 * 1024);
+
+    static Game game;
+    InitGame(&game);
+
+    size_t startResident = 0, startPeak = 0;
+    ProcessMemory(&startResident, &startPeak);
+    PrintMemory("start", startResident, startPeak);
+
+    FrameStats total, interval;
+    FrameStatsReset(&total);
+    FrameStatsReset(&interval);
+    SoakCounts counts = { 0 }, intervalCounts = { 0 };
+
+    // Caches and the rewind pool fill during the first minute; growth after
+    // that is what points at a leak
+    size_t baselineResident = 0;
+    double baselineTime = 0.0;
+
+    double start = NowSeconds();
+    double lastReport = start;
+    double end = start + minutes * 60.0;
+    InputFrame frame;
+    while (input.poll(&input, &frame)) {
+        bool wasPending = game.shotPending;
+
+        double before = NowSeconds();
+        UpdateGame(&game, &frame);
+        ShotOddsAim(&game);
+        double after = NowSeconds();
+
+        double seconds = after - before;
+        FrameStatsAdd(&total, seconds);
+        FrameStatsAdd(&interval, seconds);
+        counts.frames++;
+        intervalCounts.frames++;
+        if (seconds > SOAK_HITCH_SECONDS) {
+            counts.hitches++;
+            intervalCounts.hitches++;
+        }
+        if (frame.keyReset) counts.games++;
+        if (!wasPending && game.shotPending && !game.scrubbing) counts.shots++;
+
+        if (after - lastReport >= SOAK_REPORT_SECONDS) {
+            PrintProgress(after - start, &counts, &intervalCounts, &interval, after - lastReport);
+            if (baselineTime == 0.0) {
+                size_t baselinePeak;
+                ProcessMemory(&baselineResident, &baselinePeak);
+                baselineTime = after;
+            }
+            FrameStatsReset(&interval);
+            memset(&intervalCounts, 0, sizeof(intervalCounts));
+            lastReport = after;
+        }
+        if (minutes > 0.0 && after >= end) break;
+    }
+    double elapsed = NowSeconds() - start;
+    input.close(&input);
+
+    printf("soak: %ld frames in %.1f s (%.0f fps), %ld games, %ld shots, %ld frames over 1 ms\n",
+           counts.frames, elapsed, counts.frames / elapsed, counts.games, counts.shots, counts.hitches);
+    FrameStatsPrint(&total, "update time");
+
+    size_t resident = 0, peak = 0;
+    ProcessMemory(&resident, &peak);
+    PrintMemory("end", resident, peak);
+    printf("rss growth: %+.1f KiB since start", ((double)resident - (double)startResident) / 1024.0);
+    if (baselineTime > 0.0 && start + elapsed > baselineTime) {
+        double growth = ((double)resident - (double)baselineResident) / 1024.0;
+        printf(", %+.1f KiB after the first minute (%+.1f KiB per hour)",
+               growth, growth * 3600.0 / (start + elapsed - baselineTime));
+    }
+    printf("\n");
+
+    RewindPrintReport(stdout);
+    RewindShutdown();
+    ShotOddsStop();
+    ShotCachePrintReport(stdout);
+    ShotCacheShutdown();
+    JobsShutdown();
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *mode = argc > 1 ? argv[1] : "";
+
+    if (strcmp(mode, "record") == 0 && argc > 2) {
+        return Record(argv[2], argc > 3 ? atoi(argv[3]) : 50, argc > 4 ? argv[4] : NULL, argc > 5 ? argv[5] : NULL);
+    }
+    if (strcmp(mode, "run") == 0 && argc > 2) {
+        return Run(argv[2], argc > 3 ? atof(argv[3]) : 1.0);
+    }
+    fprintf(stderr, "usage: %s record <script> [shots] [policy.bin] [layouts.bin] | run <script> [minutes]\n", argv[0]);
+    return 1;
+}
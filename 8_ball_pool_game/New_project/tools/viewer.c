@@ -0,0 +1,99 @@
+// Spectator viewer: plays a table stream with the game's own drawing code.
+//
+//   pool_viewer <file | - | "|command">
+//
+// A reader thread decodes records into a queue of frames; the window shows
+// one queued frame per tick and holds the last one while the stream is idle,
+// so both recorded files and live pipes play at the source's pace.
+
+#include "common.h"
+#include "graphics.h"
+#include "stream.h"
+#include <pthread.h>
+
+#define VIEWER_QUEUE 256
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t space;
+    Game frames[VIEWER_QUEUE];
+    int head;
+    int count;
+    bool ended;
+} queue;
+
+static void *ReaderThread(void *arg) {
+    StreamReader *reader = arg;
+    StreamRecord type;
+    int frames;
+
+    while ((frames = StreamReadRecord(reader, &type)) >= 0) {
+        for (int k = 0; k < frames; k++) {
+            pthread_mutex_lock(&queue.lock);
+            while (queue.count == VIEWER_QUEUE) pthread_cond_wait(&queue.space, &queue.lock);
+            queue.frames[(queue.head + queue.count) % VIEWER_QUEUE] = reader->game;
+            queue.count++;
+            pthread_mutex_unlock(&queue.lock);
+        }
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    queue.ended = true;
+    pthread_mutex_unlock(&queue.lock);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file | - | \"|command\">\n", argv[0]);
+        return 1;
+    }
+
+    static StreamReader reader;
+    if (!StreamReaderOpen(&reader, argv[1])) {
+        fprintf(stderr, "viewer: %s is not a table stream\n", argv[1]);
+        return 1;
+    }
+
+    // The table as opened, copied before the reader thread starts writing it;
+    // after that only the queue hands frames over
+    static Game current;
+    current = reader.game;
+
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.space, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, ReaderThread, &reader);
+    pthread_detach(thread);
+
+    InitWindow(TABLE_WIDTH, TABLE_HEIGHT + 100, "8 Ball Pool - Spectator");
+    SetTargetFPS(TARGET_FPS);
+
+    bool ended = false;
+
+    while (!WindowShouldClose()) {
+        pthread_mutex_lock(&queue.lock);
+        if (queue.count > 0) {
+            current = queue.frames[queue.head];
+            queue.head = (queue.head + 1) % VIEWER_QUEUE;
+            queue.count--;
+            pthread_cond_signal(&queue.space);
+        }
+        ended = queue.ended && queue.count == 0;
+        pthread_mutex_unlock(&queue.lock);
+
+        BeginDrawing();
+        ClearBackground((Color){8, 80, 23, 255});
+        DrawTable();
+        DrawPockets();
+        DrawBalls(&current);
+        DrawHUD(&current);
+        DrawOverlays(&current);
+        DrawText(ended ? "END OF STREAM" : "LIVE", TABLE_WIDTH - 130, TABLE_HEIGHT + 70, 16,
+                 ended ? LIGHTGRAY : RED);
+        EndDrawing();
+    }
+
+    CloseWindow();
+    return 0;
+}